@@ -0,0 +1,61 @@
+#include "ad_parser.h"
+
+#include <string.h>
+
+static void set_first(ad_view_t *view, const uint8_t *data, uint8_t len) {
+  if (view->data == NULL) {
+    view->data = data;
+    view->len = len;
+  }
+}
+
+bool ad_parse(const uint8_t *data, size_t len, ad_fields_t *fields) {
+  memset(fields, 0, sizeof(*fields));
+
+  size_t pos = 0;
+  while (pos < len) {
+    uint8_t field_len = data[pos];
+    if (field_len == 0) {
+      // 剩余部分为填充
+      return true;
+    }
+    if (field_len > len - pos - 1) {
+      return false;
+    }
+    const uint8_t *value = &data[pos + 2];
+    uint8_t value_len = field_len - 1;
+    switch (data[pos + 1]) {
+      case AD_TYPE_UUID16_INCMPL:
+        set_first(&fields->uuid16_incmpl, value, value_len);
+        break;
+      case AD_TYPE_UUID16_CMPL:
+        set_first(&fields->uuid16_cmpl, value, value_len);
+        break;
+      case AD_TYPE_UUID32_INCMPL:
+        set_first(&fields->uuid32_incmpl, value, value_len);
+        break;
+      case AD_TYPE_UUID32_CMPL:
+        set_first(&fields->uuid32_cmpl, value, value_len);
+        break;
+      case AD_TYPE_UUID128_INCMPL:
+        set_first(&fields->uuid128_incmpl, value, value_len);
+        break;
+      case AD_TYPE_UUID128_CMPL:
+        set_first(&fields->uuid128_cmpl, value, value_len);
+        break;
+      case AD_TYPE_NAME_SHORT:
+        set_first(&fields->name_short, value, value_len);
+        break;
+      case AD_TYPE_NAME_CMPL:
+        set_first(&fields->name_cmpl, value, value_len);
+        break;
+      case AD_TYPE_APPEARANCE:
+        set_first(&fields->appearance, value, value_len);
+        break;
+      default:
+        break;
+    }
+    pos += field_len + 1;
+  }
+  return true;
+}
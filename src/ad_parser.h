@@ -0,0 +1,56 @@
+#ifndef AD_PARSER_H
+#define AD_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// BLE 广播数据 (AD) 和经典蓝牙 EIR 解析：两者格式相同，
+// 都是连续的 {u8 长度, u8 类型, 数据[长度 - 1]} 结构，长度为 0 表示结束
+// 一次遍历取出所有关心的字段，结果指向原始数据，不复制
+
+// 字段类型，AD 和 EIR 共用同一套编号
+#define AD_TYPE_UUID16_INCMPL 0x02
+#define AD_TYPE_UUID16_CMPL 0x03
+#define AD_TYPE_UUID32_INCMPL 0x04
+#define AD_TYPE_UUID32_CMPL 0x05
+#define AD_TYPE_UUID128_INCMPL 0x06
+#define AD_TYPE_UUID128_CMPL 0x07
+#define AD_TYPE_NAME_SHORT 0x08
+#define AD_TYPE_NAME_CMPL 0x09
+#define AD_TYPE_APPEARANCE 0x19
+
+// 指向原始数据中的一个字段，未出现时 data 为 NULL、len 为 0
+typedef struct {
+  const uint8_t *data;
+  uint8_t len;
+} ad_view_t;
+
+// 每种类型只取第一次出现的字段，与 esp_ble_resolve_adv_data 一致
+typedef struct {
+  ad_view_t uuid16_incmpl;
+  ad_view_t uuid16_cmpl;
+  ad_view_t uuid32_incmpl;
+  ad_view_t uuid32_cmpl;
+  ad_view_t uuid128_incmpl;
+  ad_view_t uuid128_cmpl;
+  ad_view_t name_short;
+  ad_view_t name_cmpl;
+  ad_view_t appearance;
+} ad_fields_t;
+
+// 解析 len 字节的数据，不会读取范围之外的字节
+// 返回 false 表示最后一个结构的长度超出数据范围，之前的字段仍然有效
+bool ad_parse(const uint8_t *data, size_t len, ad_fields_t *fields);
+
+// 完整列表优先，没有时取不完整列表 (名字同理)
+static inline ad_view_t ad_pick(ad_view_t complete, ad_view_t incomplete) {
+  return complete.data != NULL ? complete : incomplete;
+}
+
+// 小端 16 位字段，长度不足时返回 0
+static inline uint16_t ad_u16(ad_view_t view) {
+  return view.len >= 2 ? (uint16_t)(view.data[0] | (view.data[1] << 8)) : 0;
+}
+
+#endif /* AD_PARSER_H */
@@ -0,0 +1,146 @@
+#include "ble_conn_params.h"
+
+#include <string.h>
+
+#include "conn_policy.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "CONN_PARAMS";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static conn_policy_t s_policy;
+static esp_bd_addr_t s_peer;
+static esp_timer_handle_t s_timer = NULL;
+
+// 在锁外发出请求，并按策略的下一个时间点重新设置定时器
+static void apply(bool need_request, const conn_params_t *request) {
+  esp_ble_conn_update_params_t params;
+  int64_t now = esp_timer_get_time();
+
+  portENTER_CRITICAL(&s_lock);
+  int64_t deadline = conn_policy_next_deadline(&s_policy, now);
+  memcpy(params.bda, s_peer, sizeof(params.bda));
+  portEXIT_CRITICAL(&s_lock);
+
+  if (need_request) {
+    params.min_int = request->min_int;
+    params.max_int = request->max_int;
+    params.latency = request->latency;
+    params.timeout = request->timeout;
+    ESP_LOGI(TAG, "request interval %u~%u latency %u", params.min_int,
+             params.max_int, params.latency);
+    esp_err_t err = esp_ble_gap_update_conn_params(&params);
+    if (err != ESP_OK) {
+      ESP_LOGW(TAG, "update_conn_params failed: %d", err);
+    }
+  }
+
+  esp_timer_stop(s_timer);
+  if (deadline > 0) {
+    esp_timer_start_once(s_timer, deadline > now ? deadline - now : 1);
+  }
+}
+
+static void timer_cb(void *arg) {
+  conn_params_t request;
+
+  portENTER_CRITICAL(&s_lock);
+  bool need = conn_policy_poll(&s_policy, esp_timer_get_time(), &request);
+  portEXIT_CRITICAL(&s_lock);
+  apply(need, &request);
+}
+
+void ble_conn_params_init(void) {
+  conn_policy_init(&s_policy, CONN_PARAMS_IDLE_TIMEOUT_MS * 1000LL);
+  if (s_timer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "conn_params",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+  }
+}
+
+void ble_conn_params_gap_event(esp_gap_ble_cb_event_t event,
+                               esp_ble_gap_cb_param_t *param) {
+  conn_params_t request;
+
+  if (event != ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT) {
+    return;
+  }
+  bool success = param->update_conn_params.status == ESP_BT_STATUS_SUCCESS;
+  ESP_LOGI(TAG, "update %s: interval %u latency %u timeout %u",
+           success ? "ok" : "rejected", param->update_conn_params.conn_int,
+           param->update_conn_params.latency,
+           param->update_conn_params.timeout);
+
+  portENTER_CRITICAL(&s_lock);
+  bool need = conn_policy_updated(
+      &s_policy, esp_timer_get_time(), success,
+      param->update_conn_params.conn_int, param->update_conn_params.latency,
+      param->update_conn_params.timeout, &request);
+  portEXIT_CRITICAL(&s_lock);
+  apply(need, &request);
+}
+
+void ble_conn_params_gatts_event(esp_gatts_cb_event_t event,
+                                 esp_ble_gatts_cb_param_t *param) {
+  conn_params_t request;
+  bool need = false;
+
+  if (event == ESP_GATTS_CONNECT_EVT) {
+    portENTER_CRITICAL(&s_lock);
+    if (!s_policy.connected ||
+        memcmp(s_peer, param->connect.remote_bda, sizeof(s_peer)) != 0) {
+      memcpy(s_peer, param->connect.remote_bda, sizeof(s_peer));
+      need = conn_policy_connected(&s_policy, esp_timer_get_time(),
+                                   param->connect.conn_params.interval,
+                                   param->connect.conn_params.latency,
+                                   param->connect.conn_params.timeout,
+                                   &request);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    apply(need, &request);
+  } else if (event == ESP_GATTS_DISCONNECT_EVT) {
+    portENTER_CRITICAL(&s_lock);
+    conn_policy_disconnected(&s_policy);
+    portEXIT_CRITICAL(&s_lock);
+    esp_timer_stop(s_timer);
+  }
+}
+
+void ble_conn_params_activity(int64_t now_us) {
+  conn_params_t request;
+
+  portENTER_CRITICAL(&s_lock);
+  bool was_slow = s_policy.settled == CONN_POLICY_SLOW;
+  bool need = conn_policy_activity(&s_policy, now_us, &request);
+  portEXIT_CRITICAL(&s_lock);
+  // 快速模式下只更新时间，空闲定时器到期时再按最新的活动时间重新计算
+  if (need || was_slow) {
+    apply(need, &request);
+  }
+}
+
+uint32_t ble_conn_params_interval_us(void) {
+  portENTER_CRITICAL(&s_lock);
+  uint32_t interval = s_policy.connected ? s_policy.interval * 1250u : 0;
+  portEXIT_CRITICAL(&s_lock);
+  return interval;
+}
+
+void ble_conn_params_set_preferred(const conn_params_t *fast) {
+  portENTER_CRITICAL(&s_lock);
+  conn_policy_set_fast(&s_policy, fast);
+  portEXIT_CRITICAL(&s_lock);
+}
+
+bool ble_conn_params_accepted(conn_params_t *fast) {
+  portENTER_CRITICAL(&s_lock);
+  *fast = s_policy.accepted;
+  portEXIT_CRITICAL(&s_lock);
+  return fast->min_int != 0;
+}
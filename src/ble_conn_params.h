@@ -0,0 +1,39 @@
+#ifndef BLE_CONN_PARAMS_H
+#define BLE_CONN_PARAMS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "conn_policy.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+
+// 最后一次按键之后多久切换到空闲连接参数 (ms)
+#ifndef CONN_PARAMS_IDLE_TIMEOUT_MS
+#define CONN_PARAMS_IDLE_TIMEOUT_MS 5000
+#endif
+
+// 初始化连接参数管理，策略见 conn_policy.h
+void ble_conn_params_init(void);
+
+// GAP 事件，处理 ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT
+void ble_conn_params_gap_event(esp_gap_ble_cb_event_t event,
+                               esp_ble_gap_cb_param_t *param);
+
+// GATTS 事件，处理连接建立和断开；每个 GATTS 应用都会收到，重复的事件被忽略
+void ble_conn_params_gatts_event(esp_gatts_cb_event_t event,
+                                 esp_ble_gatts_cb_param_t *param);
+
+// 有按键活动，在发送任务中调用
+void ble_conn_params_activity(int64_t now_us);
+
+// 当前连接间隔 (us)，未连接时返回 0
+uint32_t ble_conn_params_interval_us(void);
+
+// 连接后请求的快速参数，NULL 恢复默认值；切换主机时按主机设置
+void ble_conn_params_set_preferred(const conn_params_t *fast);
+
+// 本次连接中主机接受的快速参数，还没有时返回 false
+bool ble_conn_params_accepted(conn_params_t *fast);
+
+#endif /* BLE_CONN_PARAMS_H */
@@ -0,0 +1,301 @@
+#include "ble_hid_tx.h"
+
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "key_trace.h"
+
+_Static_assert((BLE_HID_TX_MAX_IN_FLIGHT & (BLE_HID_TX_MAX_IN_FLIGHT - 1)) ==
+                   0,
+               "BLE_HID_TX_MAX_IN_FLIGHT must be a power of two");
+
+static const char *TAG = "BLE_HID_TX";
+
+#define CONF_TIMEOUT_US (BLE_HID_TX_CONF_TIMEOUT_MS * 1000LL)
+
+// 登记的 HID 服务数上限，esp_hidd 为每个报告描述符创建一个服务
+#define HID_SERVICE_MAX 4
+
+// 在途的通知，CONF 事件按发送顺序返回
+typedef struct {
+  int64_t sent_us;
+  uint8_t report_id;
+} in_flight_t;
+
+// 一个 HID 服务的属性句柄范围
+typedef struct {
+  uint16_t start;
+  uint16_t end;
+} handle_range_t;
+
+// 以下状态在发送任务和 BTC 任务之间共享
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static in_flight_t s_in_flight[BLE_HID_TX_MAX_IN_FLIGHT];
+static uint32_t s_head = 0;  // 下一个发送位置
+static uint32_t s_tail = 0;  // 下一个等待 CONF 的位置
+static bool s_congested = false;
+static bool s_waiting = false;  // 有发送被拒绝，可以发送时通知发送任务
+static uint32_t s_lost = 0;
+static TaskHandle_t s_consumer = NULL;
+static esp_timer_handle_t s_conf_timer = NULL;  // 最早的在途通知超时
+
+// HID 服务的句柄范围，只在 BTC 任务中读写
+// esp_hidd 不提供各输入报告的特征句柄，只能按服务范围过滤 CONF，
+// 范围内只有输入报告会发出通知
+static handle_range_t s_hid_services[HID_SERVICE_MAX];
+static uint8_t s_num_hid_services = 0;
+
+static uint32_t s_sent = 0;
+static uint32_t s_refused = 0;
+static uint32_t s_dropped = 0;
+static uint32_t s_timeouts = 0;
+static uint32_t s_retries = 0;
+
+static void reset(void) {
+  portENTER_CRITICAL(&s_lock);
+  s_tail = s_head;
+  s_congested = false;
+  s_waiting = false;
+  s_lost = 0;
+  portEXIT_CRITICAL(&s_lock);
+  if (s_conf_timer != NULL) {
+    esp_timer_stop(s_conf_timer);
+  }
+}
+
+static void notify_consumer(void) {
+  if (s_consumer != NULL) {
+    xTaskNotifyGive(s_consumer);
+  }
+}
+
+// 超时的在途通知 (不论在途多少) 视为丢失并释放位置，在临界区内调用
+// 返回超时的报告，bit n 对应报告 ID n
+static uint32_t expire_locked(int64_t now) {
+  uint32_t expired = 0;
+  while (s_tail != s_head &&
+         now - s_in_flight[s_tail % BLE_HID_TX_MAX_IN_FLIGHT].sent_us >
+             CONF_TIMEOUT_US) {
+    expired |= 1u << s_in_flight[s_tail++ % BLE_HID_TX_MAX_IN_FLIGHT].report_id;
+    s_timeouts++;
+  }
+  s_lost |= expired;
+  return expired;
+}
+
+static void trace_expired(uint32_t expired) {
+  while (expired != 0) {
+    KEY_TRACE(KEY_TRACE_TX_LOST, 0xFF, 0xFF, __builtin_ctz(expired),
+              ESP_ERR_TIMEOUT);
+    expired &= expired - 1;
+  }
+}
+
+// CONF 可能永远不来 (链路异常、协议栈丢弃)，有在途通知时保证最早的一个
+// 超时后唤醒发送任务，由 ble_hid_tx_take_lost 处理超时；只在发送任务中调用
+static void arm_conf_timer(void) {
+  bool in_flight;
+  int64_t deadline = 0;
+
+  portENTER_CRITICAL(&s_lock);
+  in_flight = s_tail != s_head;
+  if (in_flight) {
+    deadline = s_in_flight[s_tail % BLE_HID_TX_MAX_IN_FLIGHT].sent_us +
+               CONF_TIMEOUT_US;
+  }
+  portEXIT_CRITICAL(&s_lock);
+  if (!in_flight || s_conf_timer == NULL ||
+      esp_timer_is_active(s_conf_timer)) {
+    return;
+  }
+  // 到期后才算超时 (严格大于)，多等 1us
+  int64_t wait = deadline - esp_timer_get_time() + 1;
+  esp_timer_start_once(s_conf_timer, wait > 0 ? wait : 1);
+}
+
+static void conf_timer_cb(void *arg) { notify_consumer(); }
+
+static bool is_hid_handle(uint16_t handle) {
+  for (int i = 0; i < s_num_hid_services; i++) {
+    if (handle >= s_hid_services[i].start && handle <= s_hid_services[i].end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void register_service(const struct gatts_add_attr_tab_evt_param *tab) {
+  if (tab->status != ESP_GATT_OK || tab->svc_uuid.len != ESP_UUID_LEN_16 ||
+      tab->svc_uuid.uuid.uuid16 != ESP_GATT_UUID_HID_SVC ||
+      tab->num_handle == 0) {
+    return;
+  }
+  if (s_num_hid_services == HID_SERVICE_MAX) {
+    ESP_LOGW(TAG, "too many HID services, CONF from handle %u ignored",
+             tab->handles[0]);
+    return;
+  }
+  handle_range_t *range = &s_hid_services[s_num_hid_services++];
+  range->start = tab->handles[0];
+  range->end = tab->handles[0] + tab->num_handle - 1;
+}
+
+// 一个通知的 CONF 事件，返回是否需要唤醒发送任务
+static bool handle_conf(uint16_t handle, esp_gatt_status_t status) {
+  bool wake;
+  uint8_t report_id = 0;
+
+  // 其他服务 (电池、延迟统计) 的通知不占用在途位置
+  if (!is_hid_handle(handle)) {
+    return false;
+  }
+  portENTER_CRITICAL(&s_lock);
+  if (s_tail == s_head) {
+    // 不是经过这里发送的通知
+    portEXIT_CRITICAL(&s_lock);
+    return false;
+  }
+  report_id = s_in_flight[s_tail++ % BLE_HID_TX_MAX_IN_FLIGHT].report_id;
+  if (status != ESP_GATT_OK) {
+    s_lost |= 1u << report_id;
+    s_dropped++;
+  }
+  wake = s_waiting || status != ESP_GATT_OK;
+  s_waiting = false;
+  portEXIT_CRITICAL(&s_lock);
+
+  if (status != ESP_GATT_OK) {
+    KEY_TRACE(KEY_TRACE_TX_LOST, 0xFF, 0xFF, report_id, status);
+  }
+  return wake;
+}
+
+void ble_hid_tx_init(TaskHandle_t consumer) {
+  s_consumer = consumer;
+  if (s_conf_timer == NULL) {
+    const esp_timer_create_args_t args = {.callback = conf_timer_cb,
+                                          .name = "hid_tx_conf"};
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_conf_timer));
+  }
+  reset();
+}
+
+void ble_hid_tx_gatts_event(esp_gatts_cb_event_t event,
+                            esp_ble_gatts_cb_param_t *param) {
+  bool wake = false;
+
+  switch (event) {
+    case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+      register_service(&param->add_attr_tab);
+      break;
+    case ESP_GATTS_CONF_EVT:
+      wake = handle_conf(param->conf.handle, param->conf.status);
+      break;
+    case ESP_GATTS_CONGEST_EVT:
+      KEY_TRACE(KEY_TRACE_TX_CONGEST, 0xFF, 0xFF, 0, param->congest.congested);
+      portENTER_CRITICAL(&s_lock);
+      s_congested = param->congest.congested;
+      wake = !s_congested && s_waiting;
+      if (wake) {
+        s_waiting = false;
+      }
+      portEXIT_CRITICAL(&s_lock);
+      break;
+    case ESP_GATTS_CONNECT_EVT:
+    case ESP_GATTS_DISCONNECT_EVT:
+      // 断开后 CONF 不会再来，主机侧的按键已全部释放
+      reset();
+      break;
+    default:
+      break;
+  }
+  if (wake) {
+    notify_consumer();
+  }
+}
+
+esp_err_t ble_hid_tx_send(esp_hidd_dev_t *dev, uint8_t report_id,
+                          uint8_t *data, uint16_t len) {
+  int64_t now = esp_timer_get_time();
+  bool refused = false;
+  uint32_t expired;
+  uint32_t in_flight;
+
+  portENTER_CRITICAL(&s_lock);
+  expired = expire_locked(now);
+  in_flight = s_head - s_tail;
+  if (s_congested || in_flight == BLE_HID_TX_MAX_IN_FLIGHT) {
+    s_lost |= 1u << report_id;
+    s_waiting = true;
+    s_refused++;
+    refused = true;
+  } else {
+    in_flight_t *entry = &s_in_flight[s_head++ % BLE_HID_TX_MAX_IN_FLIGHT];
+    entry->sent_us = now;
+    entry->report_id = report_id;
+  }
+  portEXIT_CRITICAL(&s_lock);
+
+  trace_expired(expired);
+  if (refused) {
+    KEY_TRACE(KEY_TRACE_TX_BUSY, 0xFF, 0xFF, report_id, in_flight);
+    return ESP_ERR_NO_MEM;
+  }
+
+  esp_err_t err = esp_hidd_dev_input_set(dev, 1, report_id, data, len);
+  portENTER_CRITICAL(&s_lock);
+  if (err == ESP_OK) {
+    s_sent++;
+  } else {
+    // 没有交给协议栈，不会有 CONF；只有发送任务写入，收回刚占用的位置
+    s_head--;
+    s_lost |= 1u << report_id;
+    s_waiting = true;
+    s_refused++;
+  }
+  portEXIT_CRITICAL(&s_lock);
+  arm_conf_timer();
+  return err;
+}
+
+uint32_t ble_hid_tx_available(void) {
+  portENTER_CRITICAL(&s_lock);
+  uint32_t available =
+      s_congested ? 0 : BLE_HID_TX_MAX_IN_FLIGHT - (s_head - s_tail);
+  if (available == 0) {
+    s_waiting = true;
+  }
+  portEXIT_CRITICAL(&s_lock);
+  return available;
+}
+
+uint32_t ble_hid_tx_take_lost(void) {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_lock);
+  uint32_t expired = expire_locked(now);
+  uint32_t lost = s_lost;
+  s_lost = 0;
+  if (lost != 0) {
+    s_retries++;
+  }
+  portEXIT_CRITICAL(&s_lock);
+  trace_expired(expired);
+  arm_conf_timer();
+  return lost;
+}
+
+void ble_hid_tx_print(void) {
+  if (s_sent == 0 && s_refused == 0) {
+    return;
+  }
+  ESP_LOGI(TAG,
+           "%" PRIu32 " reports sent, %" PRIu32 " refused, %" PRIu32
+           " dropped, %" PRIu32 " timed out, %" PRIu32 " retries",
+           s_sent, s_refused, s_dropped, s_timeouts, s_retries);
+  s_sent = 0;
+  s_refused = 0;
+  s_dropped = 0;
+  s_timeouts = 0;
+  s_retries = 0;
+}
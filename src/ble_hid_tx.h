@@ -0,0 +1,56 @@
+#ifndef BLE_HID_TX_H
+#define BLE_HID_TX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "esp_hidd.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 输入报告发送流控
+// esp_hidd_dev_input_set 只是把通知交给 BTC 任务，真正的结果在 GATTS CONF
+// 事件中返回，控制器缓冲区满时通知被丢弃，主机侧的按键可能一直按住
+//   在途   已交给协议栈、还没有收到 CONF 的通知数，超过上限时拒绝发送
+//   拥塞   CONGEST 事件指示拥塞期间拒绝发送，解除后通知发送任务
+//   丢失   CONF 失败、超时或发送被拒绝的报告记为丢失，发送任务重新发送
+//          该报告的最新状态，而不是重发旧报告，保证最后的全部释放报告送达
+
+// 在途通知数上限，必须是 2 的幂
+#ifndef BLE_HID_TX_MAX_IN_FLIGHT
+#define BLE_HID_TX_MAX_IN_FLIGHT 8
+#endif
+
+// 在途通知超过此时间 (ms) 没有 CONF 时视为丢失，避免计数泄漏后一直拒绝发送
+// 每次发送和取丢失报告时检查；有在途通知时定时器在最早的一个超时后唤醒发送任务
+#ifndef BLE_HID_TX_CONF_TIMEOUT_MS
+#define BLE_HID_TX_CONF_TIMEOUT_MS 1000
+#endif
+
+// 初始化，可以继续发送或有报告丢失时通知 consumer（发送任务）
+void ble_hid_tx_init(TaskHandle_t consumer);
+
+// GATTS 事件，处理 CONF、CONGEST 以及连接建立和断开
+// CREAT_ATTR_TAB 登记 HID 服务的句柄范围，范围之外的 CONF 不是输入报告，忽略
+void ble_hid_tx_gatts_event(esp_gatts_cb_event_t event,
+                            esp_ble_gatts_cb_param_t *param);
+
+// 发送一个输入报告，拥塞或在途通知已满时返回 ESP_ERR_NO_MEM
+// 失败的报告记为丢失；只在发送任务中调用
+esp_err_t ble_hid_tx_send(esp_hidd_dev_t *dev, uint8_t report_id,
+                          uint8_t *data, uint16_t len);
+
+// 现在可以交给协议栈的通知数：拥塞时为 0，否则为在途上限减去在途数
+// 返回 0 时记下等待，收到 CONF 或拥塞解除后通知发送任务
+uint32_t ble_hid_tx_available(void);
+
+// 取出并清零丢失的报告，bit n 对应报告 ID n，超时的在途通知一并计入
+// 调用方按当前状态重新发送这些报告
+uint32_t ble_hid_tx_take_lost(void);
+
+// 输出并清零发送统计：发送、拒绝、丢失、超时和重发次数
+void ble_hid_tx_print(void);
+
+#endif /* BLE_HID_TX_H */
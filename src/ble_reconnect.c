@@ -0,0 +1,274 @@
+#include "ble_reconnect.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_hid_gap.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+  PHASE_IDLE = 0,  // 已连接或未开始
+  PHASE_DIRECT_HIGH,
+  PHASE_DIRECT_LOW,
+  PHASE_UNDIRECTED_FAST,
+  PHASE_UNDIRECTED_SLOW,
+} reconnect_phase_t;
+
+static const char *TAG = "RECONNECT";
+
+static const char *const phase_names[] = {
+    "idle", "direct_high", "direct_low", "undirected_fast", "undirected_slow",
+};
+
+static const uint32_t phase_ms[] = {
+    [PHASE_DIRECT_HIGH] = RECONNECT_DIRECT_HIGH_MS,
+    [PHASE_DIRECT_LOW] = RECONNECT_DIRECT_LOW_MS,
+    [PHASE_UNDIRECTED_FAST] = RECONNECT_UNDIRECTED_FAST_MS,
+    [PHASE_UNDIRECTED_SLOW] = 0,
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_timer = NULL;
+static reconnect_phase_t s_phase = PHASE_IDLE;       // 正在进行的阶段
+static reconnect_phase_t s_next_phase = PHASE_IDLE;  // 定时器到期时进入的阶段
+static bool s_connected = false;
+static int64_t s_start_us = 0;     // 本轮重连开始的时间
+static esp_bd_addr_t s_last_peer;  // 最近一次连接的主机
+static bool s_has_last_peer = false;
+static bool s_has_target = false;  // 已由 ble_reconnect_set_peer 指定目标
+static bool s_target_none = false;
+static esp_bd_addr_t s_target;
+
+// 在绑定列表中选择定向广播的目标：指定了目标时只取该主机，
+// 否则优先最近一次连接的主机，再取第一个
+static bool find_bonded_peer(esp_bd_addr_t addr,
+                             esp_ble_addr_type_t *addr_type) {
+  esp_bd_addr_t wanted;
+  portENTER_CRITICAL(&s_lock);
+  bool has_target = s_has_target;
+  bool has_wanted = has_target ? !s_target_none : s_has_last_peer;
+  memcpy(wanted, has_target ? s_target : s_last_peer, sizeof(wanted));
+  portEXIT_CRITICAL(&s_lock);
+  if (has_target && !has_wanted) {
+    return false;
+  }
+
+  int num = esp_ble_get_bond_device_num();
+  if (num <= 0) {
+    return false;
+  }
+  esp_ble_bond_dev_t *list = malloc(num * sizeof(esp_ble_bond_dev_t));
+  if (list == NULL || esp_ble_get_bond_device_list(&num, list) != ESP_OK ||
+      num <= 0) {
+    free(list);
+    return false;
+  }
+
+  // 指定的目标已不在绑定列表中时不做定向广播
+  const esp_ble_bond_dev_t *peer = has_target ? NULL : &list[0];
+  for (int i = 0; has_wanted && i < num; i++) {
+    if (memcmp(list[i].bd_addr, wanted, sizeof(esp_bd_addr_t)) == 0) {
+      peer = &list[i];
+      break;
+    }
+  }
+  if (peer == NULL) {
+    free(list);
+    return false;
+  }
+  memcpy(addr, peer->bd_addr, sizeof(esp_bd_addr_t));
+  *addr_type = (peer->bond_key.key_mask & ESP_LE_KEY_PID)
+                   ? peer->bond_key.pid_key.addr_type
+                   : BLE_ADDR_TYPE_PUBLIC;
+  free(list);
+  return true;
+}
+
+static esp_err_t start_phase(reconnect_phase_t phase) {
+  esp_ble_adv_params_t params = {
+      .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+      .channel_map = ADV_CHNL_ALL,
+      .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
+  };
+
+  switch (phase) {
+    case PHASE_DIRECT_HIGH:
+    case PHASE_DIRECT_LOW:
+      if (!find_bonded_peer(params.peer_addr, &params.peer_addr_type)) {
+        return ESP_ERR_NOT_FOUND;
+      }
+      params.adv_type = phase == PHASE_DIRECT_HIGH ? ADV_TYPE_DIRECT_IND_HIGH
+                                                   : ADV_TYPE_DIRECT_IND_LOW;
+      // 高占空比定向广播由控制器决定间隔，这里的值只对低占空比有效
+      params.adv_int_min = 0x20;
+      params.adv_int_max = 0x30;
+      return esp_ble_gap_start_advertising(&params);
+    case PHASE_UNDIRECTED_FAST:
+      return esp_hid_ble_gap_adv_start();
+    case PHASE_UNDIRECTED_SLOW:
+      params.adv_type = ADV_TYPE_IND;
+      params.adv_int_min = 0xF4;  // 152.5ms
+      params.adv_int_max = 0x150;  // 210ms
+      return esp_ble_gap_start_advertising(&params);
+    default:
+      return ESP_OK;
+  }
+}
+
+// 所有阶段切换都在定时器回调中执行，不同任务触发的切换不会交错
+static void schedule(reconnect_phase_t phase, uint64_t delay_us) {
+  portENTER_CRITICAL(&s_lock);
+  s_next_phase = phase;
+  portEXIT_CRITICAL(&s_lock);
+  esp_timer_stop(s_timer);
+  esp_timer_start_once(s_timer, delay_us);
+}
+
+// 进入下一阶段，没有绑定主机或启动失败时继续退到之后的阶段
+static void timer_cb(void *arg) {
+  portENTER_CRITICAL(&s_lock);
+  reconnect_phase_t phase = s_connected ? PHASE_IDLE : s_next_phase;
+  portEXIT_CRITICAL(&s_lock);
+  if (phase == PHASE_IDLE) {
+    return;
+  }
+
+  esp_ble_gap_stop_advertising();
+  for (; phase <= PHASE_UNDIRECTED_SLOW; phase++) {
+    portENTER_CRITICAL(&s_lock);
+    s_phase = phase;
+    s_next_phase = phase == PHASE_UNDIRECTED_SLOW ? PHASE_IDLE : phase + 1;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_err_t err = start_phase(phase);
+    if (err == ESP_OK) {
+      ESP_LOGI(TAG, "advertising: %s", phase_names[phase]);
+      if (phase_ms[phase] > 0) {
+        esp_timer_start_once(s_timer, phase_ms[phase] * 1000ULL);
+      }
+      return;
+    }
+    if (err != ESP_ERR_NOT_FOUND) {
+      ESP_LOGW(TAG, "%s failed: %d", phase_names[phase], err);
+    }
+  }
+}
+
+void ble_reconnect_init(void) {
+  if (s_timer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "reconnect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+  }
+}
+
+void ble_reconnect_start(void) {
+  portENTER_CRITICAL(&s_lock);
+  bool connected = s_connected;
+  s_start_us = esp_timer_get_time();
+  portEXIT_CRITICAL(&s_lock);
+
+  if (!connected) {
+    schedule(PHASE_DIRECT_HIGH, 0);
+  }
+}
+
+void ble_reconnect_set_peer(const uint8_t *addr) {
+  portENTER_CRITICAL(&s_lock);
+  s_has_target = true;
+  s_target_none = addr == NULL;
+  if (addr != NULL) {
+    memcpy(s_target, addr, sizeof(s_target));
+  }
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void ble_reconnect_restart(void) {
+  esp_bd_addr_t peer;
+  portENTER_CRITICAL(&s_lock);
+  bool connected = s_connected;
+  memcpy(peer, s_last_peer, sizeof(peer));
+  portEXIT_CRITICAL(&s_lock);
+
+  if (connected) {
+    // 断开事件到达后 ble_reconnect_gatts_event 立即开始重连
+    esp_err_t err = esp_ble_gap_disconnect(peer);
+    if (err != ESP_OK) {
+      ESP_LOGW(TAG, "disconnect failed: %d", err);
+    }
+  } else {
+    ble_reconnect_start();
+  }
+}
+
+void ble_reconnect_wake(void) {
+  portENTER_CRITICAL(&s_lock);
+  bool slow = s_phase == PHASE_UNDIRECTED_SLOW;
+  portEXIT_CRITICAL(&s_lock);
+
+  if (slow) {
+    ble_reconnect_start();
+  }
+}
+
+void ble_reconnect_gatts_event(esp_gatts_cb_event_t event,
+                               esp_ble_gatts_cb_param_t *param) {
+  // 每个 GATTS 应用都会收到连接事件，只处理状态变化的那一次
+  if (event == ESP_GATTS_CONNECT_EVT) {
+    portENTER_CRITICAL(&s_lock);
+    bool was_connected = s_connected;
+    reconnect_phase_t phase = s_phase;
+    s_connected = true;
+    s_phase = PHASE_IDLE;
+    s_next_phase = PHASE_IDLE;
+    memcpy(s_last_peer, param->connect.remote_bda, sizeof(s_last_peer));
+    s_has_last_peer = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!was_connected) {
+      esp_timer_stop(s_timer);
+      ESP_LOGI(TAG, "connected after %" PRId64 " ms (%s)",
+               (esp_timer_get_time() - s_start_us) / 1000, phase_names[phase]);
+    }
+  } else if (event == ESP_GATTS_DISCONNECT_EVT) {
+    portENTER_CRITICAL(&s_lock);
+    bool was_connected = s_connected;
+    s_connected = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (was_connected) {
+      ble_reconnect_start();
+    }
+  }
+}
+
+void ble_reconnect_gap_event(esp_gap_ble_cb_event_t event,
+                             esp_ble_gap_cb_param_t *param) {
+  if (event != ESP_GAP_BLE_ADV_START_COMPLETE_EVT ||
+      param->adv_start_cmpl.status == ESP_BT_STATUS_SUCCESS) {
+    return;
+  }
+  // 控制器拒绝了该阶段（例如定向目标无效），立即退到下一阶段
+  portENTER_CRITICAL(&s_lock);
+  reconnect_phase_t phase = s_phase;
+  reconnect_phase_t next = s_next_phase;
+  portEXIT_CRITICAL(&s_lock);
+  ESP_LOGW(TAG, "%s rejected: %d", phase_names[phase],
+           param->adv_start_cmpl.status);
+  if (next != PHASE_IDLE) {
+    schedule(next, 0);
+  }
+}
+
+bool ble_reconnect_is_connected(void) {
+  portENTER_CRITICAL(&s_lock);
+  bool connected = s_connected;
+  portEXIT_CRITICAL(&s_lock);
+  return connected;
+}
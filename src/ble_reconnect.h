@@ -0,0 +1,49 @@
+#ifndef BLE_RECONNECT_H
+#define BLE_RECONNECT_H
+
+#include <stdbool.h>
+
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+
+// 断线或唤醒后的重连：先向已绑定的主机发高占空比定向广播，
+// 再依次退到低占空比定向广播、快速非定向广播、慢速非定向广播
+// 全部由 esp_timer 推进，不阻塞调用者
+
+// 各阶段持续时间 (ms)，慢速非定向广播一直持续到连接建立
+#ifndef RECONNECT_DIRECT_HIGH_MS
+#define RECONNECT_DIRECT_HIGH_MS 1280  // 控制器对高占空比定向广播的上限
+#endif
+#ifndef RECONNECT_DIRECT_LOW_MS
+#define RECONNECT_DIRECT_LOW_MS 5000
+#endif
+#ifndef RECONNECT_UNDIRECTED_FAST_MS
+#define RECONNECT_UNDIRECTED_FAST_MS 30000
+#endif
+
+void ble_reconnect_init(void);
+
+// 从第一阶段开始广播；正在广播时重新开始，连接状态下不做任何事
+void ble_reconnect_start(void);
+
+// 定向广播的目标主机，NULL 表示没有目标，只做非定向广播
+// 未设置时取最近一次连接的已绑定主机；从下一轮重连开始生效
+void ble_reconnect_set_peer(const uint8_t *addr);
+
+// 按当前目标立即重新开始：已连接时断开当前主机，断开后开始重连
+void ble_reconnect_restart(void);
+
+// 按键唤醒：已退到慢速非定向广播时重新从定向广播开始，其他阶段不打断
+void ble_reconnect_wake(void);
+
+// GATTS 事件，处理连接建立和断开：断开后立即开始重连
+void ble_reconnect_gatts_event(esp_gatts_cb_event_t event,
+                               esp_ble_gatts_cb_param_t *param);
+
+// GAP 事件，处理广播启动失败
+void ble_reconnect_gap_event(esp_gap_ble_cb_event_t event,
+                             esp_ble_gap_cb_param_t *param);
+
+bool ble_reconnect_is_connected(void);
+
+#endif /* BLE_RECONNECT_H */
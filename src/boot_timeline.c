@@ -0,0 +1,99 @@
+#include "boot_timeline.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct {
+  const char *name;
+  int64_t time_us;
+} boot_mark_t;
+
+static const char *TAG = "BOOT";
+
+static const char *const milestone_names[] = {
+    [BOOT_MILESTONE_KEY] = "first_key",
+    [BOOT_MILESTONE_ADV] = "first_adv",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static boot_mark_t s_marks[BOOT_TIMELINE_MAX_MARKS];
+static uint8_t s_num_marks = 0;
+static volatile bool s_reached[BOOT_MILESTONE_NUM];
+
+static void add_mark(const char *name, int64_t time_us) {
+  portENTER_CRITICAL(&s_lock);
+  if (s_num_marks < BOOT_TIMELINE_MAX_MARKS) {
+    s_marks[s_num_marks++] = (boot_mark_t){name, time_us};
+  }
+  portEXIT_CRITICAL(&s_lock);
+}
+
+static const char *reset_str(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:
+      return "power-on";
+    case ESP_RST_DEEPSLEEP:
+      return "deep-sleep wake";
+    default:
+      return "reset";
+  }
+}
+
+void boot_timeline_mark(const char *name) {
+  add_mark(name, esp_timer_get_time());
+}
+
+void boot_timeline_milestone(boot_milestone_t milestone, int64_t time_us) {
+  if (s_reached[milestone]) {
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  bool first = !s_reached[milestone];
+  s_reached[milestone] = true;
+  portEXIT_CRITICAL(&s_lock);
+  if (!first) {
+    return;
+  }
+
+  add_mark(milestone_names[milestone], time_us);
+  ESP_LOGI(TAG, "%s at %" PRId64 " us", milestone_names[milestone], time_us);
+  // 广播开始时启动已经完成
+  if (milestone == BOOT_MILESTONE_ADV) {
+    boot_timeline_print();
+  }
+}
+
+void boot_timeline_print(void) {
+  boot_mark_t marks[BOOT_TIMELINE_MAX_MARKS];
+
+  portENTER_CRITICAL(&s_lock);
+  uint8_t num = s_num_marks;
+  for (int i = 0; i < num; i++) {
+    marks[i] = s_marks[i];
+  }
+  portEXIT_CRITICAL(&s_lock);
+
+  // 里程碑可能晚于之后的阶段记录，按时间输出
+  for (int i = 1; i < num; i++) {
+    boot_mark_t mark = marks[i];
+    int j = i;
+    for (; j > 0 && marks[j - 1].time_us > mark.time_us; j--) {
+      marks[j] = marks[j - 1];
+    }
+    marks[j] = mark;
+  }
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  ESP_LOGI(TAG, "timeline after %s (%d):", reset_str(reason), reason);
+  int64_t prev_us = 0;
+  for (int i = 0; i < num; i++) {
+    ESP_LOGI(TAG, "%10" PRId64 " us  +%8" PRId64 "  %s", marks[i].time_us,
+             marks[i].time_us - prev_us, marks[i].name);
+    prev_us = marks[i].time_us;
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+// 启动时间线：记录 app_main 中各阶段完成的时间 (esp_timer_get_time，
+// 自应用启动起的 us)，以及第一次开始广播和第一次捕获按键的时间
+// 第一次广播时输出完整时间线，并注明本次启动是上电、深睡眠唤醒还是复位，
+// 便于比较不同启动方式的耗时
+
+// 最多记录的阶段数，超出的阶段被丢弃
+#ifndef BOOT_TIMELINE_MAX_MARKS
+#define BOOT_TIMELINE_MAX_MARKS 24
+#endif
+
+typedef enum {
+  BOOT_MILESTONE_KEY = 0,  // 扫描任务确认了第一个按键
+  BOOT_MILESTONE_ADV,      // 控制器开始了第一次广播
+  BOOT_MILESTONE_NUM,
+} boot_milestone_t;
+
+// 记录一个阶段完成，name 必须是字符串常量；可在任意任务中调用
+void boot_timeline_mark(const char *name);
+
+// 记录里程碑，只有第一次有效；time_us 为事件发生的时间
+// 之后的调用只读一个标志，可以放在按键路径上
+void boot_timeline_milestone(boot_milestone_t milestone, int64_t time_us);
+
+// 输出已记录的时间线
+void boot_timeline_print(void);
+
+#endif /* BOOT_TIMELINE_H */
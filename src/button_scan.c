@@ -2,117 +2,281 @@
 
 #include <string.h>
 
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "key_trace.h"
+#include "matrix_io.h"
+#include "power_mgmt.h"
 
 static const char *TAG = "BUTTON_SCAN";
 
-// 行引脚数组
-static const gpio_num_t row_pins[ROW_NUM] = {ROW1_PIN, ROW2_PIN, ROW3_PIN};
+// 列中断唤醒信号
+static SemaphoreHandle_t s_wake_sem = NULL;
 
-// 列引脚数组
-static const gpio_num_t col_pins[COL_NUM] = {COL1_PIN, COL2_PIN, COL3_PIN};
+// 扫描定时器及帧发布
+static esp_timer_handle_t s_scan_timer = NULL;
+static TaskHandle_t s_consumer = NULL;
+static portMUX_TYPE s_snapshot_lock = portMUX_INITIALIZER_UNLOCKED;
+static matrix_row_t s_raw[ROW_NUM];   // 正在扫描的原始帧
+static debounce_t s_debounce;         // 仅在定时器回调中访问
+static button_state_t s_snapshot;     // 消抖后的状态及累计边沿
+static bool s_idle_reported = false;  // 空闲状态已通知扫描任务
+static matrix_row_t s_edge_pending[ROW_NUM];  // 原始采样已变化、尚未确认的按键
+static int64_t s_edge_us[ROW_NUM][COL_NUM];   // 对应的原始变化时间
+static volatile int64_t s_wake_us = 0;        // 空闲等待被列中断唤醒的时间
+#if BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER
+static uint8_t s_row = 0;  // 当前被拉低的行
+#endif
 
-// 按键映射到键码 (HID键码)
-// 按键矩阵布局:
-// | A(0,0) | B(0,1) | C(0,2) |
-// | D(1,0) | E(1,1) | F(1,2) |
-// | G(2,0) | H(2,1) | I(2,2) |
-static const uint8_t keycode_map[ROW_NUM][COL_NUM] = {
-    {0x52, 0x4F, 0x06},  // UP, RIGHT, C
-    {0x50, 0x08, 0x09},  // LEFT, E, F
-    {0x51, 0x0B, 0x0C}   // DOWN, H, I
-};
-key_state key_states[ROW_NUM][COL_NUM];
+// 扫描任务
+static TaskHandle_t s_scan_task = NULL;
+static key_event_queue_t *s_event_queue = NULL;
+static TaskHandle_t s_event_consumer = NULL;
 
-void button_scan_init(void) {
-  // 配置行GPIO（输出模式）
-  gpio_config_t io_conf = {.pin_bit_mask = 0,
-                           .mode = GPIO_MODE_INPUT,
-                           .pull_up_en = GPIO_PULLUP_ENABLE,
-                           .pull_down_en = GPIO_PULLDOWN_DISABLE,
-                           .intr_type = GPIO_INTR_DISABLE};
-
-  for (int i = 0; i < ROW_NUM; i++) {
-    io_conf.pin_bit_mask |= (1ULL << row_pins[i]);
+// 列中断回调：空闲等待期间有按键按下
+static void IRAM_ATTR wake_isr(void) {
+  BaseType_t woken = pdFALSE;
+  if (s_wake_us == 0) {
+    s_wake_us = esp_timer_get_time();
   }
-  for (int i = 0; i < COL_NUM; i++) {
-    io_conf.pin_bit_mask |= (1ULL << col_pins[i]);
+  xSemaphoreGiveFromISR(s_wake_sem, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+// 记录原始采样与消抖状态开始不同的时间，精度为一个扫描帧
+// 空闲唤醒后的第一帧使用列中断的时间，计入定时器启动和首帧扫描的延迟
+static void stamp_raw_edges(int64_t now) {
+  int64_t edge_us = s_wake_us ? s_wake_us : now;
+  s_wake_us = 0;
+
+  for (int row = 0; row < ROW_NUM; row++) {
+    matrix_row_t differs = s_raw[row] ^ s_debounce.state[row];
+    matrix_row_t fresh = differs & ~s_edge_pending[row];
+    while (fresh) {
+      int col = __builtin_ctz(fresh);
+      fresh &= fresh - 1;
+      s_edge_us[row][col] = edge_us;
+    }
+    s_edge_pending[row] = differs;
   }
-  gpio_config(&io_conf);
-  vTaskDelay(pdMS_TO_TICKS(5));
 }
-button_state_t scan_button(void) {
-  button_state_t result = {0};  // 初始化为0个按键
-  static TickType_t last_scan_time = 0;
-  TickType_t current_time = xTaskGetTickCount();
 
-  // 限制扫描频率，每20ms扫描一次
-  if ((current_time - last_scan_time) < pdMS_TO_TICKS(20)) {
-    return result;
+// 一帧扫描完成：整帧消抖，只有出现边沿或进入空闲时才通知扫描任务
+static void publish_frame(void) {
+  matrix_row_t changed[ROW_NUM];
+  int64_t now = esp_timer_get_time();
+  stamp_raw_edges(now);
+  bool has_edge = debounce_update(&s_debounce, s_raw, changed);
+  bool idle = debounce_is_idle(&s_debounce);
+  bool notify = has_edge || (idle && !s_idle_reported);
+
+  if (notify) {
+    portENTER_CRITICAL(&s_snapshot_lock);
+    for (int row = 0; row < ROW_NUM; row++) {
+      s_snapshot.pressed[row] = s_debounce.state[row];
+      s_snapshot.changed[row] |= changed[row];
+      matrix_row_t bits = changed[row];
+      while (bits) {
+        int col = __builtin_ctz(bits);
+        bits &= bits - 1;
+        s_snapshot.edge_us[row][col] = s_edge_us[row][col];
+      }
+      // 已确认的按键下次变化时重新计时
+      s_edge_pending[row] &= ~changed[row];
+    }
+    s_snapshot.idle = idle;
+    if (has_edge) {
+      s_snapshot.timestamp_us = now;
+    }
+    portEXIT_CRITICAL(&s_snapshot_lock);
+    s_idle_reported = idle;
+    if (s_consumer) {
+      xTaskNotifyGive(s_consumer);
+    }
   }
-  last_scan_time = current_time;
+}
 
-  // 扫描所有按键
+static void scan_timer_cb(void *arg) {
+#if BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER
+  // 上一个周期拉低的行已经稳定了一个定时器周期，读取后切换到下一行
+  s_raw[s_row] = matrix_io_read_cols();
+  matrix_io_unselect_row(s_row);
+  s_row = (s_row + 1) % ROW_NUM;
+  matrix_io_select_row(s_row);
+  if (s_row == 0) {
+    publish_frame();
+  }
+#else
   for (int row = 0; row < ROW_NUM; row++) {
-    // 激活当前行（置低电平）
-
-    gpio_set_direction(row_pins[row], GPIO_MODE_OUTPUT);
-    gpio_set_pull_mode(row_pins[row], GPIO_FLOATING);
-    gpio_set_level(row_pins[row], 0);
-
-    // 等待电平稳定
-    vTaskDelay(pdMS_TO_TICKS(5));
-
-    // 读取列状态
-    for (int col = 0; col < COL_NUM; col++) {
-      int level = gpio_get_level(col_pins[col]);
-
-      // 更新按键状态
-      key_states[row][col].current = !level;  // 假设低电平有效
-      if (level == 0) {
-        if (result.num_keys < MAX_KEYS) {
-          result.keys[result.num_keys].row = row;
-          result.keys[result.num_keys].col = col;
-          result.num_keys++;
-          ESP_LOGI(TAG, "按键按下: 行=%d, 列=%d", row, col);
-          key_states[row][col].count = 0;
-        }
-      }
+    matrix_io_select_row(row);
+    esp_rom_delay_us(BUTTON_ROW_SETTLE_US);
+    s_raw[row] = matrix_io_read_cols();
+    matrix_io_unselect_row(row);
+  }
+  publish_frame();
+#endif
+}
 
-      // 去抖动处理
-      if (key_states[row][col].current == key_states[row][col].previous) {
-        if (key_states[row][col].count < DEBOUNCE_THRESHOLD) {
-          key_states[row][col].count++;
-        } else if (key_states[row][col].current) {
-          //   if (result.num_keys < MAX_KEYS) {
-          //     result.keys[result.num_keys].row = row;
-          //     result.keys[result.num_keys].col = col;
-          //     result.num_keys++;
-          //     ESP_LOGI(TAG, "按键按下: 行=%d, 列=%d", row, col);
-          //     key_states[row][col].count = 0;
-          //   }
-        }
-
-      } else {
-        key_states[row][col].count = 0;
-        key_states[row][col].previous = key_states[row][col].current;
-      }
+static void scan_timer_start(void) {
+  if (esp_timer_is_active(s_scan_timer)) {
+    return;
+  }
+  // 扫描期间行引脚状态频繁切换，不进入浅睡眠
+  power_lock_set(POWER_LOCK_SCAN, true);
+  s_idle_reported = false;
+  matrix_io_release_rows();
+#if BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER
+  s_row = 0;
+  matrix_io_select_row(0);
+#endif
+  esp_timer_start_periodic(s_scan_timer, BUTTON_SCAN_TICK_US);
+}
+
+static void scan_timer_stop(void) {
+  if (esp_timer_is_active(s_scan_timer)) {
+    esp_timer_stop(s_scan_timer);
+  }
+  matrix_io_release_rows();
+  power_lock_set(POWER_LOCK_SCAN, false);
+}
+
+void button_scan_init(void) {
+  // 列中断唤醒信号，需在使能列中断之前创建
+  if (s_wake_sem == NULL) {
+    s_wake_sem = xSemaphoreCreateBinary();
+  }
+  matrix_io_init(wake_isr);
+
+  debounce_init(&s_debounce, ROW_NUM, BUTTON_DEBOUNCE_MODE);
+
+  // 扫描定时器
+  if (s_scan_timer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = scan_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "button_scan",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &s_scan_timer);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "esp_timer_create failed: %d", ret);
     }
+  }
+  ESP_LOGI(TAG, "扫描频率 %d Hz, 行稳定 %s", BUTTON_SCAN_RATE_HZ,
+           BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER ? "定时器" : "忙等待");
+}
+
+bool button_scan_wait_for_press(TickType_t timeout) {
+  scan_timer_stop();
+
+  // 所有行拉低，任意按键按下都会把所在列拉低
+  matrix_io_select_all_rows();
 
-    // 禁用当前行（置高电平）
-    gpio_set_direction(row_pins[row], GPIO_MODE_INPUT);
-    gpio_set_pull_mode(row_pins[row], GPIO_PULLUP_ONLY);
-    vTaskDelay(pdMS_TO_TICKS(5));
+  // 清除残留信号后再使能中断
+  xSemaphoreTake(s_wake_sem, 0);
+  s_wake_us = 0;
+  matrix_io_wake_enable(true);
+
+  // 使能中断之前已经按下的按键不会再产生边沿
+  bool pressed = matrix_io_read_cols() != 0;
+  if (pressed && s_wake_us == 0) {
+    s_wake_us = esp_timer_get_time();
+  } else {
+    pressed = (xSemaphoreTake(s_wake_sem, timeout) == pdTRUE);
   }
 
+  matrix_io_wake_enable(false);
+  matrix_io_release_rows();
+  return pressed;
+}
+
+button_state_t scan_button(void) {
+  button_state_t result;
+
+  // 首次调用时启动定时器，之后等待消抖后的边沿
+  s_consumer = xTaskGetCurrentTaskHandle();
+  scan_timer_start();
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+  portENTER_CRITICAL(&s_snapshot_lock);
+  result = s_snapshot;
+  memset(s_snapshot.changed, 0, sizeof(s_snapshot.changed));
+  portEXIT_CRITICAL(&s_snapshot_lock);
   return result;
 }
 
-uint8_t get_keycode_from_button(uint8_t row, uint8_t col) {
-  if (row < ROW_NUM && col < COL_NUM) {
-    return keycode_map[row][col];
+// 扫描任务：等待消抖后的边沿，逐个转换为按键事件写入队列
+static void button_scan_task(void *pvParameters) {
+  while (1) {
+    button_state_t button = scan_button();
+    bool pushed = false;
+
+    for (int row = 0; row < ROW_NUM; row++) {
+      matrix_row_t changed = button.changed[row];
+      while (changed) {
+        int col = __builtin_ctz(changed);
+        changed &= changed - 1;
+        key_event_t event = {
+            .timestamp_us = button.timestamp_us,
+            .edge_us = button.edge_us[row][col],
+            .row = row,
+            .col = col,
+            .pressed = (button.pressed[row] >> col) & 1,
+        };
+        // 键码由发送任务按键位表确定，扫描阶段不记录
+        KEY_TRACE(event.pressed ? KEY_TRACE_SCAN_DOWN : KEY_TRACE_SCAN_UP, row,
+                  col, 0, ESP_OK);
+        key_event_queue_push(s_event_queue, &event);
+        pushed = true;
+      }
+    }
+
+    if (pushed) {
+      xTaskNotifyGive(s_event_consumer);
+    } else if (button.idle) {
+      // 没有按键按住，进入空闲等待，直到列中断唤醒后恢复定时扫描
+      button_scan_wait_for_press(portMAX_DELAY);
+    }
+  }
+}
+
+void button_scan_start(key_event_queue_t *queue, TaskHandle_t consumer) {
+  s_event_queue = queue;
+  s_event_consumer = consumer;
+  if (s_scan_task == NULL) {
+    xTaskCreate(button_scan_task, "button_scan", 2 * 1024, NULL,
+                configMAX_PRIORITIES - 2, &s_scan_task);
+  }
+}
+
+void button_scan_get_pressed(matrix_row_t *pressed) {
+  portENTER_CRITICAL(&s_snapshot_lock);
+  memcpy(pressed, s_snapshot.pressed, sizeof(s_snapshot.pressed));
+  portEXIT_CRITICAL(&s_snapshot_lock);
+}
+
+void button_scan_set_debounce_mode(uint8_t row, uint8_t col,
+                                   debounce_mode_t mode) {
+  debounce_set_mode(&s_debounce, row, col, mode);
+}
+
+uint8_t button_state_get_keys(const button_state_t *state, key_position_t *keys,
+                              uint8_t max_keys) {
+  uint8_t num_keys = 0;
+  for (int row = 0; row < ROW_NUM; row++) {
+    matrix_row_t bits = state->pressed[row];
+    while (bits && num_keys < max_keys) {
+      int col = __builtin_ctz(bits);
+      bits &= bits - 1;
+      keys[num_keys].row = row;
+      keys[num_keys].col = col;
+      num_keys++;
+    }
   }
-  return 0;  // 无效的行列返回0
-}
\ No newline at end of file
+  return num_keys;
+}
@@ -3,14 +3,15 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "debounce.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "key_event_queue.h"
 
 // 按键矩阵定义
 #define ROW_NUM 3
 #define COL_NUM 3
-#define MAX_KEYS 6  // 最多支持6个按键同时按下
 
 // 按键矩阵引脚定义
 #define ROW1_PIN GPIO_NUM_6
@@ -20,7 +21,47 @@
 #define COL1_PIN GPIO_NUM_12
 #define COL2_PIN GPIO_NUM_13
 #define COL3_PIN GPIO_NUM_10
-#define DEBOUNCE_THRESHOLD 3
+
+// 默认消抖算法，可用 button_scan_set_debounce_mode 按键单独设置
+#ifndef BUTTON_DEBOUNCE_MODE
+#define BUTTON_DEBOUNCE_MODE DEBOUNCE_EAGER
+#endif
+
+// 扫描频率 (Hz)，范围 100 ~ 1000，可在板级 build_flags 中覆盖
+#ifndef BUTTON_SCAN_RATE_HZ
+#define BUTTON_SCAN_RATE_HZ 1000
+#endif
+
+// 行稳定方式
+#define BUTTON_SETTLE_BUSY_WAIT 0  // 每帧在定时器回调中逐行忙等待
+#define BUTTON_SETTLE_TIMER 1      // 每个定时器周期切换一行，周期即稳定时间
+#ifndef BUTTON_SETTLE_MODE
+#define BUTTON_SETTLE_MODE BUTTON_SETTLE_BUSY_WAIT
+#endif
+
+// 忙等待模式下的行稳定时间 (us)
+#ifndef BUTTON_ROW_SETTLE_US
+#define BUTTON_ROW_SETTLE_US 10
+#endif
+
+#if BUTTON_SCAN_RATE_HZ < 100 || BUTTON_SCAN_RATE_HZ > 1000
+#error "BUTTON_SCAN_RATE_HZ must be within 100 ~ 1000"
+#endif
+
+// 扫描定时器周期 (us)
+#if BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER
+#define BUTTON_SCAN_TICK_US (1000000 / (BUTTON_SCAN_RATE_HZ * ROW_NUM))
+#else
+#define BUTTON_SCAN_TICK_US (1000000 / BUTTON_SCAN_RATE_HZ)
+#endif
+
+// 按键从按下到出现在快照中的最坏延迟 (us)：一个完整帧周期加一行稳定时间
+#if BUTTON_SETTLE_MODE == BUTTON_SETTLE_TIMER
+#define BUTTON_SCAN_LATENCY_US (1000000 / BUTTON_SCAN_RATE_HZ + BUTTON_SCAN_TICK_US)
+#else
+#define BUTTON_SCAN_LATENCY_US \
+  (1000000 / BUTTON_SCAN_RATE_HZ + ROW_NUM * BUTTON_ROW_SETTLE_US)
+#endif
 
 // 按键位置结构体
 typedef struct {
@@ -28,26 +69,39 @@ typedef struct {
     uint8_t col;
 } key_position_t;
 
-// 按键状态结构体
+// 按键状态结构体：每行一个位图
 typedef struct {
-    uint8_t num_keys;                    // 当前按下的按键数量
-    key_position_t keys[MAX_KEYS];       // 按下的按键位置数组
+    matrix_row_t pressed[ROW_NUM];       // 消抖后按下的按键
+    matrix_row_t changed[ROW_NUM];       // 上次读取以来的按下/释放边沿
+    bool idle;                           // 全部释放且不再抖动，可进入空闲等待
+    int64_t timestamp_us;                // 最近一次边沿的时间
+    int64_t edge_us[ROW_NUM][COL_NUM];   // 每个按键最近一次边沿的原始变化时间
 } button_state_t;
 
 // 初始化按键扫描
 void button_scan_init(void);
 
-// 扫描按键
+// 启动扫描任务：消抖后的按键事件写入 queue，每次写入后通知 consumer
+void button_scan_start(key_event_queue_t *queue, TaskHandle_t consumer);
+
+// 读取当前消抖后的按键状态，事件丢失后用于重新同步
+void button_scan_get_pressed(matrix_row_t *pressed);
+
+// 扫描按键：阻塞到出现消抖后的边沿（或矩阵进入空闲），返回矩阵快照
+// 首次调用时启动扫描定时器，调用任务即为帧通知的接收者
 button_state_t scan_button(void);
 
-// 获取按键对应的键码
-uint8_t get_keycode_from_button(uint8_t row, uint8_t col);
+// 空闲等待：停止扫描定时器，所有行拉低，列引脚低电平中断唤醒，不再轮询
+// 开启电源管理时等待期间芯片进入浅睡眠，列引脚同时是浅睡眠唤醒源
+// 有按键按下返回 true，超时返回 false
+bool button_scan_wait_for_press(TickType_t timeout);
 
-// 按键状态结构体
-typedef struct {
-    uint8_t current : 1;
-    uint8_t previous : 1;
-    uint8_t count : 6;
-} key_state;
+// 设置单个按键的消抖算法
+void button_scan_set_debounce_mode(uint8_t row, uint8_t col,
+                                   debounce_mode_t mode);
+
+// 获取按下的按键位置，最多 max_keys 个，返回实际数量
+uint8_t button_state_get_keys(const button_state_t *state, key_position_t *keys,
+                              uint8_t max_keys);
 
 #endif /* BUTTON_SCAN_H */ 
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "conn_policy.h"
+
+#include <string.h>
+
+// 默认参数
+#define FAST_INTERVAL 6           // 7.5ms
+#define FAST_RELAXED_MAX_INT 12   // 15ms
+#define FAST_TIMEOUT 400          // 4s
+#define SLOW_MIN_INT 48           // 60ms
+#define SLOW_MAX_INT 64           // 80ms
+#define SLOW_LATENCY 24           // 最长 80ms * 25 = 2s 不通信
+#define SLOW_TIMEOUT 600          // 6s，大于 2 倍的有效间隔
+#define PENDING_TIMEOUT_US (30 * 1000 * 1000LL)
+#define BACKOFF_MIN_US (5 * 1000 * 1000)
+#define BACKOFF_MAX_US (120 * 1000 * 1000)
+
+void conn_policy_init(conn_policy_t *p, int64_t idle_timeout_us) {
+  memset(p, 0, sizeof(*p));
+  conn_policy_set_fast(p, NULL);
+  p->fast_relaxed =
+      (conn_params_t){FAST_INTERVAL, FAST_RELAXED_MAX_INT, 0, FAST_TIMEOUT};
+  p->slow = (conn_params_t){SLOW_MIN_INT, SLOW_MAX_INT, SLOW_LATENCY,
+                            SLOW_TIMEOUT};
+  p->idle_timeout_us = idle_timeout_us;
+  p->pending_timeout_us = PENDING_TIMEOUT_US;
+  p->backoff_min_us = BACKOFF_MIN_US;
+  p->backoff_max_us = BACKOFF_MAX_US;
+  p->backoff_us = BACKOFF_MIN_US;
+}
+
+void conn_policy_set_fast(conn_policy_t *p, const conn_params_t *fast) {
+  if (fast != NULL) {
+    p->fast = *fast;
+  } else {
+    p->fast = (conn_params_t){FAST_INTERVAL, FAST_INTERVAL, 0, FAST_TIMEOUT};
+  }
+}
+
+// 当前参数是否已经满足快速模式的要求
+static bool params_are_fast(const conn_policy_t *p) {
+  return p->latency == 0 && p->interval <= p->fast_relaxed.max_int;
+}
+
+static conn_policy_mode_t desired_mode(const conn_policy_t *p, int64_t now_us) {
+  return now_us - p->last_activity_us >= p->idle_timeout_us
+             ? CONN_POLICY_SLOW
+             : CONN_POLICY_FAST;
+}
+
+// 主机已接受的参数满足该模式，主机主动设置的短间隔同样满足快速模式
+static bool satisfied(const conn_policy_t *p, conn_policy_mode_t mode) {
+  return mode == p->settled || (mode == CONN_POLICY_FAST &&
+                                p->settled == CONN_POLICY_NONE &&
+                                params_are_fast(p));
+}
+
+// 比较期望的模式与主机已接受的模式，需要时生成请求
+static bool evaluate(conn_policy_t *p, int64_t now_us, conn_params_t *request) {
+  if (!p->connected || p->pending || now_us < p->retry_us) {
+    return false;
+  }
+  conn_policy_mode_t mode = desired_mode(p, now_us);
+  if (satisfied(p, mode)) {
+    return false;
+  }
+  if (mode == CONN_POLICY_FAST) {
+    *request = p->relaxed ? p->fast_relaxed : p->fast;
+  } else {
+    *request = p->slow;
+  }
+  p->pending = true;
+  p->pending_mode = mode;
+  p->request_us = now_us;
+  return true;
+}
+
+// 请求被拒绝或超时：快速参数先放宽重试一次，之后按指数退避重试
+static void rejected(conn_policy_t *p, int64_t now_us) {
+  p->rejects++;
+  if (p->pending_mode == CONN_POLICY_FAST && !p->relaxed) {
+    p->relaxed = true;
+    return;
+  }
+  p->retry_us = now_us + p->backoff_us;
+  p->backoff_us = p->backoff_us * 2 > p->backoff_max_us ? p->backoff_max_us
+                                                         : p->backoff_us * 2;
+}
+
+bool conn_policy_connected(conn_policy_t *p, int64_t now_us, uint16_t interval,
+                           uint16_t latency, uint16_t timeout,
+                           conn_params_t *request) {
+  p->connected = true;
+  p->pending = false;
+  p->settled = CONN_POLICY_NONE;
+  p->relaxed = false;
+  p->interval = interval;
+  p->latency = latency;
+  p->timeout = timeout;
+  p->last_activity_us = now_us;  // 连接后先保持快速，便于完成服务发现
+  p->retry_us = 0;
+  p->backoff_us = p->backoff_min_us;
+  memset(&p->accepted, 0, sizeof(p->accepted));
+  return evaluate(p, now_us, request);
+}
+
+void conn_policy_disconnected(conn_policy_t *p) {
+  p->connected = false;
+  p->pending = false;
+  p->settled = CONN_POLICY_NONE;
+}
+
+bool conn_policy_activity(conn_policy_t *p, int64_t now_us,
+                          conn_params_t *request) {
+  p->last_activity_us = now_us;
+  return evaluate(p, now_us, request);
+}
+
+bool conn_policy_updated(conn_policy_t *p, int64_t now_us, bool success,
+                         uint16_t interval, uint16_t latency, uint16_t timeout,
+                         conn_params_t *request) {
+  if (!p->connected) {
+    return false;
+  }
+  if (success) {
+    p->interval = interval;
+    p->latency = latency;
+    p->timeout = timeout;
+    if (p->pending) {
+      // 主机可能在请求范围内选择了别的值，同样视为接受
+      p->settled = p->pending_mode;
+      p->backoff_us = p->backoff_min_us;
+      if (p->pending_mode == CONN_POLICY_FAST) {
+        // 下次连接同一主机时直接请求这组参数，省去被拒绝后放宽的往返
+        p->accepted = (conn_params_t){interval, interval, latency, timeout};
+      }
+    } else {
+      // 主机主动修改了参数
+      p->settled = CONN_POLICY_NONE;
+    }
+  } else if (p->pending) {
+    rejected(p, now_us);
+  }
+  p->pending = false;
+  return evaluate(p, now_us, request);
+}
+
+bool conn_policy_poll(conn_policy_t *p, int64_t now_us,
+                      conn_params_t *request) {
+  if (p->pending && now_us - p->request_us >= p->pending_timeout_us) {
+    p->pending = false;
+    rejected(p, now_us);
+  }
+  return evaluate(p, now_us, request);
+}
+
+int64_t conn_policy_next_deadline(const conn_policy_t *p, int64_t now_us) {
+  if (!p->connected) {
+    return 0;
+  }
+  if (p->pending) {
+    return p->request_us + p->pending_timeout_us;
+  }
+  int64_t deadline = now_us;
+  if (satisfied(p, desired_mode(p, now_us))) {
+    if (p->settled == CONN_POLICY_SLOW) {
+      return 0;  // 只有按键活动会改变期望的模式
+    }
+    deadline = p->last_activity_us + p->idle_timeout_us;
+  }
+  return deadline > p->retry_us ? deadline : p->retry_us;
+}
@@ -0,0 +1,86 @@
+#ifndef CONN_POLICY_H
+#define CONN_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 连接参数策略：有按键活动时使用短连接间隔、从机延迟为 0，
+// 空闲一段时间后切换到长间隔、大从机延迟以降低射频功耗
+// 只包含决策逻辑，不调用蓝牙协议栈：每个输入返回是否需要发起请求及请求的参数，
+// 由调用者发出请求并把结果交回，便于在主机上用假的 GAP 层驱动
+
+// 连接参数，间隔单位 1.25ms，超时单位 10ms
+typedef struct {
+  uint16_t min_int;
+  uint16_t max_int;
+  uint16_t latency;
+  uint16_t timeout;
+} conn_params_t;
+
+typedef enum {
+  CONN_POLICY_NONE = 0,  // 未连接，或当前参数不是本策略请求的
+  CONN_POLICY_FAST,      // 打字时：短间隔，无从机延迟
+  CONN_POLICY_SLOW,      // 空闲时：长间隔，大从机延迟
+} conn_policy_mode_t;
+
+typedef struct {
+  // 配置
+  conn_params_t fast;          // 首选的快速参数
+  conn_params_t fast_relaxed;  // 快速参数被拒绝后放宽的参数
+  conn_params_t slow;
+  int64_t idle_timeout_us;     // 最后一次按键之后多久切换到慢速参数
+  int64_t pending_timeout_us;  // 请求无响应时视为被拒绝
+  uint32_t backoff_min_us;     // 被拒绝后的重试间隔，每次加倍
+  uint32_t backoff_max_us;
+
+  // 状态
+  bool connected;
+  bool pending;                    // 有未完成的请求
+  conn_policy_mode_t pending_mode;
+  conn_policy_mode_t settled;      // 主机已接受的模式
+  bool relaxed;                    // 快速参数已放宽
+  uint16_t interval;               // 当前实际连接间隔
+  uint16_t latency;
+  uint16_t timeout;
+  int64_t last_activity_us;
+  int64_t request_us;              // 当前请求发出的时间
+  int64_t retry_us;                // 被拒绝后最早的重试时间
+  uint32_t backoff_us;
+  uint32_t rejects;                // 累计被拒绝次数
+  conn_params_t accepted;          // 本次连接中主机接受的快速参数，间隔为 0 表示没有
+} conn_policy_t;
+
+// 使用默认参数初始化：7.5ms/0 与 60~80ms/24，空闲 idle_timeout_us 后切换
+void conn_policy_init(conn_policy_t *p, int64_t idle_timeout_us);
+
+// 设置首选的快速参数，例如该主机上次接受的参数，NULL 恢复默认值
+// 放宽的参数不变，从下一次请求开始生效
+void conn_policy_set_fast(conn_policy_t *p, const conn_params_t *fast);
+
+// 以下函数返回 true 时，调用者应以 *request 发起参数更新请求
+
+// 连接建立，传入连接时的参数
+bool conn_policy_connected(conn_policy_t *p, int64_t now_us, uint16_t interval,
+                           uint16_t latency, uint16_t timeout,
+                           conn_params_t *request);
+
+// 连接断开
+void conn_policy_disconnected(conn_policy_t *p);
+
+// 有按键活动
+bool conn_policy_activity(conn_policy_t *p, int64_t now_us,
+                          conn_params_t *request);
+
+// 参数更新结果，包括主机主动发起的更新；失败表示主机拒绝了请求
+bool conn_policy_updated(conn_policy_t *p, int64_t now_us, bool success,
+                         uint16_t interval, uint16_t latency, uint16_t timeout,
+                         conn_params_t *request);
+
+// 定时检查空闲超时、请求超时和重试
+bool conn_policy_poll(conn_policy_t *p, int64_t now_us,
+                      conn_params_t *request);
+
+// 下一次需要调用 conn_policy_poll 的时间，没有时返回 0
+int64_t conn_policy_next_deadline(const conn_policy_t *p, int64_t now_us);
+
+#endif /* CONN_POLICY_H */
@@ -0,0 +1,102 @@
+#include "consumer_report.h"
+
+#include <string.h>
+
+// 用途码对应的报告字段
+typedef enum {
+  CC_FIELD_NONE = 0,
+  CC_FIELD_CHANNEL,
+  CC_FIELD_VOLUME,
+  CC_FIELD_BUTTON,
+} cc_field_t;
+
+// 用途码到字段和取值的查找表，编码时一次下标访问
+typedef struct {
+  uint8_t field;  // cc_field_t
+  int8_t value;   // 频道为相对值，音量为位掩码，媒体按键为数组序号
+} cc_usage_entry_t;
+
+#define HID_CC_VOLUME_ENTRY(bit, usage) [(usage)] = {CC_FIELD_VOLUME, 1 << (bit)},
+#define HID_CC_BUTTON_ENTRY(index, usage) \
+  [(usage)] = {CC_FIELD_BUTTON, (index)},
+
+static const cc_usage_entry_t s_usage_map[256] = {
+    [HID_CONSUMER_CHANNEL_UP] = {CC_FIELD_CHANNEL, 1},
+    [HID_CONSUMER_CHANNEL_DOWN] = {CC_FIELD_CHANNEL, -1},
+    HID_CC_VOLUME_USAGES(HID_CC_VOLUME_ENTRY)
+    HID_CC_BUTTON_USAGES(HID_CC_BUTTON_ENTRY)};
+
+// 媒体按键序号必须能放进 4 位数组字段，且用途码能用单字节 Usage 条目表示
+#define HID_CC_BUTTON_CHECK(index, usage)                            \
+  _Static_assert((index) < (1 << HID_CONSUMER_INPUT_BUTTONS_SIZE) &&  \
+                     (usage) <= 0xFF,                                 \
+                 "consumer button usage does not fit the report layout");
+HID_CC_BUTTON_USAGES(HID_CC_BUTTON_CHECK)
+
+// 频道加减没有自己的字段，编码为描述符中 Channel 字段的相对值 +1/-1
+#define HID_CC_CHANNEL_CHECK(index, usage)                             \
+  _Static_assert((usage) == HID_CONSUMER_CHANNEL &&                    \
+                     HID_CONSUMER_INPUT_CHANNEL_SIZE >= 2,             \
+                 "channel up/down need a relative Channel field");
+HID_CONSUMER_INPUT_CHANNEL_USAGES(HID_CC_CHANNEL_CHECK)
+
+static uint16_t s_active[CONSUMER_REPORT_MAX_ACTIVE];  // 按下顺序
+static uint8_t s_num_active = 0;
+
+static const cc_usage_entry_t *lookup(uint16_t usage) {
+  if (usage >= sizeof(s_usage_map) / sizeof(s_usage_map[0]) ||
+      s_usage_map[usage].field == CC_FIELD_NONE) {
+    return NULL;
+  }
+  return &s_usage_map[usage];
+}
+
+bool consumer_report_supported(uint16_t usage) { return lookup(usage) != NULL; }
+
+bool consumer_report_press(uint16_t usage) {
+  if (lookup(usage) == NULL) {
+    return false;
+  }
+  // 重复按下时移到最后，成为字段的当前值
+  consumer_report_release(usage);
+  if (s_num_active == CONSUMER_REPORT_MAX_ACTIVE) {
+    return false;
+  }
+  s_active[s_num_active++] = usage;
+  return true;
+}
+
+bool consumer_report_release(uint16_t usage) {
+  for (int i = 0; i < s_num_active; i++) {
+    if (s_active[i] == usage) {
+      memmove(&s_active[i], &s_active[i + 1],
+              (s_num_active - i - 1) * sizeof(s_active[0]));
+      s_num_active--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void consumer_report_reset(void) { s_num_active = 0; }
+
+void consumer_report_encode(uint8_t report[HID_CC_IN_RPT_LEN]) {
+  hid_consumer_input_t r = {0};
+
+  // 按下顺序写入，同一字段后按下的覆盖先按下的
+  for (int i = 0; i < s_num_active; i++) {
+    const cc_usage_entry_t *entry = &s_usage_map[s_active[i]];
+    switch (entry->field) {
+      case CC_FIELD_CHANNEL:
+        r.channel = entry->value;
+        break;
+      case CC_FIELD_VOLUME:
+        r.volume |= entry->value;
+        break;
+      case CC_FIELD_BUTTON:
+        r.buttons = entry->value;
+        break;
+    }
+  }
+  hid_consumer_input_pack(&r, report);
+}
@@ -0,0 +1,80 @@
+#ifndef CONSUMER_REPORT_H
+#define CONSUMER_REPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hid_report_maps.h"
+
+// Consumer Control 输入报告，布局由 src/hid_report_maps.hid 生成
+#define HID_RPT_ID_CC_IN HID_RPT_ID_CONSUMER
+#define HID_CC_IN_RPT_LEN HID_CONSUMER_INPUT_LEN
+
+// HID Consumer Usage IDs (subset of the codes available in the USB HID Usage
+// Tables spec)
+#define HID_CONSUMER_POWER 48  // Power
+#define HID_CONSUMER_RESET 49  // Reset
+#define HID_CONSUMER_SLEEP 50  // Sleep
+
+#define HID_CONSUMER_MENU 64           // Menu
+#define HID_CONSUMER_SELECTION 128     // Selection
+#define HID_CONSUMER_ASSIGN_SEL 129    // Assign Selection
+#define HID_CONSUMER_MODE_STEP 130     // Mode Step
+#define HID_CONSUMER_RECALL_LAST 131   // Recall Last
+#define HID_CONSUMER_CHANNEL 134       // Channel
+#define HID_CONSUMER_QUIT 148          // Quit
+#define HID_CONSUMER_HELP 149          // Help
+#define HID_CONSUMER_CHANNEL_UP 156    // Channel Increment
+#define HID_CONSUMER_CHANNEL_DOWN 157  // Channel Decrement
+
+#define HID_CONSUMER_PLAY 176           // Play
+#define HID_CONSUMER_PAUSE 177          // Pause
+#define HID_CONSUMER_RECORD 178         // Record
+#define HID_CONSUMER_FAST_FORWARD 179   // Fast Forward
+#define HID_CONSUMER_REWIND 180         // Rewind
+#define HID_CONSUMER_SCAN_NEXT_TRK 181  // Scan Next Track
+#define HID_CONSUMER_SCAN_PREV_TRK 182  // Scan Previous Track
+#define HID_CONSUMER_STOP 183           // Stop
+#define HID_CONSUMER_EJECT 184          // Eject
+#define HID_CONSUMER_RANDOM_PLAY 185    // Random Play
+#define HID_CONSUMER_SELECT_DISC 186    // Select Disk
+#define HID_CONSUMER_ENTER_DISC 187     // Enter Disc
+#define HID_CONSUMER_REPEAT 188         // Repeat
+#define HID_CONSUMER_STOP_EJECT 204     // Stop/Eject
+#define HID_CONSUMER_PLAY_PAUSE 205     // Play/Pause
+#define HID_CONSUMER_PLAY_SKIP 206      // Play/Skip
+
+#define HID_CONSUMER_VOLUME 224       // Volume
+#define HID_CONSUMER_BALANCE 225      // Balance
+#define HID_CONSUMER_MUTE 226         // Mute
+#define HID_CONSUMER_BASS 227         // Bass
+#define HID_CONSUMER_VOLUME_UP 233    // Volume Increment
+#define HID_CONSUMER_VOLUME_DOWN 234  // Volume Decrement
+
+// 报告字段（见 hid_consumer_input_t）：数字键盘、频道 (相对值 -1/+1)、
+// 音量加减位、媒体按键 (数组)、选择。媒体按键和音量的用途列表由描述符
+// 生成，增加媒体按键只需要修改 hid_report_maps.hid
+#define HID_CC_BUTTON_USAGES HID_CONSUMER_INPUT_BUTTONS_USAGES
+#define HID_CC_VOLUME_USAGES HID_CONSUMER_INPUT_VOLUME_USAGES
+
+// 同时按住的 Consumer 按键数上限
+#ifndef CONSUMER_REPORT_MAX_ACTIVE
+#define CONSUMER_REPORT_MAX_ACTIVE 8
+#endif
+
+// 报告中是否有该用途对应的字段
+bool consumer_report_supported(uint16_t usage);
+
+// 按下/释放一个用途，不支持的用途或超过同时按住上限时返回 false
+// 可以同时按住多个用途：音量加减各占一位，可同时置位；
+// 频道和媒体按键字段各只能容纳一个值，以最后按下的为准
+bool consumer_report_press(uint16_t usage);
+bool consumer_report_release(uint16_t usage);
+
+// 清空所有按住的用途，连接断开时调用
+void consumer_report_reset(void);
+
+// 按当前按住的用途生成报告
+void consumer_report_encode(uint8_t report[HID_CC_IN_RPT_LEN]);
+
+#endif /* CONSUMER_REPORT_H */
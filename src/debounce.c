@@ -0,0 +1,70 @@
+#include "debounce.h"
+
+#include <string.h>
+
+void debounce_init(debounce_t *db, uint8_t num_rows, debounce_mode_t mode) {
+  memset(db, 0, sizeof(*db));
+  db->num_rows = num_rows > DEBOUNCE_MAX_ROWS ? DEBOUNCE_MAX_ROWS : num_rows;
+  if (mode == DEBOUNCE_EAGER) {
+    memset(db->eager, 0xFF, sizeof(db->eager));
+  }
+}
+
+void debounce_set_mode(debounce_t *db, uint8_t row, uint8_t col,
+                       debounce_mode_t mode) {
+  if (row >= db->num_rows || col >= sizeof(matrix_row_t) * 8) {
+    return;
+  }
+  if (mode == DEBOUNCE_EAGER) {
+    db->eager[row] |= (matrix_row_t)(1u << col);
+  } else {
+    db->eager[row] &= (matrix_row_t)~(1u << col);
+  }
+}
+
+bool debounce_update(debounce_t *db, const matrix_row_t *raw,
+                     matrix_row_t *changed) {
+  matrix_row_t any_changed = 0;
+  uint8_t head = db->head;
+
+  for (int row = 0; row < db->num_rows; row++) {
+    matrix_row_t sample = raw[row];
+    matrix_row_t state = db->state[row];
+
+    // 之前 DEBOUNCE_SAMPLES - 1 次采样的按位与/或
+    matrix_row_t all_prev = (matrix_row_t)~0;
+    matrix_row_t any_prev = 0;
+    for (int i = 0; i < DEBOUNCE_SAMPLES; i++) {
+      if (i != head) {
+        all_prev &= db->history[i][row];
+        any_prev |= db->history[i][row];
+      }
+    }
+    db->history[head][row] = sample;
+
+    // 立即确认：之前的采样都等于当前状态时，第一个不同的采样直接生效
+    matrix_row_t stable = (state & all_prev) | (matrix_row_t)(~state & ~any_prev);
+    matrix_row_t next = state ^ ((sample ^ state) & stable & db->eager[row]);
+
+    // 延迟确认：包含本次在内的整个窗口一致时采用该值，也用于纠正干扰脉冲
+    next = (next | (all_prev & sample)) & (any_prev | sample);
+
+    changed[row] = next ^ state;
+    db->state[row] = next;
+    any_changed |= changed[row];
+  }
+
+  db->head = (uint8_t)((head + 1) % DEBOUNCE_SAMPLES);
+  return any_changed != 0;
+}
+
+bool debounce_is_idle(const debounce_t *db) {
+  matrix_row_t any = 0;
+  for (int row = 0; row < db->num_rows; row++) {
+    any |= db->state[row];
+    for (int i = 0; i < DEBOUNCE_SAMPLES; i++) {
+      any |= db->history[i][row];
+    }
+  }
+  return any == 0;
+}
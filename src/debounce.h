@@ -0,0 +1,47 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 一行按键的位图，第 n 位对应第 n 列，最多 16 列
+typedef uint16_t matrix_row_t;
+
+// 最大行数
+#define DEBOUNCE_MAX_ROWS 16
+
+// 消抖采样窗口（帧数），1 kHz 扫描时即毫秒数
+#ifndef DEBOUNCE_SAMPLES
+#define DEBOUNCE_SAMPLES 5
+#endif
+
+// 消抖算法
+typedef enum {
+  DEBOUNCE_DEFERRED = 0,  // 延迟确认：窗口内采样全部一致后才改变状态
+  DEBOUNCE_EAGER,         // 立即确认：稳定后的第一个边沿立即生效，之后窗口内锁定
+} debounce_mode_t;
+
+// 消抖状态：所有按键按位并行处理，每行一个字
+typedef struct {
+  uint8_t num_rows;
+  uint8_t head;                                              // 最旧采样的位置
+  matrix_row_t state[DEBOUNCE_MAX_ROWS];                     // 消抖后的状态
+  matrix_row_t eager[DEBOUNCE_MAX_ROWS];                     // 立即确认的按键
+  matrix_row_t history[DEBOUNCE_SAMPLES][DEBOUNCE_MAX_ROWS];  // 原始采样环
+} debounce_t;
+
+// 初始化，所有按键使用同一种算法
+void debounce_init(debounce_t *db, uint8_t num_rows, debounce_mode_t mode);
+
+// 设置单个按键的消抖算法
+void debounce_set_mode(debounce_t *db, uint8_t row, uint8_t col,
+                       debounce_mode_t mode);
+
+// 输入一帧原始采样，输出每行的按下/释放边沿，有边沿时返回 true
+bool debounce_update(debounce_t *db, const matrix_row_t *raw,
+                     matrix_row_t *changed);
+
+// 所有按键已释放且采样窗口内没有抖动
+bool debounce_is_idle(const debounce_t *db);
+
+#endif /* DEBOUNCE_H */
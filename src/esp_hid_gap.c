@@ -14,6 +14,9 @@
 #include "freertos/semphr.h"
 
 #include "esp_hid_gap.h"
+#include "ad_parser.h"
+#include "boot_timeline.h"
+#include "scan_index.h"
 
 static const char *TAG = "ESP_HID_GAP";
 
@@ -21,17 +24,31 @@ static const char *TAG = "ESP_HID_GAP";
 #define GAP_DBG_PRINTF(...) //printf(__VA_ARGS__)
 //static const char * gap_bt_prop_type_names[5] = {"","BDNAME","COD","RSSI","EIR"};
 
-static esp_hid_scan_result_t *bt_scan_results = NULL;
-static size_t num_bt_scan_results = 0;
-
-static esp_hid_scan_result_t *ble_scan_results = NULL;
-static size_t num_ble_scan_results = 0;
+// BT and BLE results of the scan in progress, allocated once per scan
+static scan_index_t *scan_index = NULL;
+
+// Streaming scan: filter, callback and stop condition of esp_hid_scan_stream()
+static const esp_hid_scan_filter_t *scan_filter = NULL;
+static esp_hid_scan_cb_t scan_cb = NULL;
+static void *scan_cb_arg = NULL;
+static size_t scan_max_results = 0;
+static size_t scan_num_reported = 0;
+static bool scan_reported[SCAN_INDEX_MAX_RESULTS];
+static esp_hid_transport_t scan_transport = ESP_HID_TRANSPORT_BLE;  // phase in progress
+static volatile bool scan_stopping = false;
+#if CONFIG_BT_BLE_ENABLED
+static bool ble_scan_finished = false;
+#endif
 
 static SemaphoreHandle_t bt_hidh_cb_semaphore = NULL;
 #define WAIT_BT_CB() xSemaphoreTake(bt_hidh_cb_semaphore, portMAX_DELAY)
 #define SEND_BT_CB() xSemaphoreGive(bt_hidh_cb_semaphore)
 
 static SemaphoreHandle_t ble_hidh_cb_semaphore = NULL;
+
+#if CONFIG_BT_BLE_ENABLED
+static esp_gap_ble_cb_t ble_gap_event_hook = NULL;
+#endif
 #define WAIT_BLE_CB() xSemaphoreTake(ble_hidh_cb_semaphore, portMAX_DELAY)
 #define SEND_BLE_CB() xSemaphoreGive(ble_hidh_cb_semaphore)
 
@@ -108,46 +125,73 @@ const char *esp_ble_key_type_str(esp_ble_key_type_t key_type)
 
 void esp_hid_scan_results_free(esp_hid_scan_result_t *results)
 {
-    esp_hid_scan_result_t *r = NULL;
-    while (results) {
-        r = results;
-        results = results->next;
-        if (r->name != NULL) {
-            free((char *)r->name);
-        }
-        free(r);
-    }
+    // results and names live inside the scan index that starts at the list head
+    free(results);
 }
 
 #if (CONFIG_BT_HID_DEVICE_ENABLED || CONFIG_BT_BLE_ENABLED)
-static esp_hid_scan_result_t *find_scan_result(esp_bd_addr_t bda, esp_hid_scan_result_t *results)
+static bool scan_filter_match(esp_hid_transport_t transport, uint16_t uuid16, uint16_t appearance, int rssi, const uint8_t *name, uint8_t name_len)
 {
-    esp_hid_scan_result_t *r = results;
-    while (r) {
-        if (memcmp(bda, r->bda, sizeof(esp_bd_addr_t)) == 0) {
-            return r;
+    const esp_hid_scan_filter_t *f = scan_filter;
+    if (f == NULL) {
+        return true;
+    }
+    if (f->uuid16 && uuid16 != f->uuid16) {
+        return false;
+    }
+    if (f->appearance && (transport != ESP_HID_TRANSPORT_BLE || appearance != f->appearance)) {
+        return false;
+    }
+    if (f->rssi_min && rssi < f->rssi_min) {
+        return false;
+    }
+    if (f->name_prefix) {
+        size_t prefix_len = strlen(f->name_prefix);
+        if (name == NULL || name_len < prefix_len || memcmp(name, f->name_prefix, prefix_len) != 0) {
+            return false;
         }
-        r = r->next;
     }
-    return NULL;
+    return true;
+}
+
+static void scan_stop(void)
+{
+    scan_stopping = true;
+#if CONFIG_BT_BLE_ENABLED
+    if (scan_transport == ESP_HID_TRANSPORT_BLE) {
+        esp_ble_gap_stop_scanning();
+    }
+#endif
+#if CONFIG_BT_HID_DEVICE_ENABLED
+    if (scan_transport == ESP_HID_TRANSPORT_BT) {
+        esp_bt_gap_cancel_discovery();
+    }
+#endif
+}
+
+// Hand a newly resolved device to the streaming callback, at most once per device
+static void scan_report(esp_hid_scan_result_t *r)
+{
+    size_t i = r - scan_index->results;
+    if (scan_cb == NULL || scan_stopping || scan_reported[i]) {
+        return;
+    }
+    scan_reported[i] = true;
+    scan_num_reported++;
+    if (!scan_cb(r, scan_cb_arg) || (scan_max_results && scan_num_reported >= scan_max_results)) {
+        scan_stop();
+    }
 }
 #endif /* (CONFIG_BT_HID_DEVICE_ENABLED || CONFIG_BT_BLE_ENABLED) */
 
 #if CONFIG_BT_HID_DEVICE_ENABLED
-static void add_bt_scan_result(esp_bd_addr_t bda, esp_bt_cod_t *cod, esp_bt_uuid_t *uuid, uint8_t *name, uint8_t name_len, int rssi)
+static void add_bt_scan_result(esp_bd_addr_t bda, esp_bt_cod_t *cod, esp_bt_uuid_t *uuid, const uint8_t *name, uint8_t name_len, int rssi)
 {
-    esp_hid_scan_result_t *r = find_scan_result(bda, bt_scan_results);
+    esp_hid_scan_result_t *r = scan_index_find(scan_index, bda, ESP_HID_TRANSPORT_BT);
     if (r) {
         //Some info may come later
         if (r->name == NULL && name && name_len) {
-            char *name_s = (char *)malloc(name_len + 1);
-            if (name_s == NULL) {
-                ESP_LOGE(TAG, "Malloc result name failed!");
-                return;
-            }
-            memcpy(name_s, name, name_len);
-            name_s[name_len] = 0;
-            r->name = (const char *)name_s;
+            r->name = scan_index_name(scan_index, name, name_len);
         }
         if (r->bt.uuid.len == 0 && uuid->len) {
             memcpy(&r->bt.uuid, uuid, sizeof(esp_bt_uuid_t));
@@ -155,71 +199,53 @@ static void add_bt_scan_result(esp_bd_addr_t bda, esp_bt_cod_t *cod, esp_bt_uuid
         if (rssi != 0) {
             r->rssi = rssi;
         }
+        // a name or UUID that arrived late may make the device match now
+        if (scan_cb && scan_filter_match(ESP_HID_TRANSPORT_BT, r->bt.uuid.len == ESP_UUID_LEN_16 ? r->bt.uuid.uuid.uuid16 : 0, 0,
+                                         r->rssi, (const uint8_t *)r->name, r->name ? strlen(r->name) : 0)) {
+            scan_report(r);
+        }
         return;
     }
 
-    r = (esp_hid_scan_result_t *)malloc(sizeof(esp_hid_scan_result_t));
+    bool created = false;
+    bool match = scan_filter_match(ESP_HID_TRANSPORT_BT, uuid->len == ESP_UUID_LEN_16 ? uuid->uuid.uuid16 : 0, 0,
+                                   rssi, name, name_len);
+    // in streaming mode only matching devices are stored
+    if (cod->major != ESP_BT_COD_MAJOR_DEV_PERIPHERAL || (scan_cb && !match)) {
+        return;
+    }
+    r = scan_index_insert(scan_index, bda, ESP_HID_TRANSPORT_BT, &created);
     if (r == NULL) {
-        ESP_LOGE(TAG, "Malloc bt_hidh_scan_result_t failed!");
         return;
     }
-    r->transport = ESP_HID_TRANSPORT_BT;
-    memcpy(r->bda, bda, sizeof(esp_bd_addr_t));
     memcpy(&r->bt.cod, cod, sizeof(esp_bt_cod_t));
     memcpy(&r->bt.uuid, uuid, sizeof(esp_bt_uuid_t));
     r->usage = esp_hid_usage_from_cod((uint32_t)cod);
     r->rssi = rssi;
-    r->name = NULL;
     if (name_len && name) {
-        char *name_s = (char *)malloc(name_len + 1);
-        if (name_s == NULL) {
-            free(r);
-            ESP_LOGE(TAG, "Malloc result name failed!");
-            return;
-        }
-        memcpy(name_s, name, name_len);
-        name_s[name_len] = 0;
-        r->name = (const char *)name_s;
+        r->name = scan_index_name(scan_index, name, name_len);
     }
-    r->next = bt_scan_results;
-    bt_scan_results = r;
-    num_bt_scan_results++;
+    scan_report(r);
 }
 #endif
 
 #if CONFIG_BT_BLE_ENABLED
-static void add_ble_scan_result(esp_bd_addr_t bda, esp_ble_addr_type_t addr_type, uint16_t appearance, uint8_t *name, uint8_t name_len, int rssi)
+static void add_ble_scan_result(esp_bd_addr_t bda, esp_ble_addr_type_t addr_type, uint16_t appearance, const uint8_t *name, uint8_t name_len, int rssi)
 {
-    if (find_scan_result(bda, ble_scan_results)) {
-        ESP_LOGW(TAG, "Result already exists!");
+    bool created = false;
+    esp_hid_scan_result_t *r = scan_index_insert(scan_index, bda, ESP_HID_TRANSPORT_BLE, &created);
+    if (r == NULL || !created) {
+        // full, or already seen: repeated advertisements carry nothing new
         return;
     }
-    esp_hid_scan_result_t *r = (esp_hid_scan_result_t *)malloc(sizeof(esp_hid_scan_result_t));
-    if (r == NULL) {
-        ESP_LOGE(TAG, "Malloc ble_hidh_scan_result_t failed!");
-        return;
-    }
-    r->transport = ESP_HID_TRANSPORT_BLE;
-    memcpy(r->bda, bda, sizeof(esp_bd_addr_t));
     r->ble.appearance = appearance;
     r->ble.addr_type = addr_type;
     r->usage = esp_hid_usage_from_appearance(appearance);
     r->rssi = rssi;
-    r->name = NULL;
     if (name_len && name) {
-        char *name_s = (char *)malloc(name_len + 1);
-        if (name_s == NULL) {
-            free(r);
-            ESP_LOGE(TAG, "Malloc result name failed!");
-            return;
-        }
-        memcpy(name_s, name, name_len);
-        name_s[name_len] = 0;
-        r->name = (const char *)name_s;
+        r->name = scan_index_name(scan_index, name, name_len);
     }
-    r->next = ble_scan_results;
-    ble_scan_results = r;
-    num_ble_scan_results++;
+    scan_report(r);
 }
 #endif /* CONFIG_BT_BLE_ENABLED */
 
@@ -246,7 +272,7 @@ static void handle_bt_device_result(struct disc_res_param *disc_res)
     uint32_t codv = 0;
     esp_bt_cod_t *cod = (esp_bt_cod_t *)&codv;
     int8_t rssi = 0;
-    uint8_t *name = NULL;
+    const uint8_t *name = NULL;
     uint8_t name_len = 0;
     esp_bt_uuid_t uuid;
 
@@ -259,7 +285,7 @@ static void handle_bt_device_result(struct disc_res_param *disc_res)
             GAP_DBG_PRINTF(", %s: ", gap_bt_prop_type_names[prop->type]);
         }
         if (prop->type == ESP_BT_GAP_DEV_PROP_BDNAME) {
-            name = (uint8_t *)prop->val;
+            name = (const uint8_t *)prop->val;
             name_len = strlen((const char *)name);
             GAP_DBG_PRINTF("%s", (const char *)name);
         } else if (prop->type == ESP_BT_GAP_DEV_PROP_RSSI) {
@@ -269,62 +295,39 @@ static void handle_bt_device_result(struct disc_res_param *disc_res)
             memcpy(&codv, prop->val, sizeof(uint32_t));
             GAP_DBG_PRINTF("major: %s, minor: %d, service: 0x%03x", esp_hid_cod_major_str(cod->major), cod->minor, cod->service);
         } else if (prop->type == ESP_BT_GAP_DEV_PROP_EIR) {
-            uint8_t len = 0;
-            uint8_t *data = 0;
-
-            data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_CMPL_16BITS_UUID, &len);
-            if (data == NULL) {
-                data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_INCMPL_16BITS_UUID, &len);
-            }
-            if (data && len == ESP_UUID_LEN_16) {
+            // one pass over the EIR; UUID preference stays 16 > 32 > 128 bit
+            ad_fields_t eir;
+            ad_parse((const uint8_t *)prop->val, prop->len, &eir);
+
+            ad_view_t data = ad_pick(eir.uuid16_cmpl, eir.uuid16_incmpl);
+            ad_view_t data32 = ad_pick(eir.uuid32_cmpl, eir.uuid32_incmpl);
+            ad_view_t data128 = ad_pick(eir.uuid128_cmpl, eir.uuid128_incmpl);
+            if (data.len == ESP_UUID_LEN_16) {
                 uuid.len = ESP_UUID_LEN_16;
-                uuid.uuid.uuid16 = data[0] + (data[1] << 8);
+                uuid.uuid.uuid16 = ad_u16(data);
                 GAP_DBG_PRINTF(", "); print_uuid(&uuid);
-                continue;
-            }
-
-            data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_CMPL_32BITS_UUID, &len);
-            if (data == NULL) {
-                data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_INCMPL_32BITS_UUID, &len);
-            }
-            if (data && len == ESP_UUID_LEN_32) {
-                uuid.len = len;
-                memcpy(&uuid.uuid.uuid32, data, sizeof(uint32_t));
+            } else if (data32.len == ESP_UUID_LEN_32) {
+                uuid.len = ESP_UUID_LEN_32;
+                memcpy(&uuid.uuid.uuid32, data32.data, sizeof(uint32_t));
                 GAP_DBG_PRINTF(", "); print_uuid(&uuid);
-                continue;
-            }
-
-            data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_CMPL_128BITS_UUID, &len);
-            if (data == NULL) {
-                data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_INCMPL_128BITS_UUID, &len);
-            }
-            if (data && len == ESP_UUID_LEN_128) {
-                uuid.len = len;
-                memcpy(uuid.uuid.uuid128, (uint8_t *)data, len);
+            } else if (data128.len == ESP_UUID_LEN_128) {
+                uuid.len = ESP_UUID_LEN_128;
+                memcpy(uuid.uuid.uuid128, data128.data, ESP_UUID_LEN_128);
                 GAP_DBG_PRINTF(", "); print_uuid(&uuid);
-                continue;
             }
 
             //try to find a name
-            if (name == NULL) {
-                data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_CMPL_LOCAL_NAME, &len);
-                if (data == NULL) {
-                    data = esp_bt_gap_resolve_eir_data((uint8_t *)prop->val, ESP_BT_EIR_TYPE_SHORT_LOCAL_NAME, &len);
-                }
-                if (data && len) {
-                    name = data;
-                    name_len = len;
-                    GAP_DBG_PRINTF(", NAME: ");
-                    for (int x = 0; x < len; x++) {
-                        GAP_DBG_PRINTF("%c", (char)data[x]);
-                    }
-                }
+            data = ad_pick(eir.name_cmpl, eir.name_short);
+            if (name == NULL && data.len) {
+                name = data.data;
+                name_len = data.len;
+                GAP_DBG_PRINTF(", NAME: %.*s", data.len, (const char *)data.data);
             }
         }
     }
     GAP_DBG_PRINTF("\n");
 
-    if (cod->major == ESP_BT_COD_MAJOR_DEV_PERIPHERAL || (find_scan_result(disc_res->bda, bt_scan_results) != NULL)) {
+    if (scan_index != NULL) {
         add_bt_scan_result(disc_res->bda, cod, &uuid, name, name_len, rssi);
     }
 }
@@ -333,47 +336,29 @@ static void handle_bt_device_result(struct disc_res_param *disc_res)
 #if CONFIG_BT_BLE_ENABLED
 static void handle_ble_device_result(struct ble_scan_result_evt_param *scan_rst)
 {
+    // advertising data and scan response are stored back to back; walk both once
+    ad_fields_t ad;
+    ad_parse(scan_rst->ble_adv, scan_rst->adv_data_len + scan_rst->scan_rsp_len, &ad);
 
-    uint16_t uuid = 0;
-    uint16_t appearance = 0;
-    char name[64] = {0};
-
-    uint8_t uuid_len = 0;
-    uint8_t *uuid_d = esp_ble_resolve_adv_data(scan_rst->ble_adv, ESP_BLE_AD_TYPE_16SRV_CMPL, &uuid_len);
-    if (uuid_d != NULL && uuid_len) {
-        uuid = uuid_d[0] + (uuid_d[1] << 8);
-    }
-
-    uint8_t appearance_len = 0;
-    uint8_t *appearance_d = esp_ble_resolve_adv_data(scan_rst->ble_adv, ESP_BLE_AD_TYPE_APPEARANCE, &appearance_len);
-    if (appearance_d != NULL && appearance_len) {
-        appearance = appearance_d[0] + (appearance_d[1] << 8);
-    }
-
-    uint8_t adv_name_len = 0;
-    uint8_t *adv_name = esp_ble_resolve_adv_data(scan_rst->ble_adv, ESP_BLE_AD_TYPE_NAME_CMPL, &adv_name_len);
-
-    if (adv_name == NULL) {
-        adv_name = esp_ble_resolve_adv_data(scan_rst->ble_adv, ESP_BLE_AD_TYPE_NAME_SHORT, &adv_name_len);
-    }
-
-    if (adv_name != NULL && adv_name_len) {
-        memcpy(name, adv_name, adv_name_len);
-        name[adv_name_len] = 0;
-    }
+    uint16_t uuid = ad_u16(ad.uuid16_cmpl);
+    uint16_t appearance = ad_u16(ad.appearance);
+    ad_view_t name = ad_pick(ad.name_cmpl, ad.name_short);
 
     GAP_DBG_PRINTF("BLE: " ESP_BD_ADDR_STR ", ", ESP_BD_ADDR_HEX(scan_rst->bda));
     GAP_DBG_PRINTF("RSSI: %d, ", scan_rst->rssi);
     GAP_DBG_PRINTF("UUID: 0x%04x, ", uuid);
     GAP_DBG_PRINTF("APPEARANCE: 0x%04x, ", appearance);
     GAP_DBG_PRINTF("ADDR_TYPE: '%s'", ble_addr_type_str(scan_rst->ble_addr_type));
-    if (adv_name_len) {
-        GAP_DBG_PRINTF(", NAME: '%s'", name);
+    if (name.len) {
+        GAP_DBG_PRINTF(", NAME: '%.*s'", name.len, (const char *)name.data);
     }
     GAP_DBG_PRINTF("\n");
 
-    if (uuid == ESP_GATT_UUID_HID_SVC) {
-        add_ble_scan_result(scan_rst->bda, scan_rst->ble_addr_type, appearance, adv_name, adv_name_len, scan_rst->rssi);
+    uint16_t wanted_uuid = (scan_filter && scan_filter->uuid16) ? scan_filter->uuid16 : ESP_GATT_UUID_HID_SVC;
+    // filters run on the advertisement itself, before anything is stored
+    if (uuid == wanted_uuid && scan_index != NULL && !scan_stopping &&
+            scan_filter_match(ESP_HID_TRANSPORT_BLE, uuid, appearance, scan_rst->rssi, name.data, name.len)) {
+        add_ble_scan_result(scan_rst->bda, scan_rst->ble_addr_type, appearance, name.data, name.len, scan_rst->rssi);
     }
 }
 #endif /* CONFIG_BT_BLE_ENABLED */
@@ -459,6 +444,15 @@ static esp_err_t start_bt_scan(uint32_t seconds)
  * BLE GAP
  * */
 
+// The scan ends either on timeout or after an early stop; wake the scanning task once
+static void ble_scan_done(void)
+{
+    if (!ble_scan_finished) {
+        ble_scan_finished = true;
+        SEND_BLE_CB();
+    }
+}
+
 static void ble_gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
 {
     switch (event) {
@@ -479,7 +473,7 @@ static void ble_gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_p
         }
         case ESP_GAP_SEARCH_INQ_CMPL_EVT:
             ESP_LOGV(TAG, "BLE GAP EVENT SCAN DONE: %d", scan_result->scan_rst.num_resps);
-            SEND_BLE_CB();
+            ble_scan_done();
             break;
         default:
             break;
@@ -488,6 +482,9 @@ static void ble_gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_p
     }
     case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT: {
         ESP_LOGV(TAG, "BLE GAP EVENT SCAN CANCELED");
+        if (scan_stopping) {
+            ble_scan_done();
+        }
         break;
     }
 
@@ -548,6 +545,15 @@ static void ble_gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_p
         ESP_LOGV(TAG, "BLE GAP EVENT %s", ble_gap_evt_str(event));
         break;
     }
+
+    if (ble_gap_event_hook) {
+        ble_gap_event_hook(event, param);
+    }
+}
+
+void esp_hid_ble_gap_set_event_hook(esp_gap_ble_cb_t hook)
+{
+    ble_gap_event_hook = hook;
 }
 
 static esp_err_t init_ble_gap(void)
@@ -707,24 +713,28 @@ static esp_err_t init_low_level(uint8_t mode)
         ESP_LOGE(TAG, "esp_bt_controller_init failed: %d", ret);
         return ret;
     }
+    boot_timeline_mark("bt_controller_init");
 
     ret = esp_bt_controller_enable(mode);
     if (ret) {
         ESP_LOGE(TAG, "esp_bt_controller_enable failed: %d", ret);
         return ret;
     }
+    boot_timeline_mark("bt_controller_enable");
 
     ret = esp_bluedroid_init();
     if (ret) {
         ESP_LOGE(TAG, "esp_bluedroid_init failed: %d", ret);
         return ret;
     }
+    boot_timeline_mark("bluedroid_init");
 
     ret = esp_bluedroid_enable();
     if (ret) {
         ESP_LOGE(TAG, "esp_bluedroid_enable failed: %d", ret);
         return ret;
     }
+    boot_timeline_mark("bluedroid_enable");
 #if CONFIG_BT_HID_DEVICE_ENABLED
     if (mode & ESP_BT_MODE_CLASSIC_BT) {
         ret = init_bt_gap();
@@ -783,43 +793,96 @@ esp_err_t esp_hid_gap_init(uint8_t mode)
     return ESP_OK;
 }
 
-esp_err_t esp_hid_scan(uint32_t seconds, size_t *num_results, esp_hid_scan_result_t **results)
+// Run the BLE and BT scans into a fresh index; the caller owns the index afterwards
+static esp_err_t scan_run(uint32_t seconds, scan_index_t **out)
 {
-    if (num_bt_scan_results || bt_scan_results || num_ble_scan_results || ble_scan_results) {
-        ESP_LOGE(TAG, "There are old scan results. Free them first!");
+    if (scan_index) {
+        ESP_LOGE(TAG, "A scan is already in progress!");
         return ESP_FAIL;
     }
+    scan_index_t *index = (scan_index_t *)malloc(sizeof(scan_index_t));
+    if (index == NULL) {
+        ESP_LOGE(TAG, "Malloc scan_index_t failed!");
+        return ESP_ERR_NO_MEM;
+    }
+    scan_index_init(index);
+    memset(scan_reported, 0, sizeof(scan_reported));
+    scan_num_reported = 0;
+    scan_stopping = false;
+    scan_index = index;
 
 #if CONFIG_BT_BLE_ENABLED
+    scan_transport = ESP_HID_TRANSPORT_BLE;
+    ble_scan_finished = false;
     if (start_ble_scan(seconds) == ESP_OK) {
         WAIT_BLE_CB();
     } else {
+        scan_index = NULL;
+        free(index);
         return ESP_FAIL;
     }
 #endif /* CONFIG_BT_BLE_ENABLED */
 
 #if CONFIG_BT_HID_DEVICE_ENABLED
-    if (start_bt_scan(seconds) == ESP_OK) {
+    scan_transport = ESP_HID_TRANSPORT_BT;
+    if (scan_stopping) {
+        // stop condition already met during the BLE phase
+    } else if (start_bt_scan(seconds) == ESP_OK) {
         WAIT_BT_CB();
     } else {
+        scan_index = NULL;
+        free(index);
         return ESP_FAIL;
     }
 #endif
 
-    *num_results = num_bt_scan_results + num_ble_scan_results;
-    *results = bt_scan_results;
-    if (num_bt_scan_results) {
-        while (bt_scan_results->next != NULL) {
-            bt_scan_results = bt_scan_results->next;
-        }
-        bt_scan_results->next = ble_scan_results;
-    } else {
-        *results = ble_scan_results;
+    scan_index = NULL;
+    if (index->dropped) {
+        ESP_LOGW(TAG, "Scan index full, %" PRIu32 " results or names dropped", index->dropped);
     }
+    *out = index;
+    return ESP_OK;
+}
 
-    num_bt_scan_results = 0;
-    bt_scan_results = NULL;
-    num_ble_scan_results = 0;
-    ble_scan_results = NULL;
+esp_err_t esp_hid_scan(uint32_t seconds, size_t *num_results, esp_hid_scan_result_t **results)
+{
+    scan_index_t *index = NULL;
+    esp_err_t ret = scan_run(seconds, &index);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    *num_results = index->count;
+    *results = scan_index_list(index);
+    if (*results == NULL) {
+        free(index);
+    }
     return ESP_OK;
 }
+
+esp_err_t esp_hid_scan_stream(uint32_t seconds, const esp_hid_scan_filter_t *filter, size_t max_results,
+                              esp_hid_scan_cb_t cb, void *arg, size_t *num_results)
+{
+    if (cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scan_index) {
+        ESP_LOGE(TAG, "A scan is already in progress!");
+        return ESP_FAIL;
+    }
+    scan_filter = filter;
+    scan_max_results = max_results;
+    scan_cb_arg = arg;
+    scan_cb = cb;
+
+    scan_index_t *index = NULL;
+    esp_err_t ret = scan_run(seconds, &index);
+
+    scan_cb = NULL;
+    scan_filter = NULL;
+    if (num_results) {
+        *num_results = scan_num_reported;
+    }
+    // results were only lent to the callback
+    free(index);
+    return ret;
+}
@@ -62,13 +62,46 @@ typedef struct esp_hidh_scan_result_s {
     };
 } esp_hid_scan_result_t;
 
+/*
+ * Filter for esp_hid_scan_stream(), checked before a device is stored.
+ * Zero / NULL fields match everything.
+ */
+typedef struct {
+    uint16_t uuid16;            // 16-bit service UUID; 0 keeps the default (HID service for BLE, any for BT)
+    uint16_t appearance;        // BLE appearance; BT devices never match a non-zero value
+    int8_t rssi_min;            // lowest accepted RSSI in dBm; 0 accepts any
+    const char *name_prefix;    // device name must start with this
+} esp_hid_scan_filter_t;
+
+/*
+ * Called once per matching device, from the Bluetooth stack task, as soon as the
+ * device is resolved. The result is only valid during the call. Return false to
+ * stop the scan.
+ */
+typedef bool (*esp_hid_scan_cb_t)(const esp_hid_scan_result_t *result, void *arg);
+
 esp_err_t esp_hid_gap_init(uint8_t mode);
 esp_err_t esp_hid_scan(uint32_t seconds, size_t *num_results, esp_hid_scan_result_t **results);
 void esp_hid_scan_results_free(esp_hid_scan_result_t *results);
 
+/*
+ * Scan for up to `seconds`, delivering each deduplicated device that passes
+ * `filter` (may be NULL) to `cb`. The scan ends early once `max_results` devices
+ * have been delivered (0 = no limit; 1 = first match) or when `cb` returns false.
+ * Blocks the caller until the scan has stopped; `num_results` (may be NULL)
+ * receives the number of devices delivered.
+ */
+esp_err_t esp_hid_scan_stream(uint32_t seconds, const esp_hid_scan_filter_t *filter, size_t max_results,
+                              esp_hid_scan_cb_t cb, void *arg, size_t *num_results);
+
 esp_err_t esp_hid_ble_gap_adv_init(uint16_t appearance, const char *device_name);
 esp_err_t esp_hid_ble_gap_adv_start(void);
 
+#if CONFIG_BT_BLE_ENABLED
+// Forward every BLE GAP event to the application after it has been handled here
+void esp_hid_ble_gap_set_event_hook(esp_gap_ble_cb_t hook);
+#endif
+
 void print_uuid(esp_bt_uuid_t *uuid);
 const char *ble_addr_type_str(esp_ble_addr_type_t ble_addr_type);
 
@@ -0,0 +1,179 @@
+#include "hid_report.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define HID_KEY_MODIFIER_FIRST 0xE0
+#define HID_KEY_MODIFIER_LAST 0xE7
+
+// 位图按用途码编号，修饰键字节和 NKRO 报告都直接取位图中的字节
+_Static_assert(HID_KEYBOARD_INPUT_MODIFIERS_USAGE_MIN == HID_KEY_MODIFIER_FIRST &&
+                   HID_KEYBOARD_INPUT_MODIFIERS_COUNT == 8,
+               "modifier field must cover usages 0xE0..0xE7");
+_Static_assert(HID_NKRO_INPUT_KEYS_USAGE_MIN == 0 &&
+                   HID_NKRO_IN_RPT_LEN == (HID_NKRO_USAGE_MAX + 1) / 8 &&
+                   HID_NKRO_IN_RPT_LEN <= sizeof(hid_key_bitmap_t),
+               "NKRO report must be the leading bytes of the key bitmap");
+
+static hid_report_send_t s_send = NULL;
+static uint32_t s_interval_us = HID_REPORT_MIN_INTERVAL_US;
+static bool s_nkro = HID_REPORT_NKRO_ENABLED;
+static hid_key_bitmap_t s_pending;  // 当前按下的按键
+static hid_key_bitmap_t s_sent;     // 上次成功发送的报告对应的按键
+static int64_t s_last_send_us = 0;
+static bool s_resend = false;  // 上次的报告丢失，当前状态需要重新发送
+static uint32_t s_sent_count = 0;
+
+static bool bitmap_has_key(const hid_key_bitmap_t *bitmap, uint8_t keycode) {
+  return (bitmap->words[keycode >> 5] >> (keycode & 31)) & 1;
+}
+
+static void bitmap_add_key(hid_key_bitmap_t *bitmap, uint8_t keycode) {
+  if (keycode <= HID_NKRO_USAGE_MAX) {
+    bitmap->words[keycode >> 5] |= 1u << (keycode & 31);
+  }
+}
+
+static void bitmap_remove_key(hid_key_bitmap_t *bitmap, uint8_t keycode) {
+  bitmap->words[keycode >> 5] &= ~(1u << (keycode & 31));
+}
+
+static bool bitmap_equal(const hid_key_bitmap_t *a, const hid_key_bitmap_t *b) {
+  uint32_t diff = 0;
+  for (int i = 0; i < 8; i++) {
+    diff |= a->words[i] ^ b->words[i];
+  }
+  return diff == 0;
+}
+
+void hid_report_encode_6kro(const hid_key_bitmap_t *bitmap,
+                            hid_keyboard_input_t *report) {
+  int num_keys = 0;
+
+  memset(report, 0, sizeof(*report));
+  report->modifiers = bitmap->bytes[HID_KEY_MODIFIER_FIRST / 8];
+  // 按位图顺序取出普通键，结果自然按用途码升序排列
+  for (int word = 0; word < HID_KEY_MODIFIER_FIRST / 32; word++) {
+    uint32_t bits = bitmap->words[word];
+    while (bits) {
+      if (num_keys == HID_KEY_IN_MAX_KEYS) {
+        memset(report->keys, HID_KEY_ERROR_ROLLOVER, HID_KEY_IN_MAX_KEYS);
+        return;
+      }
+      report->keys[num_keys++] = (uint8_t)(word * 32 + __builtin_ctz(bits));
+      bits &= bits - 1;
+    }
+  }
+}
+
+// 主机侧的状态与当前状态一致
+static bool up_to_date(void) {
+  return !s_resend && bitmap_equal(&s_pending, &s_sent);
+}
+
+static bool send_now(int64_t now_us) {
+  if (up_to_date()) {
+    return true;
+  }
+  if (s_send == NULL) {
+    return false;
+  }
+  hid_key_bitmap_t bitmap = s_pending;
+  int err;
+  if (s_nkro) {
+    hid_nkro_input_t report;
+    uint8_t buf[HID_NKRO_IN_RPT_LEN];
+    memcpy(report.keys, bitmap.bytes, sizeof(report.keys));
+    hid_nkro_input_pack(&report, buf);
+    err = s_send(HID_RPT_ID_NKRO_IN, buf, HID_NKRO_IN_RPT_LEN);
+  } else {
+    hid_keyboard_input_t report;
+    uint8_t buf[HID_KEY_IN_RPT_LEN];
+    hid_report_encode_6kro(&bitmap, &report);
+    hid_keyboard_input_pack(&report, buf);
+    err = s_send(HID_RPT_ID_KEY_IN, buf, HID_KEY_IN_RPT_LEN);
+  }
+  if (err != 0) {
+    return false;
+  }
+  s_sent = bitmap;
+  s_last_send_us = now_us;
+  s_resend = false;
+  s_sent_count++;
+  return true;
+}
+
+void hid_report_init(hid_report_send_t send) {
+  s_send = send;
+  hid_report_reset();
+}
+
+void hid_report_set_interval(uint32_t interval_us) {
+  s_interval_us = interval_us;
+}
+
+void hid_report_set_nkro(bool nkro) {
+  nkro = nkro && HID_REPORT_NKRO_ENABLED;
+  if (nkro != s_nkro) {
+    s_nkro = nkro;
+    // 新格式的报告还没有发送过，主机侧认为所有按键已释放
+    memset(&s_sent, 0, sizeof(s_sent));
+  }
+}
+
+void hid_report_key_down(uint8_t keycode, int64_t now_us) {
+  if (keycode == 0 || keycode > HID_NKRO_USAGE_MAX ||
+      bitmap_has_key(&s_pending, keycode)) {
+    return;
+  }
+  // 这个按键的释放还没发出去，先发送，避免连按被合并掉
+  if (bitmap_has_key(&s_sent, keycode)) {
+    send_now(now_us);
+  }
+  bitmap_add_key(&s_pending, keycode);
+}
+
+void hid_report_key_up(uint8_t keycode, int64_t now_us) {
+  if (keycode == 0 || keycode > HID_NKRO_USAGE_MAX ||
+      !bitmap_has_key(&s_pending, keycode)) {
+    return;
+  }
+  // 这个按键的按下还没发出去，先发送，避免短按被合并掉
+  if (!bitmap_has_key(&s_sent, keycode)) {
+    send_now(now_us);
+  }
+  bitmap_remove_key(&s_pending, keycode);
+}
+
+void hid_report_sync(const uint8_t *keycodes, uint8_t num_keys) {
+  memset(&s_pending, 0, sizeof(s_pending));
+  for (int i = 0; i < num_keys; i++) {
+    if (keycodes[i] != 0) {
+      bitmap_add_key(&s_pending, keycodes[i]);
+    }
+  }
+}
+
+void hid_report_reset(void) {
+  memset(&s_pending, 0, sizeof(s_pending));
+  memset(&s_sent, 0, sizeof(s_sent));  // 连接建立时主机认为所有按键已释放
+  s_last_send_us = 0;
+  s_resend = false;
+}
+
+int64_t hid_report_flush(int64_t now_us) {
+  if (up_to_date()) {
+    return 0;
+  }
+  int64_t elapsed = now_us - s_last_send_us;
+  if (elapsed < s_interval_us) {
+    return s_interval_us - elapsed;
+  }
+  return send_now(now_us) ? 0 : s_interval_us;
+}
+
+bool hid_report_send_pending(int64_t now_us) { return send_now(now_us); }
+
+uint32_t hid_report_sent_count(void) { return s_sent_count; }
+
+void hid_report_resend(void) { s_resend = true; }
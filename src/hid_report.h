@@ -0,0 +1,87 @@
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 报告 ID、长度和布局由 src/hid_report_maps.hid 在构建时生成
+#include "hid_report_maps.h"
+
+// 6KRO 键盘报告，Boot 协议下使用
+#define HID_RPT_ID_KEY_IN HID_RPT_ID_KEYBOARD
+#define HID_KEY_IN_RPT_LEN HID_KEYBOARD_INPUT_LEN
+#define HID_KEY_IN_MAX_KEYS HID_KEYBOARD_INPUT_KEYS_COUNT
+
+// NKRO 键盘报告：用途码 0x00 ~ 0xE7 每个一位，修饰键位于最后一个字节
+#define HID_RPT_ID_NKRO_IN HID_RPT_ID_NKRO
+#define HID_NKRO_USAGE_MAX HID_NKRO_INPUT_KEYS_USAGE_MAX
+#define HID_NKRO_IN_RPT_LEN HID_NKRO_INPUT_LEN
+
+// 是否提供 NKRO 报告，关闭时始终使用 6KRO 报告
+#ifndef HID_REPORT_NKRO_ENABLED
+#define HID_REPORT_NKRO_ENABLED 1
+#endif
+
+// 6KRO 报告中超过 6 个按键时填入的用途码 (ErrorRollOver)
+#define HID_KEY_ERROR_ROLLOVER 0x01
+
+// 两次报告之间的最小间隔 (us)，默认等于 BLE 最小连接间隔 7.5ms
+// 间隔内的多次变化合并为一次发送
+#ifndef HID_REPORT_MIN_INTERVAL_US
+#define HID_REPORT_MIN_INTERVAL_US 7500
+#endif
+
+// 按键位图：每个用途码一位，按下/释放只改变一位
+// 前 HID_NKRO_IN_RPT_LEN 个字节即 NKRO 报告
+typedef union {
+  uint8_t bytes[32];
+  uint32_t words[8];
+} hid_key_bitmap_t;
+
+// 报告发送函数，返回 0 表示成功
+typedef int (*hid_report_send_t)(uint8_t report_id, uint8_t *data,
+                                 uint16_t len);
+
+// 初始化报告构建器
+void hid_report_init(hid_report_send_t send);
+
+// 设置合并发送的时间窗口，一般为当前连接间隔
+void hid_report_set_interval(uint32_t interval_us);
+
+// 选择报告格式：Report 协议下使用 NKRO，Boot 协议下回退到 6KRO
+// 切换后下一次发送会输出完整状态
+void hid_report_set_nkro(bool nkro);
+
+// 按键按下/释放，0xE0 ~ 0xE7 为修饰键
+// 同一个按键尚未发送的变化会先发送出去，合并不会吞掉短按
+void hid_report_key_down(uint8_t keycode, int64_t now_us);
+void hid_report_key_up(uint8_t keycode, int64_t now_us);
+
+// 用完整的按键列表替换当前状态，不触发发送
+void hid_report_sync(const uint8_t *keycodes, uint8_t num_keys);
+
+// 清空当前状态和已发送的报告，连接断开时调用
+void hid_report_reset(void);
+
+// 已发送的报告在协议栈中丢失，主机侧状态未知，下一次发送输出当前完整状态
+// 丢失的可能是最后的全部释放报告，即使当前状态没有变化也会重新发送
+void hid_report_resend(void);
+
+// 当前状态与上次发送的报告不同时发送
+// 返回距离下次允许发送还需等待的时间 (us)，0 表示没有待发送的内容
+int64_t hid_report_flush(int64_t now_us);
+
+// 不等待合并窗口，立即发送当前状态，由调用方控制发送节奏
+// 返回 false 表示发送失败，状态保留，之后再次调用会重试
+bool hid_report_send_pending(int64_t now_us);
+
+// 累计交给发送函数的报告数，调用方用前后差值统计实际发送的报告
+// 状态没有变化时发送函数不会被调用，不计入
+uint32_t hid_report_sent_count(void);
+
+// 由按键位图生成 6KRO 报告，按键码升序排列，未使用的位置为 0
+// 超过 6 个按键时按键位置全部为 ErrorRollOver
+void hid_report_encode_6kro(const hid_key_bitmap_t *bitmap,
+                            hid_keyboard_input_t *report);
+
+#endif /* HID_REPORT_H */
@@ -0,0 +1,290 @@
+#include "host_profile.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "ble_conn_params.h"
+#include "ble_reconnect.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "keymap.h"
+#include "nvs.h"
+
+_Static_assert(HOST_PROFILE_MAX > 0 && HOST_PROFILE_MAX <= 10,
+               "profile index must fit in 4 bits and a one-digit NVS key");
+
+// NVS 中保存的配置，格式变化时增加版本号，旧版本的配置视为空
+#define PROFILE_VERSION 1
+
+typedef struct {
+  uint8_t version;
+  bool has_host;
+  esp_bd_addr_t host;    // 绑定列表中的主机地址
+  uint16_t layers;       // TG 打开的层
+  conn_params_t params;  // 主机接受的快速参数，间隔为 0 表示使用默认值
+} host_profile_t;
+
+static const char *TAG = "HOST_PROFILE";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static host_profile_t s_profiles[HOST_PROFILE_MAX];
+static uint8_t s_active = 0;
+static int64_t s_switch_us = 0;  // 正在进行的切换开始的时间，0 表示没有
+static uint32_t s_switches = 0;
+static uint32_t s_rejected = 0;  // 因属于其他配置而断开的连接数
+
+// 持有 s_lock 时调用，没有时返回 -1
+static int find_owner(const uint8_t *addr) {
+  for (int i = 0; i < HOST_PROFILE_MAX; i++) {
+    if (s_profiles[i].has_host &&
+        memcmp(s_profiles[i].host, addr, sizeof(esp_bd_addr_t)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// 写入一个配置和当前配置编号，内容未变的项不会重复写入 flash
+static void save(uint8_t index) {
+  char key[] = "p0";
+  key[1] += index;
+
+  portENTER_CRITICAL(&s_lock);
+  host_profile_t profile = s_profiles[index];
+  uint8_t active = s_active;
+  portEXIT_CRITICAL(&s_lock);
+
+  nvs_handle_t handle;
+  esp_err_t err =
+      nvs_open(HOST_PROFILE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "open NVS failed: %s", esp_err_to_name(err));
+    return;
+  }
+  err = nvs_set_blob(handle, key, &profile, sizeof(profile));
+  if (err == ESP_OK) {
+    err = nvs_set_u8(handle, HOST_PROFILE_NVS_ACTIVE, active);
+  }
+  if (err == ESP_OK) {
+    err = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "save profile %d failed: %s", index, esp_err_to_name(err));
+  }
+}
+
+// 按配置设置层、连接参数和重连目标
+static void apply(const host_profile_t *profile, bool set_peer) {
+  keymap_set_toggled(profile->layers);
+  ble_conn_params_set_preferred(profile->params.min_int != 0 ? &profile->params
+                                                             : NULL);
+  if (set_peer) {
+    ble_reconnect_set_peer(profile->has_host ? profile->host : NULL);
+  }
+}
+
+void host_profile_init(void) {
+  nvs_handle_t handle;
+  uint8_t active = 0;
+  bool any_host = false;
+
+  memset(s_profiles, 0, sizeof(s_profiles));
+  esp_err_t err = nvs_open(HOST_PROFILE_NVS_NAMESPACE, NVS_READONLY, &handle);
+  if (err == ESP_OK) {
+    nvs_get_u8(handle, HOST_PROFILE_NVS_ACTIVE, &active);
+    for (int i = 0; i < HOST_PROFILE_MAX; i++) {
+      char key[] = "p0";
+      key[1] += i;
+      host_profile_t profile;
+      size_t len = sizeof(profile);
+      if (nvs_get_blob(handle, key, &profile, &len) == ESP_OK &&
+          len == sizeof(profile) && profile.version == PROFILE_VERSION) {
+        s_profiles[i] = profile;
+        any_host |= profile.has_host;
+      }
+    }
+    nvs_close(handle);
+  } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(TAG, "read profiles failed: %s", esp_err_to_name(err));
+  }
+  for (int i = 0; i < HOST_PROFILE_MAX; i++) {
+    s_profiles[i].version = PROFILE_VERSION;
+  }
+  s_active = active < HOST_PROFILE_MAX ? active : 0;
+
+  // 还没有任何配置时保持原来的重连目标 (最近一次连接的已绑定主机)，
+  // 升级前绑定的主机下次完成加密时写入当前配置
+  apply(&s_profiles[s_active], any_host);
+  ESP_LOGI(TAG, "profile %d of %d", s_active, HOST_PROFILE_MAX);
+}
+
+esp_err_t host_profile_select(uint8_t index, bool forget) {
+  if (index >= HOST_PROFILE_MAX) {
+    ESP_LOGW(TAG, "no profile %d", index);
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (index == host_profile_active() && !forget &&
+      ble_reconnect_is_connected()) {
+    return ESP_OK;
+  }
+
+  uint16_t layers = keymap_toggled();
+  esp_bd_addr_t forgotten;
+  bool remove_bond = false;
+
+  portENTER_CRITICAL(&s_lock);
+  uint8_t prev = s_active;
+  bool prev_changed = prev != index && s_profiles[prev].layers != layers;
+  s_profiles[prev].layers = layers;
+  s_active = index;
+  host_profile_t *profile = &s_profiles[index];
+  if (forget && profile->has_host) {
+    memcpy(forgotten, profile->host, sizeof(forgotten));
+    remove_bond = true;
+    profile->has_host = false;
+    memset(&profile->params, 0, sizeof(profile->params));
+  }
+  host_profile_t next = *profile;
+  s_switch_us = esp_timer_get_time();
+  s_switches++;
+  portEXIT_CRITICAL(&s_lock);
+
+  ESP_LOGI(TAG, "switch to profile %d%s", index,
+           forget ? " (pairing)" : next.has_host ? "" : " (empty)");
+  apply(&next, true);
+  // 先开始重连，断开旧连接的时间与写入 flash 重叠
+  ble_reconnect_restart();
+  if (remove_bond) {
+    esp_ble_remove_bond_device(forgotten);
+  }
+  if (prev_changed) {
+    save(prev);
+  }
+  save(index);
+  return ESP_OK;
+}
+
+uint8_t host_profile_active(void) {
+  portENTER_CRITICAL(&s_lock);
+  uint8_t active = s_active;
+  portEXIT_CRITICAL(&s_lock);
+  return active;
+}
+
+// 主机接受了新的快速参数，记入当前配置，下次连接时直接请求
+static void params_updated(void) {
+  conn_params_t fast;
+  if (!ble_conn_params_accepted(&fast)) {
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  uint8_t active = s_active;
+  host_profile_t *profile = &s_profiles[active];
+  bool changed = profile->has_host &&
+                 memcmp(&profile->params, &fast, sizeof(fast)) != 0;
+  if (changed) {
+    profile->params = fast;
+  }
+  portEXIT_CRITICAL(&s_lock);
+
+  if (changed) {
+    ESP_LOGI(TAG, "profile %d prefers interval %u", active, fast.min_int);
+    save(active);
+  }
+}
+
+bool host_profile_gap_event(esp_gap_ble_cb_event_t event,
+                            esp_ble_gap_cb_param_t *param) {
+  if (event == ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT) {
+    params_updated();
+    return true;
+  }
+  if (event != ESP_GAP_BLE_AUTH_CMPL_EVT ||
+      !param->ble_security.auth_cmpl.success) {
+    return true;
+  }
+
+  const uint8_t *peer = param->ble_security.auth_cmpl.bd_addr;
+  conn_params_t fast;
+  bool has_fast = ble_conn_params_accepted(&fast);
+
+  portENTER_CRITICAL(&s_lock);
+  uint8_t active = s_active;
+  int owner = find_owner(peer);
+  host_profile_t *profile = &s_profiles[active];
+  // 只有空配置接受新主机；已有主机的配置要先用 forget 清空，
+  // 否则任何能配对的设备都可以顶替当前主机
+  bool adopt = owner < 0 && !profile->has_host;
+  if (adopt) {
+    profile->has_host = true;
+    memcpy(profile->host, peer, sizeof(profile->host));
+    if (has_fast) {
+      profile->params = fast;
+    } else {
+      memset(&profile->params, 0, sizeof(profile->params));
+    }
+  }
+  bool accepted = adopt || owner == active;
+  int64_t switch_us = accepted ? s_switch_us : 0;
+  if (accepted) {
+    s_switch_us = 0;
+  } else {
+    s_rejected++;
+  }
+  portEXIT_CRITICAL(&s_lock);
+
+  if (!accepted) {
+    if (owner < 0) {
+      ESP_LOGW(TAG, ESP_BD_ADDR_STR " is not the host of profile %d, "
+               "disconnecting", ESP_BD_ADDR_HEX(peer), active);
+    } else {
+      ESP_LOGW(TAG, ESP_BD_ADDR_STR " belongs to profile %d, disconnecting",
+               ESP_BD_ADDR_HEX(peer), owner);
+    }
+    esp_ble_gap_disconnect((uint8_t *)peer);
+    if (owner < 0) {
+      // 刚建立的绑定不属于任何配置：删除，不占用绑定列表，主机侧也不会一直重连
+      // 属于其他配置的主机保留绑定，切换回该配置时直接加密
+      esp_ble_remove_bond_device((uint8_t *)peer);
+    }
+    return false;
+  }
+  if (adopt) {
+    ESP_LOGI(TAG, "profile %d paired with " ESP_BD_ADDR_STR, active,
+             ESP_BD_ADDR_HEX(peer));
+    ble_reconnect_set_peer(peer);
+    if (!has_fast) {
+      ble_conn_params_set_preferred(NULL);
+    }
+    save(active);
+  }
+  if (switch_us != 0) {
+    ESP_LOGI(TAG, "profile %d ready %" PRId64 " ms after switch", active,
+             (esp_timer_get_time() - switch_us) / 1000);
+  }
+  return true;
+}
+
+void host_profile_print(void) {
+  host_profile_t profiles[HOST_PROFILE_MAX];
+
+  portENTER_CRITICAL(&s_lock);
+  memcpy(profiles, s_profiles, sizeof(profiles));
+  uint8_t active = s_active;
+  uint32_t switches = s_switches;
+  uint32_t rejected = s_rejected;
+  portEXIT_CRITICAL(&s_lock);
+
+  for (int i = 0; i < HOST_PROFILE_MAX; i++) {
+    if (!profiles[i].has_host) {
+      ESP_LOGI(TAG, "%c%d: empty", i == active ? '*' : ' ', i);
+      continue;
+    }
+    ESP_LOGI(TAG, "%c%d: " ESP_BD_ADDR_STR ", layers 0x%04x, interval %u",
+             i == active ? '*' : ' ', i, ESP_BD_ADDR_HEX(profiles[i].host),
+             profiles[i].layers, profiles[i].params.min_int);
+  }
+  ESP_LOGI(TAG, "switches %" PRIu32 ", rejected %" PRIu32, switches, rejected);
+}
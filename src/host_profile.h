@@ -0,0 +1,44 @@
+#ifndef HOST_PROFILE_H
+#define HOST_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_gap_ble_api.h"
+
+// 多主机配置：每个配置对应一台主机，在 NVS 中保存主机地址 (绑定密钥由协议栈
+// 保存)、主机接受的快速连接参数和 TG 打开的层
+// 切换配置时断开当前主机，立即向目标主机发高占空比定向广播 (见 ble_reconnect.h)，
+// 目标主机用已有的绑定加密，不需要重新配对或被重新发现
+// 没有主机的配置只做非定向广播，第一个完成配对且不属于其他配置的主机写入该配置；
+// 属于其他配置的主机，以及已有主机的配置上的新主机，完成配对后立即断开，
+// 不会抢占当前配置；新主机的绑定同时删除；更换主机先用 forget 清空配置
+
+// 配置个数，键位表中的编号为 0 ~ HOST_PROFILE_MAX - 1
+#ifndef HOST_PROFILE_MAX
+#define HOST_PROFILE_MAX 3
+#endif
+
+#define HOST_PROFILE_NVS_NAMESPACE "profiles"
+#define HOST_PROFILE_NVS_ACTIVE "active"  // u8 当前配置，每个配置为 blob "p0"、"p1"...
+
+// 读取 NVS 中的配置并应用当前配置
+// 在 keymap_init、ble_conn_params_init 和 ble_reconnect_init 之后调用
+void host_profile_init(void);
+
+// 切换到配置 index；forget 为 true 时同时忘记该配置的主机并删除绑定，重新配对
+// 只在发送任务中调用，由键位表中的 PROFILE 动作触发
+esp_err_t host_profile_select(uint8_t index, bool forget);
+
+uint8_t host_profile_active(void);
+
+// GAP 事件，处理配对完成和连接参数更新，在 ble_conn_params_gap_event 之后调用
+// 返回 false 表示完成配对的主机不属于当前配置，连接正在断开
+bool host_profile_gap_event(esp_gap_ble_cb_event_t event,
+                            esp_ble_gap_cb_param_t *param);
+
+// 输出各配置的主机和切换次数
+void host_profile_print(void);
+
+#endif /* HOST_PROFILE_H */
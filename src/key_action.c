@@ -0,0 +1,327 @@
+#include "key_action.h"
+
+#include <inttypes.h>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "host_profile.h"
+#include "key_typer.h"
+
+#define NO_KEY 0xFF
+#define KEY_BIT(key) ((keymap_key_mask_t)(1u << (key)))
+
+static const char *TAG = "KEY_ACTION";
+
+static key_action_emit_t s_emit = NULL;
+static bool s_muted = false;  // 重建状态时不输出键码事件
+
+// 每个按键按下时确定的动作，释放时使用
+static keymap_action_t s_held[KEYMAP_NUM_KEYS];
+static keymap_key_mask_t s_held_keys = 0;
+
+// 等待判定短按/长按的 MT/LT 键，同一时间最多一个
+static uint8_t s_tap_key = NO_KEY;
+static int64_t s_tap_deadline_us = 0;
+
+// 组合窗口内暂存的按键，按按下顺序，动作按按下时的层状态确定
+static uint8_t s_combo_order[KEYMAP_NUM_KEYS];
+static keymap_action_t s_combo_lookup[KEYMAP_NUM_KEYS];
+static uint8_t s_combo_count = 0;
+static keymap_key_mask_t s_combo_pending = 0;
+static int64_t s_combo_deadline_us = 0;
+
+// 已触发的组合：第一个成员释放时释放组合的动作，其余成员的释放被忽略
+static keymap_action_t s_combo_action[KEYMAP_MAX_COMBOS];
+static bool s_combo_pressed[KEYMAP_MAX_COMBOS];
+static keymap_key_mask_t s_combo_keys[KEYMAP_MAX_COMBOS];
+static keymap_key_mask_t s_swallow = 0;
+
+// 每次处理的耗时，只统计决策逻辑：回调 (键码输出、宏排队、主机切换) 的
+// 耗时累计在 s_callback_cycles 中，结束时扣除
+static uint32_t s_calls = 0;
+static uint32_t s_max_cycles = 0;
+static uint32_t s_callback_cycles = 0;
+
+static void emit_action(keymap_action_t action, bool pressed, int64_t now_us) {
+  keymap_output_t out[KEYMAP_MAX_OUTPUT];
+  uint8_t n = keymap_apply(action, pressed, out);
+  if (s_muted) {
+    return;
+  }
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (int i = 0; i < n; i++) {
+    s_emit(out[i].keycode, out[i].pressed, now_us);
+  }
+  s_callback_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static void macro_enqueue(uint8_t index) {
+  uint8_t steps;
+  const keymap_action_t *actions = keymap_macro(index, &steps);
+  if (actions != NULL) {
+    uint32_t start = esp_cpu_get_cycle_count();
+    key_typer_type_keys(actions, steps);
+    s_callback_cycles += esp_cpu_get_cycle_count() - start;
+  }
+}
+
+static void profile_select(keymap_action_t action) {
+  uint32_t start = esp_cpu_get_cycle_count();
+  host_profile_select(KEYMAP_ACTION_PROFILE(action),
+                      KEYMAP_ACTION_FORGET(action));
+  s_callback_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+// 按下/释放一个已确定的动作，宏和主机切换只在按下时执行
+static void action_press(keymap_action_t action, int64_t now_us) {
+  switch (KEYMAP_ACTION_KIND(action)) {
+    case KEYMAP_KIND_MACRO:
+      if (!s_muted) {
+        macro_enqueue(KEYMAP_ACTION_MACRO(action));
+      }
+      break;
+    case KEYMAP_KIND_PROFILE:
+      if (!s_muted) {
+        profile_select(action);
+      }
+      break;
+    default:
+      emit_action(action, true, now_us);
+      break;
+  }
+}
+
+static void action_release(keymap_action_t action, int64_t now_us) {
+  if (KEYMAP_ACTION_KIND(action) != KEYMAP_KIND_MACRO &&
+      KEYMAP_ACTION_KIND(action) != KEYMAP_KIND_PROFILE) {
+    emit_action(action, false, now_us);
+  }
+}
+
+// 等待判定的 MT/LT 键判定为长按
+static void tap_resolve_hold(int64_t now_us) {
+  uint8_t key = s_tap_key;
+  keymap_action_t action = s_held[key];
+  uint8_t hold = KEYMAP_ACTION_HOLD(action);
+
+  s_tap_key = NO_KEY;
+  s_held[key] = KEYMAP_ACTION_KIND(action) == KEYMAP_KIND_MT
+                    ? KEYMAP_MODS(hold, 0)
+                    : KEYMAP_MO(hold);
+  emit_action(s_held[key], true, now_us);
+}
+
+static void key_press(uint8_t key, keymap_action_t action, int64_t now_us) {
+  if (s_held_keys & KEY_BIT(key)) {
+    return;
+  }
+  // 暂存的按键逐个按下时，前面的 MT/LT 键同样判定为长按
+  if (s_tap_key != NO_KEY) {
+    tap_resolve_hold(now_us);
+  }
+  s_held[key] = action;
+  s_held_keys |= KEY_BIT(key);
+  uint8_t kind = KEYMAP_ACTION_KIND(action);
+  if (kind == KEYMAP_KIND_MT || kind == KEYMAP_KIND_LT) {
+    s_tap_key = key;
+    s_tap_deadline_us = now_us + KEY_ACTION_TAPPING_TERM_MS * 1000LL;
+    return;
+  }
+  action_press(action, now_us);
+}
+
+static void key_release(uint8_t key, int64_t now_us) {
+  if (!(s_held_keys & KEY_BIT(key))) {
+    return;
+  }
+  s_held_keys &= ~KEY_BIT(key);
+  if (key == s_tap_key) {
+    // 判定时间内释放，为短按
+    keymap_action_t tap = KEYMAP_KEY(KEYMAP_ACTION_KEYCODE(s_held[key]));
+    s_tap_key = NO_KEY;
+    emit_action(tap, true, now_us);
+    emit_action(tap, false, now_us);
+    return;
+  }
+  action_release(s_held[key], now_us);
+}
+
+// 暂存的按键按原顺序逐个按下
+static void combo_flush(int64_t now_us) {
+  uint8_t count = s_combo_count;
+  s_combo_count = 0;
+  s_combo_pending = 0;
+  for (int i = 0; i < count; i++) {
+    uint8_t key = s_combo_order[i];
+    key_press(key, s_combo_lookup[key], now_us);
+  }
+}
+
+// 暂存的按键恰好组成一个组合时执行，不再可能组成组合时逐个按下
+static void combo_update(const keymap_combo_t *combos, uint8_t num_combos,
+                         int64_t now_us) {
+  bool partial = false;
+  for (int i = 0; i < num_combos; i++) {
+    if (combos[i].keys == s_combo_pending && !s_combo_pressed[i]) {
+      s_combo_count = 0;
+      s_combo_pending = 0;
+      s_combo_action[i] = combos[i].action;
+      s_combo_keys[i] = combos[i].keys;
+      s_combo_pressed[i] = true;
+      s_swallow |= combos[i].keys;
+      action_press(combos[i].action, now_us);
+      return;
+    }
+    if ((s_combo_pending & ~combos[i].keys) == 0) {
+      partial = true;
+    }
+  }
+  if (!partial) {
+    combo_flush(now_us);
+  }
+}
+
+// 已触发组合的成员释放
+static void combo_release(uint8_t key, int64_t now_us) {
+  s_swallow &= ~KEY_BIT(key);
+  for (int i = 0; i < KEYMAP_MAX_COMBOS; i++) {
+    if (s_combo_pressed[i] && (s_combo_keys[i] & KEY_BIT(key))) {
+      s_combo_pressed[i] = false;
+      action_release(s_combo_action[i], now_us);
+    }
+  }
+}
+
+static uint32_t measure_start(void) {
+  s_callback_cycles = 0;
+  return esp_cpu_get_cycle_count();
+}
+
+static void measure(uint32_t start) {
+  uint32_t cycles = esp_cpu_get_cycle_count() - start - s_callback_cycles;
+  s_calls++;
+  if (cycles > s_max_cycles) {
+    s_max_cycles = cycles;
+  }
+}
+
+void key_action_init(key_action_emit_t emit) { s_emit = emit; }
+
+void key_action_process(const key_event_t *event, int64_t now_us) {
+  if (event->row >= ROW_NUM || event->col >= COL_NUM) {
+    return;
+  }
+  uint32_t start = measure_start();
+  uint8_t key = KEYMAP_KEY_INDEX(event->row, event->col);
+
+  uint8_t num_combos;
+  const keymap_combo_t *combos = keymap_combos(&num_combos);
+  keymap_key_mask_t members = 0;
+  for (int i = 0; i < num_combos; i++) {
+    members |= combos[i].keys;
+  }
+
+  keymap_key_mask_t bit = KEY_BIT(key);
+  if (event->pressed) {
+    // 按住 MT/LT 键期间按下其他键，判定为长按，修饰键/层作用于这个键
+    if (s_tap_key != NO_KEY && s_tap_key != key) {
+      tap_resolve_hold(now_us);
+    }
+    if ((members & bit) && !((s_held_keys | s_swallow) & bit)) {
+      if (s_combo_count == 0) {
+        s_combo_deadline_us = now_us + KEY_ACTION_COMBO_TERM_MS * 1000LL;
+      }
+      if (!(s_combo_pending & bit)) {
+        s_combo_order[s_combo_count++] = key;
+        s_combo_pending |= bit;
+        s_combo_lookup[key] = keymap_lookup(key);
+      }
+      combo_update(combos, num_combos, now_us);
+    } else {
+      combo_flush(now_us);
+      key_press(key, keymap_lookup(key), now_us);
+    }
+  } else if (s_combo_pending & bit) {
+    // 组合未凑齐就有按键释放，按普通按键处理，短按不会丢失
+    combo_flush(now_us);
+    key_release(key, now_us);
+  } else if (s_swallow & bit) {
+    combo_release(key, now_us);
+  } else {
+    key_release(key, now_us);
+  }
+  measure(start);
+}
+
+int64_t key_action_tick(int64_t now_us) {
+  if (s_combo_count == 0 && s_tap_key == NO_KEY) {
+    return 0;
+  }
+  uint32_t start = measure_start();
+  int64_t wait_us = 0;
+
+  if (s_combo_count > 0) {
+    if (now_us >= s_combo_deadline_us) {
+      combo_flush(now_us);
+    } else {
+      wait_us = s_combo_deadline_us - now_us;
+    }
+  }
+  if (s_tap_key != NO_KEY) {
+    if (now_us >= s_tap_deadline_us) {
+      tap_resolve_hold(now_us);
+    } else if (wait_us == 0 || s_tap_deadline_us - now_us < wait_us) {
+      wait_us = s_tap_deadline_us - now_us;
+    }
+  }
+  measure(start);
+  return wait_us;
+}
+
+void key_action_sync(const matrix_row_t *pressed, int64_t now_us) {
+  s_muted = true;
+
+  // 暂存的按键没有输出过，当作未按下，下面按当前状态重新按下
+  s_combo_count = 0;
+  s_combo_pending = 0;
+  if (s_tap_key != NO_KEY) {
+    uint8_t key = s_tap_key;
+    if ((pressed[key / COL_NUM] >> (key % COL_NUM)) & 1) {
+      tap_resolve_hold(now_us);
+    } else {
+      s_tap_key = NO_KEY;
+      s_held_keys &= ~KEY_BIT(key);
+    }
+  }
+
+  // 先释放已松开的按键，层切换键松开后再处理新按下的按键
+  for (int key = 0; key < KEYMAP_NUM_KEYS; key++) {
+    if (!((pressed[key / COL_NUM] >> (key % COL_NUM)) & 1)) {
+      if (s_swallow & KEY_BIT(key)) {
+        combo_release(key, now_us);
+      } else {
+        key_release(key, now_us);
+      }
+    }
+  }
+  for (int key = 0; key < KEYMAP_NUM_KEYS; key++) {
+    if (((pressed[key / COL_NUM] >> (key % COL_NUM)) & 1) &&
+        !(s_swallow & KEY_BIT(key))) {
+      key_press(key, keymap_lookup(key), now_us);
+    }
+  }
+
+  s_muted = false;
+}
+
+void key_action_print(void) {
+  if (s_calls == 0) {
+    return;
+  }
+  ESP_LOGI(TAG, "%" PRIu32 " calls, max %" PRIu32 " cycles (%" PRIu32 " us)",
+           s_calls, s_max_cycles,
+           s_max_cycles / esp_rom_get_cpu_ticks_per_us());
+  s_calls = 0;
+  s_max_cycles = 0;
+}
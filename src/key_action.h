@@ -0,0 +1,52 @@
+#ifndef KEY_ACTION_H
+#define KEY_ACTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "key_event_queue.h"
+#include "keymap.h"
+
+// 按键动作处理：位于消抖后的按键事件和报告构建之间
+//   组合键  参与组合的按键按下后先暂存，组合窗口内凑齐一个组合即执行组合的
+//           动作；凑不成组合、窗口超时或有按键释放时按原顺序逐个处理
+//   短按/长按  MT/LT 键在按住超过 KEY_ACTION_TAPPING_TERM_MS 或按住期间按下
+//           其他键时为长按 (修饰键/层)，在此之前释放为短按 (键码)
+//   宏      按下时把宏的步骤交给 key_typer 排队，由发送任务逐帧输入
+//   主机切换  按下时交给 host_profile，通常放在组合键中
+// 超时不使用 vTaskDelay：key_action_tick 返回下一个超时，由调用方安排定时器
+// 每个事件的处理步数有上限：暂存的按键最多 KEYMAP_NUM_KEYS 个，组合最多
+// KEYMAP_MAX_COMBOS 个，实际耗时 (不含输出回调) 由 key_action_print 输出
+
+// 短按/长按的判定时间 (ms)
+#ifndef KEY_ACTION_TAPPING_TERM_MS
+#define KEY_ACTION_TAPPING_TERM_MS 200
+#endif
+
+// 组合窗口 (ms)：第一个按键按下后，其余按键需要在此时间内按下
+#ifndef KEY_ACTION_COMBO_TERM_MS
+#define KEY_ACTION_COMBO_TERM_MS 50
+#endif
+
+// 键码事件输出
+typedef void (*key_action_emit_t)(uint8_t keycode, bool pressed,
+                                  int64_t timestamp_us);
+
+// 初始化，键码事件通过 emit 输出
+void key_action_init(key_action_emit_t emit);
+
+// 处理一个消抖后的按键事件；只在发送任务中调用，不加锁
+void key_action_process(const key_event_t *event, int64_t now_us);
+
+// 处理已到期的组合窗口和短按/长按判定
+// 返回距离下一个超时的时间 (us)，0 表示没有等待中的超时
+int64_t key_action_tick(int64_t now_us);
+
+// 事件丢失后按消抖后的按键状态重建，不输出键码事件
+// 之后由 keymap_keycodes 取得当前按住的键码
+void key_action_sync(const matrix_row_t *pressed, int64_t now_us);
+
+// 输出并清零处理耗时统计
+void key_action_print(void);
+
+#endif /* KEY_ACTION_H */
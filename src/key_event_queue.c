@@ -0,0 +1,66 @@
+#include "key_event_queue.h"
+
+#include <stddef.h>
+
+bool key_event_queue_init(key_event_queue_t *q, key_event_t *buffer,
+                          uint32_t depth) {
+  if (buffer == NULL || depth == 0 || (depth & (depth - 1)) != 0) {
+    return false;
+  }
+  q->buffer = buffer;
+  q->mask = depth - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  atomic_init(&q->dropped, 0);
+  atomic_init(&q->high_water, 0);
+  return true;
+}
+
+bool key_event_queue_push(key_event_queue_t *q, const key_event_t *event) {
+  uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  uint32_t used = head - tail;
+
+  if (used > q->mask) {
+    // 计数器只有生产者写入，不需要原子加
+    atomic_store_explicit(
+        &q->dropped,
+        atomic_load_explicit(&q->dropped, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+    return false;
+  }
+
+  q->buffer[head & q->mask] = *event;
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+  if (used + 1 > atomic_load_explicit(&q->high_water, memory_order_relaxed)) {
+    atomic_store_explicit(&q->high_water, used + 1, memory_order_relaxed);
+  }
+  return true;
+}
+
+bool key_event_queue_pop(key_event_queue_t *q, key_event_t *event) {
+  uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+  if (head == tail) {
+    return false;
+  }
+
+  *event = q->buffer[tail & q->mask];
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+uint32_t key_event_queue_count(key_event_queue_t *q) {
+  return atomic_load_explicit(&q->head, memory_order_acquire) -
+         atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+uint32_t key_event_queue_dropped(key_event_queue_t *q) {
+  return atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
+
+uint32_t key_event_queue_high_water(key_event_queue_t *q) {
+  return atomic_load_explicit(&q->high_water, memory_order_relaxed);
+}
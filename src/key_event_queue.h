@@ -0,0 +1,52 @@
+#ifndef KEY_EVENT_QUEUE_H
+#define KEY_EVENT_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// 队列深度，必须是 2 的幂
+#ifndef KEY_EVENT_QUEUE_DEPTH
+#define KEY_EVENT_QUEUE_DEPTH 64
+#endif
+
+// 按键事件
+typedef struct {
+  int64_t timestamp_us;  // 消抖确认的时间
+  int64_t edge_us;       // 原始采样（或空闲时列中断）检测到变化的时间
+  uint8_t row;
+  uint8_t col;
+  bool pressed;          // true 按下，false 释放
+} key_event_t;
+
+// 单生产者/单消费者无锁环形队列
+// 生产者只修改 head，消费者只修改 tail，不需要加锁
+typedef struct {
+  key_event_t *buffer;
+  uint32_t mask;               // 深度 - 1
+  atomic_uint_fast32_t head;   // 下一个写入位置
+  atomic_uint_fast32_t tail;   // 下一个读取位置
+  atomic_uint_fast32_t dropped;     // 队列满时丢弃的事件数
+  atomic_uint_fast32_t high_water;  // 最大占用深度
+} key_event_queue_t;
+
+// 初始化，depth 必须是 2 的幂，buffer 至少 depth 个元素
+bool key_event_queue_init(key_event_queue_t *q, key_event_t *buffer,
+                          uint32_t depth);
+
+// 生产者：写入一个事件，队列满时丢弃并计数，返回 false
+bool key_event_queue_push(key_event_queue_t *q, const key_event_t *event);
+
+// 消费者：取出一个事件，队列空时返回 false
+bool key_event_queue_pop(key_event_queue_t *q, key_event_t *event);
+
+// 当前排队的事件数
+uint32_t key_event_queue_count(key_event_queue_t *q);
+
+// 累计丢弃的事件数
+uint32_t key_event_queue_dropped(key_event_queue_t *q);
+
+// 最大占用深度
+uint32_t key_event_queue_high_water(key_event_queue_t *q);
+
+#endif /* KEY_EVENT_QUEUE_H */
@@ -0,0 +1,171 @@
+#include "key_latency.h"
+
+#if KEY_LATENCY_ENABLED
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+// 直方图桶：小于 8us 每微秒一个桶，之后每个 2 倍区间分 4 个桶，误差不超过 25%
+#define HIST_SUB_BITS 2
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_MAX_EXP 24  // 超过 2^25 us 的值计入最后一个桶
+#define HIST_BUCKETS ((HIST_MAX_EXP) * HIST_SUB)
+
+typedef struct {
+  uint32_t buckets[HIST_BUCKETS];
+  uint32_t count;
+  uint32_t max_us;
+} histogram_t;
+
+// 等待发送的事件
+typedef struct {
+  int64_t edge_us;
+  int64_t applied_us;
+} pending_event_t;
+
+static const char *TAG = "KEY_LATENCY";
+
+static const char *const stage_names[KEY_LATENCY_STAGE_NUM] = {
+    "debounce", "queue", "report", "send", "total",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static histogram_t s_hist[KEY_LATENCY_STAGE_NUM];
+static pending_event_t s_pending[KEY_LATENCY_PENDING];  // 仅在发送任务中访问
+static uint32_t s_pending_num = 0;
+static esp_timer_handle_t s_print_timer = NULL;
+// 上次定期输出时的总事件数，定时器停止后才在定时器任务之外清零
+static uint32_t s_printed_count = 0;
+
+static uint32_t bucket_index(uint32_t value) {
+  if (value < 2 * HIST_SUB) {
+    return value;
+  }
+  uint32_t exp = 31 - __builtin_clz(value);
+  uint32_t index = (exp - 1) * HIST_SUB +
+                   ((value >> (exp - HIST_SUB_BITS)) & (HIST_SUB - 1));
+  return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+}
+
+// 桶内的最大值
+static uint32_t bucket_upper(uint32_t index) {
+  if (index < 2 * HIST_SUB - 1) {
+    return index;
+  }
+  index++;
+  uint32_t exp = index / HIST_SUB + 1;
+  return ((HIST_SUB + index % HIST_SUB) << (exp - HIST_SUB_BITS)) - 1;
+}
+
+static void record(key_latency_stage_t stage, int64_t from_us, int64_t to_us) {
+  int64_t delta = to_us - from_us;
+  uint32_t value = delta < 0 ? 0 : delta > UINT32_MAX ? UINT32_MAX : delta;
+  histogram_t *hist = &s_hist[stage];
+
+  portENTER_CRITICAL(&s_lock);
+  hist->buckets[bucket_index(value)]++;
+  hist->count++;
+  if (value > hist->max_us) {
+    hist->max_us = value;
+  }
+  portEXIT_CRITICAL(&s_lock);
+}
+
+static uint32_t percentile(const histogram_t *hist, uint32_t percent) {
+  uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= target) {
+      uint32_t upper = bucket_upper(i);
+      return upper < hist->max_us ? upper : hist->max_us;
+    }
+  }
+  return hist->max_us;
+}
+
+void key_latency_event(const key_event_t *event, int64_t applied_us) {
+  record(KEY_LATENCY_DEBOUNCE, event->edge_us, event->timestamp_us);
+  record(KEY_LATENCY_QUEUE, event->timestamp_us, applied_us);
+  if (s_pending_num < KEY_LATENCY_PENDING) {
+    s_pending[s_pending_num].edge_us = event->edge_us;
+    s_pending[s_pending_num].applied_us = applied_us;
+    s_pending_num++;
+  }
+}
+
+void key_latency_report_sent(int64_t build_us, int64_t sent_us) {
+  for (uint32_t i = 0; i < s_pending_num; i++) {
+    record(KEY_LATENCY_REPORT, s_pending[i].applied_us, build_us);
+    record(KEY_LATENCY_SEND, build_us, sent_us);
+    record(KEY_LATENCY_TOTAL, s_pending[i].edge_us, sent_us);
+  }
+  s_pending_num = 0;
+}
+
+void key_latency_summarize(key_latency_stage_t stage,
+                           key_latency_summary_t *summary) {
+  const histogram_t *hist = &s_hist[stage];
+
+  // 只遍历一遍桶，直接在锁内计算，不复制直方图
+  portENTER_CRITICAL(&s_lock);
+  summary->count = hist->count;
+  summary->p50_us = percentile(hist, 50);
+  summary->p99_us = percentile(hist, 99);
+  summary->max_us = hist->max_us;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void key_latency_reset(void) {
+  portENTER_CRITICAL(&s_lock);
+  memset(s_hist, 0, sizeof(s_hist));
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void key_latency_print(void) {
+  key_latency_summary_t summary;
+
+  ESP_LOGI(TAG, "%-8s %8s %8s %8s %8s", "stage", "count", "p50(us)", "p99(us)",
+           "max(us)");
+  for (int stage = 0; stage < KEY_LATENCY_STAGE_NUM; stage++) {
+    key_latency_summarize(stage, &summary);
+    ESP_LOGI(TAG, "%-8s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32,
+             stage_names[stage], summary.count, summary.p50_us, summary.p99_us,
+             summary.max_us);
+  }
+}
+
+// 没有新的按键时不重复输出
+static void print_timer_cb(void *arg) {
+  key_latency_summary_t total;
+  key_latency_summarize(KEY_LATENCY_TOTAL, &total);
+  if (total.count != s_printed_count) {
+    s_printed_count = total.count;
+    key_latency_print();
+  }
+}
+
+void key_latency_print_periodic(bool enable) {
+  if (KEY_LATENCY_PRINT_INTERVAL_S == 0) {
+    return;
+  }
+  if (s_print_timer == NULL) {
+    const esp_timer_create_args_t args = {.callback = print_timer_cb,
+                                          .name = "latency_print"};
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_print_timer));
+  }
+  if (esp_timer_is_active(s_print_timer)) {
+    esp_timer_stop(s_print_timer);
+  }
+  if (enable) {
+    s_printed_count = 0;
+    esp_timer_start_periodic(s_print_timer,
+                             KEY_LATENCY_PRINT_INTERVAL_S * 1000000ULL);
+  }
+}
+
+#endif /* KEY_LATENCY_ENABLED */
@@ -0,0 +1,79 @@
+#ifndef KEY_LATENCY_H
+#define KEY_LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "key_event_queue.h"
+
+// 按键端到端延迟统计：每个阶段一个直方图，关闭时所有调用编译为空
+#ifndef KEY_LATENCY_ENABLED
+#define KEY_LATENCY_ENABLED 1
+#endif
+
+// 已写入报告、等待发送的按键事件数上限
+#ifndef KEY_LATENCY_PENDING
+#define KEY_LATENCY_PENDING 16
+#endif
+
+// 连接期间在串口定期输出统计的间隔 (s)，有新事件时才输出；0 表示只在断开时输出
+#ifndef KEY_LATENCY_PRINT_INTERVAL_S
+#define KEY_LATENCY_PRINT_INTERVAL_S 60
+#endif
+
+// 延迟阶段
+typedef enum {
+  KEY_LATENCY_DEBOUNCE = 0,  // 原始采样（或列中断）检测到变化 -> 消抖确认
+  KEY_LATENCY_QUEUE,         // 消抖确认 -> 发送任务写入报告
+  KEY_LATENCY_REPORT,        // 写入报告 -> 开始发送（包含合并等待）
+  KEY_LATENCY_SEND,          // esp_hidd_dev_input_set 调用耗时
+  KEY_LATENCY_TOTAL,         // 原始采样检测到变化 -> 发送返回
+  KEY_LATENCY_STAGE_NUM,
+} key_latency_stage_t;
+
+// 单个阶段的统计结果 (us)，百分位为所在直方图桶的上界
+typedef struct {
+  uint32_t count;
+  uint32_t p50_us;
+  uint32_t p99_us;
+  uint32_t max_us;
+} key_latency_summary_t;
+
+#if KEY_LATENCY_ENABLED
+
+// 事件已写入报告，记录前两个阶段，并等待下一次成功发送
+void key_latency_event(const key_event_t *event, int64_t applied_us);
+
+// 报告发送成功，结束所有等待中的事件
+void key_latency_report_sent(int64_t build_us, int64_t sent_us);
+
+// 读取一个阶段的统计结果
+void key_latency_summarize(key_latency_stage_t stage,
+                           key_latency_summary_t *summary);
+
+// 清空所有直方图
+void key_latency_reset(void);
+
+// 在串口输出各阶段的统计结果
+void key_latency_print(void);
+
+// 连接建立时开始、断开时停止定期输出，连接期间也能从串口读取本次连接的统计
+void key_latency_print_periodic(bool enable);
+
+#else
+
+static inline void key_latency_event(const key_event_t *event,
+                                     int64_t applied_us) {}
+static inline void key_latency_report_sent(int64_t build_us, int64_t sent_us) {
+}
+static inline void key_latency_summarize(key_latency_stage_t stage,
+                                         key_latency_summary_t *summary) {
+  *summary = (key_latency_summary_t){0};
+}
+static inline void key_latency_reset(void) {}
+static inline void key_latency_print(void) {}
+static inline void key_latency_print_periodic(bool enable) {}
+
+#endif /* KEY_LATENCY_ENABLED */
+
+#endif /* KEY_LATENCY_H */
@@ -0,0 +1,161 @@
+#include "key_latency_gatts.h"
+
+#if KEY_LATENCY_ENABLED
+
+#include <string.h>
+
+#include "esp_gatt_defs.h"
+#include "esp_log.h"
+
+// 属性表
+enum {
+  LATENCY_IDX_SVC,
+  LATENCY_IDX_CHAR,
+  LATENCY_IDX_VAL,
+  LATENCY_IDX_NB,
+};
+
+#define LATENCY_PAYLOAD_LEN \
+  (2 + KEY_LATENCY_STAGE_NUM * sizeof(key_latency_summary_t))
+
+static const char *TAG = "KEY_LATENCY_GATTS";
+
+// 厂商服务和特征的 128 位 UUID（小端）
+static const uint8_t service_uuid[ESP_UUID_LEN_128] = {
+    0x1b, 0x6e, 0x2a, 0x8c, 0x51, 0x3f, 0x4d, 0x9a,
+    0xb7, 0x40, 0x5e, 0x21, 0x00, 0x01, 0x4c, 0x54,
+};
+static const uint8_t char_uuid[ESP_UUID_LEN_128] = {
+    0x1b, 0x6e, 0x2a, 0x8c, 0x51, 0x3f, 0x4d, 0x9a,
+    0xb7, 0x40, 0x5e, 0x21, 0x01, 0x01, 0x4c, 0x54,
+};
+
+static const uint16_t primary_service_uuid = ESP_GATT_UUID_PRI_SERVICE;
+static const uint16_t character_declaration_uuid = ESP_GATT_UUID_CHAR_DECLARE;
+static const uint8_t char_prop_read_write =
+    ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE;
+
+// 特征值由应用响应，统计结果在读取时生成
+static const esp_gatts_attr_db_t latency_db[LATENCY_IDX_NB] = {
+    [LATENCY_IDX_SVC] = {{ESP_GATT_AUTO_RSP},
+                         {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid,
+                          ESP_GATT_PERM_READ, sizeof(service_uuid),
+                          sizeof(service_uuid), (uint8_t *)service_uuid}},
+    [LATENCY_IDX_CHAR] = {{ESP_GATT_AUTO_RSP},
+                          {ESP_UUID_LEN_16,
+                           (uint8_t *)&character_declaration_uuid,
+                           ESP_GATT_PERM_READ, sizeof(uint8_t),
+                           sizeof(uint8_t), (uint8_t *)&char_prop_read_write}},
+    [LATENCY_IDX_VAL] = {{ESP_GATT_RSP_BY_APP},
+                         {ESP_UUID_LEN_128, (uint8_t *)char_uuid,
+                          ESP_GATT_PERM_READ_ENCRYPTED |
+                              ESP_GATT_PERM_WRITE_ENCRYPTED,
+                          LATENCY_PAYLOAD_LEN, 0, NULL}},
+};
+
+// 以下状态只在 BTC 任务的 GATTS 回调中访问
+static esp_gatt_if_t s_gatts_if = ESP_GATT_IF_NONE;
+static uint16_t s_handles[LATENCY_IDX_NB];
+static uint16_t s_mtu = 23;
+static uint8_t s_payload[LATENCY_PAYLOAD_LEN];  // 长读取时各分段使用同一份数据
+static esp_gatt_rsp_t s_rsp;                    // 体积较大，不放在栈上
+
+static void build_payload(void) {
+  key_latency_summary_t summary;
+
+  s_payload[0] = KEY_LATENCY_GATTS_VERSION;
+  s_payload[1] = KEY_LATENCY_STAGE_NUM;
+  for (int stage = 0; stage < KEY_LATENCY_STAGE_NUM; stage++) {
+    key_latency_summarize(stage, &summary);
+    memcpy(&s_payload[2 + stage * sizeof(summary)], &summary, sizeof(summary));
+  }
+}
+
+static void handle_read(esp_gatt_if_t gatts_if,
+                        esp_ble_gatts_cb_param_t *param) {
+  uint16_t offset = param->read.offset;
+  esp_gatt_status_t status = ESP_GATT_OK;
+
+  if (!param->read.need_rsp) {
+    return;
+  }
+  if (offset == 0) {
+    build_payload();
+  }
+
+  memset(&s_rsp, 0, sizeof(s_rsp));
+  s_rsp.attr_value.handle = param->read.handle;
+  s_rsp.attr_value.offset = offset;
+  if (offset > sizeof(s_payload)) {
+    status = ESP_GATT_INVALID_OFFSET;
+  } else {
+    uint16_t len = sizeof(s_payload) - offset;
+    s_rsp.attr_value.len = len < s_mtu - 1 ? len : s_mtu - 1;
+    memcpy(s_rsp.attr_value.value, &s_payload[offset], s_rsp.attr_value.len);
+  }
+  esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
+                              param->read.trans_id, status, &s_rsp);
+}
+
+esp_err_t key_latency_gatts_init(void) {
+  return esp_ble_gatts_app_register(KEY_LATENCY_GATTS_APP_ID);
+}
+
+bool key_latency_gatts_event_handler(esp_gatts_cb_event_t event,
+                                     esp_gatt_if_t gatts_if,
+                                     esp_ble_gatts_cb_param_t *param) {
+  if (event == ESP_GATTS_REG_EVT) {
+    if (param->reg.app_id != KEY_LATENCY_GATTS_APP_ID) {
+      return false;
+    }
+    if (param->reg.status != ESP_GATT_OK) {
+      ESP_LOGE(TAG, "app register failed: %d", param->reg.status);
+      return true;
+    }
+    s_gatts_if = gatts_if;
+    esp_ble_gatts_create_attr_tab(latency_db, gatts_if, LATENCY_IDX_NB, 0);
+    return true;
+  }
+  if (gatts_if == ESP_GATT_IF_NONE || gatts_if != s_gatts_if) {
+    return false;
+  }
+
+  switch (event) {
+    case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+      if (param->add_attr_tab.status != ESP_GATT_OK ||
+          param->add_attr_tab.num_handle != LATENCY_IDX_NB) {
+        ESP_LOGE(TAG, "create attr table failed: %d",
+                 param->add_attr_tab.status);
+        break;
+      }
+      memcpy(s_handles, param->add_attr_tab.handles, sizeof(s_handles));
+      esp_ble_gatts_start_service(s_handles[LATENCY_IDX_SVC]);
+      break;
+    case ESP_GATTS_CONNECT_EVT:
+      s_mtu = 23;
+      break;
+    case ESP_GATTS_MTU_EVT:
+      s_mtu = param->mtu.mtu;
+      break;
+    case ESP_GATTS_READ_EVT:
+      if (param->read.handle == s_handles[LATENCY_IDX_VAL]) {
+        handle_read(gatts_if, param);
+      }
+      break;
+    case ESP_GATTS_WRITE_EVT:
+      if (param->write.handle == s_handles[LATENCY_IDX_VAL]) {
+        key_latency_reset();
+        if (param->write.need_rsp) {
+          esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                      param->write.trans_id, ESP_GATT_OK,
+                                      NULL);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+#endif /* KEY_LATENCY_ENABLED */
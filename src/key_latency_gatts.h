@@ -0,0 +1,38 @@
+#ifndef KEY_LATENCY_GATTS_H
+#define KEY_LATENCY_GATTS_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "key_latency.h"
+
+// 延迟统计的厂商自定义 GATT 服务
+// 读取特征值返回各阶段统计：版本(1) 阶段数(1)，之后每个阶段
+// count、p50、p99、max 四个小端 uint32 (us)；写入任意值清空统计
+#define KEY_LATENCY_GATTS_APP_ID 0x4C54
+#define KEY_LATENCY_GATTS_VERSION 1
+
+#if KEY_LATENCY_ENABLED
+
+// 注册 GATT 应用，在 esp_hidd_dev_init 之后调用
+esp_err_t key_latency_gatts_init(void);
+
+// GATTS 事件处理，属于本服务的事件返回 true，其余事件交给 HID 设备处理
+bool key_latency_gatts_event_handler(esp_gatts_cb_event_t event,
+                                     esp_gatt_if_t gatts_if,
+                                     esp_ble_gatts_cb_param_t *param);
+
+#else
+
+static inline esp_err_t key_latency_gatts_init(void) { return ESP_OK; }
+
+static inline bool key_latency_gatts_event_handler(
+    esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+    esp_ble_gatts_cb_param_t *param) {
+  return false;
+}
+
+#endif /* KEY_LATENCY_ENABLED */
+
+#endif /* KEY_LATENCY_GATTS_H */
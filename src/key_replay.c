@@ -0,0 +1,59 @@
+#include "key_replay.h"
+
+#include <inttypes.h>
+
+#include "esp_log.h"
+
+_Static_assert((KEY_REPLAY_DEPTH & (KEY_REPLAY_DEPTH - 1)) == 0,
+               "KEY_REPLAY_DEPTH must be a power of two");
+
+static const char *TAG = "KEY_REPLAY";
+
+static key_replay_entry_t s_entries[KEY_REPLAY_DEPTH];
+static uint32_t s_head = 0;  // 下一个写入位置
+static uint32_t s_tail = 0;  // 下一个读取位置
+static uint32_t s_buffered = 0;
+static uint32_t s_overflow = 0;
+static uint32_t s_expired = 0;
+
+void key_replay_push(uint8_t keycode, bool pressed, int64_t timestamp_us) {
+  if (s_head - s_tail == KEY_REPLAY_DEPTH) {
+    // 丢弃最早的事件：过期裁剪同样从最早的开始，留下的总是最近的一段输入
+    s_tail++;
+    s_overflow++;
+  }
+  key_replay_entry_t *entry = &s_entries[s_head % KEY_REPLAY_DEPTH];
+  entry->timestamp_us = timestamp_us;
+  entry->keycode = keycode;
+  entry->pressed = pressed;
+  s_head++;
+  s_buffered++;
+}
+
+bool key_replay_pop(int64_t now_us, key_replay_entry_t *entry) {
+  while (s_tail != s_head) {
+    *entry = s_entries[s_tail % KEY_REPLAY_DEPTH];
+    s_tail++;
+    if (now_us - entry->timestamp_us <= KEY_REPLAY_MAX_AGE_MS * 1000LL) {
+      return true;
+    }
+    s_expired++;
+  }
+  return false;
+}
+
+uint32_t key_replay_count(void) { return s_head - s_tail; }
+
+void key_replay_print(void) {
+  if (s_buffered == 0) {
+    return;
+  }
+  ESP_LOGI(TAG,
+           "replayed %" PRIu32 " of %" PRIu32 " events (overflow %" PRIu32
+           ", expired %" PRIu32 ")",
+           s_buffered - s_overflow - s_expired, s_buffered, s_overflow,
+           s_expired);
+  s_buffered = 0;
+  s_overflow = 0;
+  s_expired = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef KEY_REPLAY_H
+#define KEY_REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 断开期间最多缓存的按键事件数，必须是 2 的幂
+#ifndef KEY_REPLAY_DEPTH
+#define KEY_REPLAY_DEPTH 128
+#endif
+
+// 回放时超过该时长的事件直接丢弃 (ms)
+#ifndef KEY_REPLAY_MAX_AGE_MS
+#define KEY_REPLAY_MAX_AGE_MS 10000
+#endif
+
+// 加密完成后等待主机打开通知的时间 (ms)，之后开始回放
+#ifndef KEY_REPLAY_START_DELAY_MS
+#define KEY_REPLAY_START_DELAY_MS 200
+#endif
+
+// 缓存的按键事件，键码在按下时确定
+typedef struct {
+  int64_t timestamp_us;
+  uint8_t keycode;
+  bool pressed;
+} key_replay_entry_t;
+
+// 链路不可用时缓存一个事件，缓存满时丢弃最早的事件
+// 只在发送任务中调用，不加锁
+void key_replay_push(uint8_t keycode, bool pressed, int64_t timestamp_us);
+
+// 按顺序取出下一个未过期的事件，过期事件被跳过并计数
+// 缓存为空时返回 false
+bool key_replay_pop(int64_t now_us, key_replay_entry_t *entry);
+
+// 当前缓存的事件数
+uint32_t key_replay_count(void);
+
+// 输出并清零本轮的溢出和过期计数，缓存回放完后调用
+void key_replay_print(void);
+
+#endif /* KEY_REPLAY_H */
@@ -0,0 +1,66 @@
+#include "key_trace.h"
+
+#if KEY_TRACE_ENABLED
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#if (KEY_TRACE_DEPTH & (KEY_TRACE_DEPTH - 1)) != 0
+#error "KEY_TRACE_DEPTH must be a power of two"
+#endif
+
+_Static_assert(sizeof(key_trace_entry_t) == 12,
+               "key_trace_entry_t layout must match tools/key_trace_decode.py");
+
+static const char *TAG = "KEY_TRACE";
+
+static key_trace_entry_t s_entries[KEY_TRACE_DEPTH];
+static atomic_uint_fast32_t s_head = 0;  // 已写入的记录总数
+
+void key_trace_record(uint8_t id, uint8_t row, uint8_t col, uint8_t keycode,
+                      int32_t err) {
+  uint32_t index =
+      atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+  key_trace_entry_t *entry = &s_entries[index & (KEY_TRACE_DEPTH - 1)];
+
+  entry->timestamp_us = (uint32_t)esp_timer_get_time();
+  entry->id = id;
+  entry->row = row;
+  entry->col = col;
+  entry->keycode = keycode;
+  entry->err = err;
+}
+
+uint32_t key_trace_snapshot(key_trace_entry_t *entries, uint32_t max_entries) {
+  uint32_t head = atomic_load_explicit(&s_head, memory_order_relaxed);
+  uint32_t count = head < KEY_TRACE_DEPTH ? head : KEY_TRACE_DEPTH;
+  if (count > max_entries) {
+    count = max_entries;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    entries[i] = s_entries[(head - count + i) & (KEY_TRACE_DEPTH - 1)];
+  }
+  return count;
+}
+
+void key_trace_dump(void) {
+  uint32_t head = atomic_load_explicit(&s_head, memory_order_relaxed);
+  uint32_t count = head < KEY_TRACE_DEPTH ? head : KEY_TRACE_DEPTH;
+  char line[sizeof(key_trace_entry_t) * 2 + 1];
+
+  ESP_LOGI(TAG, "dump %" PRIu32 " of %" PRIu32 " entries", count, head);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t *bytes =
+        (const uint8_t *)&s_entries[(head - count + i) & (KEY_TRACE_DEPTH - 1)];
+    for (size_t b = 0; b < sizeof(key_trace_entry_t); b++) {
+      snprintf(&line[b * 2], 3, "%02x", bytes[b]);
+    }
+    printf("KT:%s\n", line);
+  }
+}
+
+#endif /* KEY_TRACE_ENABLED */
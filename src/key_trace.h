@@ -0,0 +1,75 @@
+#ifndef KEY_TRACE_H
+#define KEY_TRACE_H
+
+#include <stdint.h>
+
+// 按键路径二进制跟踪：固定长度的事件写入内存环形缓冲区，不经过串口
+// 关闭时所有 KEY_TRACE 调用编译为空
+#ifndef KEY_TRACE_ENABLED
+#define KEY_TRACE_ENABLED 1
+#endif
+
+// 环形缓冲区深度，必须是 2 的幂
+#ifndef KEY_TRACE_DEPTH
+#define KEY_TRACE_DEPTH 256
+#endif
+
+// 事件编号，与 tools/key_trace_decode.py 保持一致
+typedef enum {
+  KEY_TRACE_SCAN_DOWN = 1,    // 扫描任务：消抖后按下
+  KEY_TRACE_SCAN_UP = 2,      // 扫描任务：消抖后释放
+  KEY_TRACE_QUEUE_DROP = 3,   // 事件队列满，err 为累计丢弃数
+  KEY_TRACE_HID_DOWN = 4,     // 发送任务：处理按下事件
+  KEY_TRACE_HID_UP = 5,       // 发送任务：处理释放事件
+  KEY_TRACE_REPORT_SEND = 6,  // 键盘报告发送，keycode 为报告 ID
+  KEY_TRACE_REPORT_DEFER = 7, // 合并窗口内推迟发送，err 为等待时间 (us)
+  KEY_TRACE_CC_SEND = 8,      // 多媒体报告发送，keycode 为用途码
+  KEY_TRACE_TX_BUSY = 9,      // 发送被流控拒绝，keycode 为报告 ID，err 为在途数
+  KEY_TRACE_TX_LOST = 10,     // 通知丢失，keycode 为报告 ID，err 为 GATT 状态
+  KEY_TRACE_TX_CONGEST = 11,  // 拥塞状态变化，err 为 1 (拥塞) 或 0 (解除)
+} key_trace_id_t;
+
+// 跟踪记录，12 字节，小端
+typedef struct {
+  uint32_t timestamp_us;  // esp_timer 时间的低 32 位
+  uint8_t id;             // key_trace_id_t
+  uint8_t row;            // 不适用时为 0xFF
+  uint8_t col;            // 不适用时为 0xFF
+  uint8_t keycode;
+  int32_t err;            // esp_err_t 或事件相关的数值
+} key_trace_entry_t;
+
+#if KEY_TRACE_ENABLED
+
+#define KEY_TRACE(id, row, col, keycode, err) \
+  key_trace_record((id), (row), (col), (keycode), (int32_t)(err))
+
+// 记录一个事件，可在任意任务中调用
+void key_trace_record(uint8_t id, uint8_t row, uint8_t col, uint8_t keycode,
+                      int32_t err);
+
+// 按时间顺序复制最近的记录，返回复制的条数
+uint32_t key_trace_snapshot(key_trace_entry_t *entries, uint32_t max_entries);
+
+// 以十六进制输出全部记录，每条一行 "KT:<24个十六进制字符>"
+// 由 tools/key_trace_decode.py 离线解码，不要在按键路径上调用
+void key_trace_dump(void);
+
+#else
+
+// 只引用 err，避免仅用于跟踪的返回值产生未使用警告，不生成代码
+#define KEY_TRACE(id, row, col, keycode, err) \
+  do {                                        \
+    (void)(err);                              \
+  } while (0)
+
+static inline uint32_t key_trace_snapshot(key_trace_entry_t *entries,
+                                          uint32_t max_entries) {
+  return 0;
+}
+
+static inline void key_trace_dump(void) {}
+
+#endif /* KEY_TRACE_ENABLED */
+
+#endif /* KEY_TRACE_H */
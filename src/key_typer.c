@@ -0,0 +1,251 @@
+#include "key_typer.h"
+
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "hid_report.h"
+
+_Static_assert((KEY_TYPER_QUEUE_DEPTH & (KEY_TYPER_QUEUE_DEPTH - 1)) == 0,
+               "KEY_TYPER_QUEUE_DEPTH must be a power of two");
+
+static const char *TAG = "KEY_TYPER";
+
+#define SHIFT(kc) KEYMAP_MODS(KEYMAP_MOD_SHIFT, kc)
+
+// 美式键盘布局下的符号，字母和数字在 ascii_action 中计算
+static const keymap_action_t s_ascii_symbols[128] = {
+    ['\t'] = 0x2B,       ['\n'] = 0x28,       [' '] = 0x2C,
+    ['!'] = SHIFT(0x1E), ['"'] = SHIFT(0x34), ['#'] = SHIFT(0x20),
+    ['$'] = SHIFT(0x21), ['%'] = SHIFT(0x22), ['&'] = SHIFT(0x24),
+    ['\''] = 0x34,       ['('] = SHIFT(0x26), [')'] = SHIFT(0x27),
+    ['*'] = SHIFT(0x25), ['+'] = SHIFT(0x2E), [','] = 0x36,
+    ['-'] = 0x2D,        ['.'] = 0x37,        ['/'] = 0x38,
+    [':'] = SHIFT(0x33), [';'] = 0x33,        ['<'] = SHIFT(0x36),
+    ['='] = 0x2E,        ['>'] = SHIFT(0x37), ['?'] = SHIFT(0x38),
+    ['@'] = SHIFT(0x1F), ['['] = 0x2F,        ['\\'] = 0x31,
+    [']'] = 0x30,        ['^'] = SHIFT(0x23), ['_'] = SHIFT(0x2D),
+    ['`'] = 0x35,        ['{'] = SHIFT(0x2F), ['|'] = SHIFT(0x31),
+    ['}'] = SHIFT(0x30), ['~'] = SHIFT(0x35),
+};
+
+// 排队的按键，任意任务写入，发送任务读取
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static keymap_action_t s_queue[KEY_TYPER_QUEUE_DEPTH];
+static uint32_t s_head = 0;  // 下一个写入位置
+static uint32_t s_tail = 0;  // 下一个读取位置
+static TaskHandle_t s_consumer = NULL;
+
+// 当前按下的字符，下一帧释放
+static keymap_action_t s_cur = 0;
+static bool s_cur_down = false;
+// 上一帧已写入报告但发送失败，下次先重发
+static bool s_unsent = false;
+
+// 本轮输入的统计，队列清空后输出
+static int64_t s_burst_start_us = 0;
+static uint32_t s_burst_chars = 0;
+static uint32_t s_burst_reports = 0;
+static uint32_t s_skipped = 0;  // 不支持的字符和队列满时丢弃的按键
+
+static keymap_action_t ascii_action(uint8_t c) {
+  if (c >= 'a' && c <= 'z') {
+    return KEYMAP_KEY(0x04 + (c - 'a'));
+  }
+  if (c >= 'A' && c <= 'Z') {
+    return SHIFT(0x04 + (c - 'A'));
+  }
+  if (c >= '1' && c <= '9') {
+    return KEYMAP_KEY(0x1E + (c - '1'));
+  }
+  if (c == '0') {
+    return KEYMAP_KEY(0x27);
+  }
+  return c < 128 ? s_ascii_symbols[c] : KEYMAP_NO;
+}
+
+static void skip_one(void) {
+  portENTER_CRITICAL(&s_lock);
+  s_skipped++;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+static bool queue_push(keymap_action_t action) {
+  bool ok;
+  portENTER_CRITICAL(&s_lock);
+  ok = s_head - s_tail < KEY_TYPER_QUEUE_DEPTH;
+  if (ok) {
+    s_queue[s_head++ % KEY_TYPER_QUEUE_DEPTH] = action;
+  } else {
+    s_skipped++;
+  }
+  portEXIT_CRITICAL(&s_lock);
+  return ok;
+}
+
+static bool queue_peek(keymap_action_t *action) {
+  bool ok;
+  portENTER_CRITICAL(&s_lock);
+  ok = s_head != s_tail;
+  if (ok) {
+    *action = s_queue[s_tail % KEY_TYPER_QUEUE_DEPTH];
+  }
+  portEXIT_CRITICAL(&s_lock);
+  return ok;
+}
+
+static void queue_drop_one(void) {
+  portENTER_CRITICAL(&s_lock);
+  s_tail++;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+static void notify_consumer(size_t queued) {
+  if (queued > 0 && s_consumer != NULL) {
+    xTaskNotifyGive(s_consumer);
+  }
+}
+
+// 执行一个 KEY 动作，键码事件写入报告
+static void apply(keymap_action_t action, bool pressed, int64_t now_us) {
+  keymap_output_t out[KEYMAP_MAX_OUTPUT];
+  uint8_t n = keymap_apply(action, pressed, out);
+  for (int i = 0; i < n; i++) {
+    if (out[i].pressed) {
+      hid_report_key_down(out[i].keycode, now_us);
+    } else {
+      hid_report_key_up(out[i].keycode, now_us);
+    }
+  }
+}
+
+// 生成下一帧：按下下一个字符并释放当前字符
+// 两者键码相同 (包括只有修饰键) 时主机无法区分，先单独发送一个释放帧
+// 没有需要发送的帧时返回 false
+static bool next_frame(int64_t now_us) {
+  keymap_action_t next;
+  bool has_next = queue_peek(&next);
+  if (!has_next && !s_cur_down) {
+    return false;
+  }
+  if (s_cur_down && (!has_next || KEYMAP_ACTION_KEYCODE(next) ==
+                                      KEYMAP_ACTION_KEYCODE(s_cur))) {
+    apply(s_cur, false, now_us);
+    s_cur_down = false;
+    return true;
+  }
+  queue_drop_one();
+  if (s_burst_chars == 0) {
+    s_burst_start_us = now_us;
+  }
+  // 先按下再释放，两者共用的修饰键保持按住
+  apply(next, true, now_us);
+  if (s_cur_down) {
+    apply(s_cur, false, now_us);
+  }
+  s_cur = next;
+  s_cur_down = true;
+  s_burst_chars++;
+  return true;
+}
+
+static void burst_print(int64_t now_us) {
+  if (s_burst_chars == 0) {
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  uint32_t skipped = s_skipped;
+  s_skipped = 0;
+  portEXIT_CRITICAL(&s_lock);
+  int64_t elapsed_us = now_us - s_burst_start_us;
+  uint32_t rate = elapsed_us > 0 ? s_burst_chars * 1000000LL / elapsed_us : 0;
+  ESP_LOGI(TAG,
+           "typed %" PRIu32 " keys in %" PRIu32 " reports, %" PRIu32
+           " ms, %" PRIu32 " keys/s (%" PRIu32 " skipped)",
+           s_burst_chars, s_burst_reports, (uint32_t)(elapsed_us / 1000), rate,
+           skipped);
+  s_burst_chars = 0;
+  s_burst_reports = 0;
+}
+
+void key_typer_init(TaskHandle_t consumer) { s_consumer = consumer; }
+
+size_t key_typer_type_utf8(const char *text) {
+  const uint8_t *p = (const uint8_t *)text;
+  size_t queued = 0;
+  while (*p != 0) {
+    uint8_t c = *p++;
+    if (c >= 0x80) {
+      // 非 ASCII 字符，跳过整个 UTF-8 序列
+      while ((*p & 0xC0) == 0x80) {
+        p++;
+      }
+      skip_one();
+      continue;
+    }
+    keymap_action_t action = ascii_action(c);
+    if (action == KEYMAP_NO) {
+      skip_one();
+      continue;
+    }
+    if (!queue_push(action)) {
+      break;
+    }
+    queued++;
+  }
+  notify_consumer(queued);
+  return queued;
+}
+
+size_t key_typer_type_keys(const keymap_action_t *keys, size_t count) {
+  size_t queued = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (KEYMAP_ACTION_KIND(keys[i]) != KEYMAP_KIND_KEY) {
+      skip_one();
+      continue;
+    }
+    if (!queue_push(keys[i])) {
+      break;
+    }
+    queued++;
+  }
+  notify_consumer(queued);
+  return queued;
+}
+
+int64_t key_typer_run(int64_t now_us, uint32_t interval_us,
+                      uint32_t credits) {
+  keymap_action_t next;
+  if (!s_cur_down && !s_unsent && !queue_peek(&next)) {
+    return 0;
+  }
+  // 按实际交给发送函数的报告计数：状态没有变化的帧不发送，
+  // 按下前补发上一个释放的报告也占用一个通知
+  uint32_t start = hid_report_sent_count();
+  while (hid_report_sent_count() - start < credits) {
+    if (!s_unsent && !next_frame(now_us)) {
+      break;
+    }
+    // 发送被拒绝，帧保留在报告中，CONF 返回后重发
+    s_unsent = !hid_report_send_pending(now_us);
+    if (s_unsent) {
+      break;
+    }
+  }
+  s_burst_reports += hid_report_sent_count() - start;
+  if (s_cur_down || s_unsent || queue_peek(&next)) {
+    // 通常由 CONF 提前唤醒，等待只是兜底
+    return interval_us > 0 ? interval_us : 1;
+  }
+  burst_print(now_us);
+  return 0;
+}
+
+void key_typer_pause(void) {
+  if (s_cur_down) {
+    // 主机侧已释放所有按键，只恢复层和键码计数，不输出
+    keymap_output_t out[KEYMAP_MAX_OUTPUT];
+    keymap_apply(s_cur, false, out);
+    s_cur_down = false;
+  }
+  s_unsent = false;
+}
@@ -0,0 +1,43 @@
+#ifndef KEY_TYPER_H
+#define KEY_TYPER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "keymap.h"
+
+// 字符串/按键序列输入：每个字符转换为一次按下和释放，逐帧写入报告并立即发送
+// 相邻字符的键码不同时，释放上一个和按下下一个合并为同一个报告，
+// 每个字符平均只需要一个报告；相同键码之间插入一个释放报告
+// 发送由发送任务驱动，调用方只是排队，不会阻塞或睡眠
+
+// 排队等待输入的按键数，必须是 2 的幂
+#ifndef KEY_TYPER_QUEUE_DEPTH
+#define KEY_TYPER_QUEUE_DEPTH 256
+#endif
+
+// 初始化，排队后通知 consumer（发送任务）
+void key_typer_init(TaskHandle_t consumer);
+
+// 排队一段 UTF-8 文本，按美式键盘布局输入
+// 只支持 ASCII 可打印字符、换行和 Tab，其他字符跳过
+// 返回排队的字符数，队列满时只排队能放下的部分；可在任意任务中调用，不能在中断中调用
+size_t key_typer_type_utf8(const char *text);
+
+// 排队一串 KEY 动作，每个动作按下并释放一次
+size_t key_typer_type_keys(const keymap_action_t *keys, size_t count);
+
+// 输出下一批帧，最多发送 credits 个报告；只在发送任务中、链路就绪且没有缓存回放时调用
+// credits 为发送通道当前能接受的通知数 (ble_hid_tx_available)，随 CONF 返回而恢复，
+// 一个连接事件能传输多少通知就发送多少；发送失败时帧保留，下次先重发
+// 返回还有内容时的重试等待 (一个连接间隔，us)，0 表示没有待输入的内容
+int64_t key_typer_run(int64_t now_us, uint32_t interval_us,
+                      uint32_t credits);
+
+// 连接断开：放开当前按下的字符，剩余的内容在重新连接后继续输入
+void key_typer_pause(void);
+
+#endif /* KEY_TYPER_H */
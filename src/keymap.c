@@ -0,0 +1,338 @@
+#include "keymap.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "KEYMAP";
+
+_Static_assert(KEYMAP_MAX_LAYERS <= 16, "layer index must fit in 4 bits");
+
+// 内置键位，NVS 中没有键位表时使用
+// | A(0,0) | B(0,1) | C(0,2) |
+// | D(1,0) | E(1,1) | F(1,2) |
+// | G(2,0) | H(2,1) | I(2,2) |
+static const keymap_action_t s_default_layer[ROW_NUM][COL_NUM] = {
+    {KEYMAP_KEY(0x52), KEYMAP_KEY(0x4F), KEYMAP_KEY(0x06)},  // UP, RIGHT, C
+    {KEYMAP_KEY(0x50), KEYMAP_KEY(0x08), KEYMAP_KEY(0x09)},  // LEFT, E, F
+    {KEYMAP_KEY(0x51), KEYMAP_KEY(0x0B), KEYMAP_KEY(0x0C)}   // DOWN, H, I
+};
+
+static keymap_action_t s_layers[KEYMAP_MAX_LAYERS][KEYMAP_NUM_KEYS];
+static uint8_t s_num_layers = 0;
+
+static keymap_combo_t s_combos[KEYMAP_MAX_COMBOS];
+static uint8_t s_num_combos = 0;
+
+// 所有宏的步骤连续存放
+static keymap_action_t s_macro_steps[KEYMAP_MAX_MACRO_STEPS];
+static uint8_t s_macro_start[KEYMAP_MAX_MACROS];
+static uint8_t s_macro_len[KEYMAP_MAX_MACROS];
+static uint8_t s_num_macros = 0;
+
+// 按当前层状态展开后的动作，按键事件只查这一张表
+static keymap_action_t s_active[KEYMAP_NUM_KEYS];
+
+static uint8_t s_momentary[KEYMAP_MAX_LAYERS];  // 每层按住的 MO 键数
+static uint16_t s_toggled = 0;                  // TG 打开的层
+
+// 每个键码被多少个按键按住，修饰键可能同时来自多个按键
+static uint8_t s_keycode_refs[256];
+
+// 层状态变化后重新展开：每个按键取最高有效层中的非透明动作
+static void resolve_layers(void) {
+  uint16_t active = s_toggled | 1;
+  for (int layer = 1; layer < s_num_layers; layer++) {
+    if (s_momentary[layer] > 0) {
+      active |= 1u << layer;
+    }
+  }
+  for (int key = 0; key < KEYMAP_NUM_KEYS; key++) {
+    keymap_action_t action = KEYMAP_NO;
+    for (int layer = s_num_layers - 1; layer >= 0; layer--) {
+      if (((active >> layer) & 1) &&
+          s_layers[layer][key] != KEYMAP_TRANSPARENT) {
+        action = s_layers[layer][key];
+        break;
+      }
+    }
+    s_active[key] = action;
+  }
+}
+
+static uint16_t read_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+// 检查动作的参数，键位中允许所有类型，组合键中不允许 MT/LT，宏中只允许 KEY
+static bool action_valid(keymap_action_t action, uint8_t layers,
+                         uint8_t macros) {
+  switch (KEYMAP_ACTION_KIND(action)) {
+    case KEYMAP_KIND_KEY:
+    case KEYMAP_KIND_MT:
+      return true;
+    case KEYMAP_KIND_MO:
+    case KEYMAP_KIND_TG:
+      return KEYMAP_ACTION_LAYER(action) < layers && (action & 0x0FF0) == 0;
+    case KEYMAP_KIND_LT:
+      return KEYMAP_ACTION_HOLD(action) < layers;
+    case KEYMAP_KIND_MACRO:
+      return KEYMAP_ACTION_MACRO(action) < macros && (action & 0x0F00) == 0;
+    case KEYMAP_KIND_PROFILE:
+      // 配置编号的范围由 host_profile 检查
+      return (action & 0x0EF0) == 0;
+    default:
+      return false;
+  }
+}
+
+// 解析键位表，格式不对时返回 0，否则返回层数；load 为 true 时同时加载
+static uint8_t blob_parse(const uint8_t *blob, size_t len, bool load) {
+  if (len < KEYMAP_BLOB_HEADER_LEN || len > KEYMAP_BLOB_MAX_LEN) {
+    return 0;
+  }
+  uint32_t magic = blob[0] | (blob[1] << 8) | (blob[2] << 16) |
+                   ((uint32_t)blob[3] << 24);
+  uint8_t version = blob[4];
+  uint8_t layers = blob[7];
+  size_t off = KEYMAP_BLOB_HEADER_LEN + (size_t)layers * KEYMAP_NUM_KEYS * 2;
+  if (magic != KEYMAP_BLOB_MAGIC || version == 0 ||
+      version > KEYMAP_BLOB_VERSION || blob[5] != ROW_NUM ||
+      blob[6] != COL_NUM || layers == 0 || layers > KEYMAP_MAX_LAYERS ||
+      off > len) {
+    return 0;
+  }
+
+  // 版本 1 没有组合键和宏
+  uint8_t combos = 0;
+  uint8_t macros = 0;
+  if (version >= 2) {
+    if (off + 2 > len) {
+      return 0;
+    }
+    combos = blob[off];
+    macros = blob[off + 1];
+    off += 2;
+    if (combos > KEYMAP_MAX_COMBOS || macros > KEYMAP_MAX_MACROS ||
+        off + combos * 4 > len) {
+      return 0;
+    }
+  }
+
+  const uint8_t *p = blob + KEYMAP_BLOB_HEADER_LEN;
+  for (int layer = 0; layer < layers; layer++) {
+    for (int key = 0; key < KEYMAP_NUM_KEYS; key++, p += 2) {
+      if (!action_valid(read_u16(p), layers, macros)) {
+        return 0;
+      }
+      if (load) {
+        s_layers[layer][key] = read_u16(p);
+      }
+    }
+  }
+
+  p = blob + off;
+  for (int i = 0; i < combos; i++, p += 4) {
+    keymap_key_mask_t keys = read_u16(p);
+    keymap_action_t action = read_u16(p + 2);
+    // 至少两个按键，且不能是 MT/LT
+    if ((keys & (keys - 1)) == 0 || keys >> KEYMAP_NUM_KEYS ||
+        KEYMAP_ACTION_KIND(action) == KEYMAP_KIND_MT ||
+        KEYMAP_ACTION_KIND(action) == KEYMAP_KIND_LT ||
+        !action_valid(action, layers, macros)) {
+      return 0;
+    }
+    if (load) {
+      s_combos[i] = (keymap_combo_t){keys, action};
+    }
+  }
+  off += combos * 4;
+
+  int total = 0;
+  for (int i = 0; i < macros; i++) {
+    if (off >= len) {
+      return 0;
+    }
+    uint8_t steps = blob[off++];
+    if (total + steps > KEYMAP_MAX_MACRO_STEPS || off + steps * 2 > len) {
+      return 0;
+    }
+    if (load) {
+      s_macro_start[i] = total;
+      s_macro_len[i] = steps;
+    }
+    for (int step = 0; step < steps; step++, off += 2) {
+      keymap_action_t action = read_u16(blob + off);
+      if (KEYMAP_ACTION_KIND(action) != KEYMAP_KIND_KEY) {
+        return 0;
+      }
+      if (load) {
+        s_macro_steps[total + step] = action;
+      }
+    }
+    total += steps;
+  }
+  if (off != len) {
+    return 0;
+  }
+
+  if (load) {
+    s_num_layers = layers;
+    s_num_combos = combos;
+    s_num_macros = macros;
+    // 新键位表中可能没有原来打开的层
+    s_toggled &= (1u << layers) - 1;
+    resolve_layers();
+  }
+  return layers;
+}
+
+void keymap_init(void) {
+  uint8_t blob[KEYMAP_BLOB_MAX_LEN];
+  size_t len = sizeof(blob);
+  nvs_handle_t handle;
+
+  esp_err_t err = nvs_open(KEYMAP_NVS_NAMESPACE, NVS_READONLY, &handle);
+  if (err == ESP_OK) {
+    err = nvs_get_blob(handle, KEYMAP_NVS_KEY, blob, &len);
+    nvs_close(handle);
+  }
+  if (err == ESP_OK) {
+    // 先完整校验再加载，格式不对时不会留下加载了一半的键位表
+    uint8_t layers = blob_parse(blob, len, false);
+    if (layers > 0) {
+      blob_parse(blob, len, true);
+      ESP_LOGI(TAG, "loaded %d layers, %d combos, %d macros from NVS", layers,
+               s_num_combos, s_num_macros);
+      return;
+    }
+    ESP_LOGW(TAG, "invalid keymap in NVS (%d bytes)", (int)len);
+  } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(TAG, "read keymap failed: %s", esp_err_to_name(err));
+  }
+
+  memcpy(s_layers[0], s_default_layer, sizeof(s_default_layer));
+  s_num_layers = 1;
+  s_num_combos = 0;
+  s_num_macros = 0;
+  resolve_layers();
+  ESP_LOGI(TAG, "using built-in keymap");
+}
+
+esp_err_t keymap_store(const uint8_t *blob, size_t len) {
+  uint8_t layers = blob_parse(blob, len, false);
+  if (layers == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(KEYMAP_NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err != ESP_OK) {
+    return err;
+  }
+  err = nvs_set_blob(handle, KEYMAP_NVS_KEY, blob, len);
+  if (err == ESP_OK) {
+    err = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  if (err == ESP_OK) {
+    blob_parse(blob, len, true);
+    ESP_LOGI(TAG, "stored %d layers", layers);
+  }
+  return err;
+}
+
+static uint8_t keycode_down(uint8_t keycode, keymap_output_t *out, uint8_t n) {
+  if (keycode != 0 && s_keycode_refs[keycode]++ == 0) {
+    out[n++] = (keymap_output_t){keycode, true};
+  }
+  return n;
+}
+
+static uint8_t keycode_up(uint8_t keycode, keymap_output_t *out, uint8_t n) {
+  if (keycode != 0 && s_keycode_refs[keycode] > 0 &&
+      --s_keycode_refs[keycode] == 0) {
+    out[n++] = (keymap_output_t){keycode, false};
+  }
+  return n;
+}
+
+keymap_action_t keymap_lookup(uint8_t key) {
+  return key < KEYMAP_NUM_KEYS ? s_active[key] : KEYMAP_NO;
+}
+
+uint8_t keymap_apply(keymap_action_t action, bool pressed,
+                     keymap_output_t out[KEYMAP_MAX_OUTPUT]) {
+  uint8_t n = 0;
+  uint8_t layer = KEYMAP_ACTION_LAYER(action);
+
+  switch (KEYMAP_ACTION_KIND(action)) {
+    case KEYMAP_KIND_KEY: {
+      uint8_t mods = KEYMAP_ACTION_MODS(action);
+      uint8_t keycode = KEYMAP_ACTION_KEYCODE(action);
+      if (keycode == KEYMAP_TRANSPARENT) {
+        keycode = 0;
+      }
+      if (!pressed) {
+        n = keycode_up(keycode, out, n);
+      }
+      for (int bit = 0; bit < 4; bit++) {
+        if ((mods >> bit) & 1) {
+          // 左侧修饰键 0xE0 ~ 0xE3 与 mods 的位顺序一致
+          n = pressed ? keycode_down(0xE0 + bit, out, n)
+                      : keycode_up(0xE0 + bit, out, n);
+        }
+      }
+      if (pressed) {
+        n = keycode_down(keycode, out, n);
+      }
+      break;
+    }
+    case KEYMAP_KIND_MO:
+      if (pressed) {
+        s_momentary[layer]++;
+      } else if (s_momentary[layer] > 0) {
+        s_momentary[layer]--;
+      }
+      resolve_layers();
+      break;
+    case KEYMAP_KIND_TG:
+      if (pressed) {
+        s_toggled ^= 1u << layer;
+        resolve_layers();
+      }
+      break;
+  }
+  return n;
+}
+
+uint16_t keymap_toggled(void) { return s_toggled; }
+
+void keymap_set_toggled(uint16_t layers) {
+  s_toggled = layers & ((1u << s_num_layers) - 1);
+  resolve_layers();
+}
+
+uint8_t keymap_keycodes(uint8_t *keycodes, uint8_t max_keycodes) {
+  uint8_t num_keycodes = 0;
+  for (int keycode = 1; keycode < 256 && num_keycodes < max_keycodes;
+       keycode++) {
+    if (s_keycode_refs[keycode] > 0) {
+      keycodes[num_keycodes++] = keycode;
+    }
+  }
+  return num_keycodes;
+}
+
+const keymap_combo_t *keymap_combos(uint8_t *count) {
+  *count = s_num_combos;
+  return s_combos;
+}
+
+const keymap_action_t *keymap_macro(uint8_t index, uint8_t *steps) {
+  if (index >= s_num_macros) {
+    *steps = 0;
+    return NULL;
+  }
+  *steps = s_macro_len[index];
+  return &s_macro_steps[s_macro_start[index]];
+}
@@ -0,0 +1,152 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "button_scan.h"
+#include "esp_err.h"
+
+// 最多层数，层 0 为默认层，始终有效
+#ifndef KEYMAP_MAX_LAYERS
+#define KEYMAP_MAX_LAYERS 8
+#endif
+
+// 组合键个数上限
+#ifndef KEYMAP_MAX_COMBOS
+#define KEYMAP_MAX_COMBOS 16
+#endif
+
+// 宏个数上限，以及所有宏的总步数上限
+#ifndef KEYMAP_MAX_MACROS
+#define KEYMAP_MAX_MACROS 16
+#endif
+#ifndef KEYMAP_MAX_MACRO_STEPS
+#define KEYMAP_MAX_MACRO_STEPS 128
+#endif
+
+#define KEYMAP_NUM_KEYS (ROW_NUM * COL_NUM)
+
+// 按键编号 row * COL_NUM + col，组合键用位图表示一组按键
+#define KEYMAP_KEY_INDEX(row, col) ((row) * COL_NUM + (col))
+typedef uint16_t keymap_key_mask_t;
+_Static_assert(KEYMAP_NUM_KEYS <= 16, "combo key mask must fit in 16 bits");
+
+// 按键动作，16 位：高 4 位为类型，其余为参数
+//   KEY   bit 0~7 键码 (含修饰键 0xE0~0xE7)，bit 8~11 同时按下的左侧修饰键
+//         (Ctrl, Shift, Alt, GUI)，键码为 0 时只按修饰键
+//   MO    按住期间打开 bit 0~3 指定的层
+//   TG    每次按下切换 bit 0~3 指定的层
+//   MT    短按为 bit 0~7 的键码，按住为 bit 8~11 的修饰键
+//   LT    短按为 bit 0~7 的键码，按住时打开 bit 8~11 指定的层
+//   MACRO 按下时依次点击 bit 0~7 指定的宏中的每一步
+//   PROFILE 按下时切换到 bit 0~3 指定的主机配置；bit 8 置位时同时忘记
+//         该配置绑定的主机，重新配对 (见 host_profile.h)
+typedef uint16_t keymap_action_t;
+
+#define KEYMAP_KIND_KEY 0x0
+#define KEYMAP_KIND_MO 0x1
+#define KEYMAP_KIND_TG 0x2
+#define KEYMAP_KIND_MT 0x3
+#define KEYMAP_KIND_LT 0x4
+#define KEYMAP_KIND_MACRO 0x5
+#define KEYMAP_KIND_PROFILE 0x6
+
+#define KEYMAP_ACTION_KIND(a) ((a) >> 12)
+#define KEYMAP_ACTION_KEYCODE(a) ((a) & 0xFF)
+#define KEYMAP_ACTION_MODS(a) (((a) >> 8) & 0x0F)
+#define KEYMAP_ACTION_LAYER(a) ((a) & 0x0F)
+#define KEYMAP_ACTION_HOLD(a) (((a) >> 8) & 0x0F)  // MT 的修饰键或 LT 的层
+#define KEYMAP_ACTION_MACRO(a) ((a) & 0xFF)
+#define KEYMAP_ACTION_PROFILE(a) ((a) & 0x0F)
+#define KEYMAP_ACTION_FORGET(a) (((a) >> 8) & 0x01)
+
+#define KEYMAP_KEY(kc) ((keymap_action_t)(kc))
+#define KEYMAP_MODS(mods, kc) \
+  ((keymap_action_t)((((mods) & 0x0F) << 8) | (kc)))
+#define KEYMAP_MO(layer) ((keymap_action_t)((KEYMAP_KIND_MO << 12) | (layer)))
+#define KEYMAP_TG(layer) ((keymap_action_t)((KEYMAP_KIND_TG << 12) | (layer)))
+#define KEYMAP_MT(mods, kc) \
+  ((keymap_action_t)((KEYMAP_KIND_MT << 12) | (((mods) & 0x0F) << 8) | (kc)))
+#define KEYMAP_LT(layer, kc) \
+  ((keymap_action_t)((KEYMAP_KIND_LT << 12) | ((layer) << 8) | (kc)))
+#define KEYMAP_MACRO(index) \
+  ((keymap_action_t)((KEYMAP_KIND_MACRO << 12) | (index)))
+#define KEYMAP_PROFILE(index) \
+  ((keymap_action_t)((KEYMAP_KIND_PROFILE << 12) | (index)))
+#define KEYMAP_REPAIR(index) \
+  ((keymap_action_t)((KEYMAP_KIND_PROFILE << 12) | 0x100 | (index)))
+
+#define KEYMAP_MOD_CTRL 0x01
+#define KEYMAP_MOD_SHIFT 0x02
+#define KEYMAP_MOD_ALT 0x04
+#define KEYMAP_MOD_GUI 0x08
+
+// 无动作，且不再查找下面的层
+#define KEYMAP_NO KEYMAP_KEY(0x00)
+// 透明：使用下面第一个有效层中的动作 (0x01 是 ErrorRollOver，不会出现在键位表中)
+#define KEYMAP_TRANSPARENT KEYMAP_KEY(0x01)
+
+// 组合键：keys 中的按键在组合窗口内全部按下时执行 action
+// action 可以是 KEY、MO、TG、MACRO 或 PROFILE
+typedef struct {
+  keymap_key_mask_t keys;
+  keymap_action_t action;
+} keymap_combo_t;
+
+// NVS 中的键位表，由 tools/keymap_compile.py 生成，小端：
+//   u32 magic, u8 version, u8 rows, u8 cols, u8 layers,
+//   u16 actions[layers][rows][cols]
+// 版本 2 之后依次为：
+//   u8 combos, u8 macros, {u16 keys, u16 action}[combos],
+//   每个宏 {u8 steps, u16 actions[steps]}，每一步为 KEY 动作
+#define KEYMAP_NVS_NAMESPACE "keymap"
+#define KEYMAP_NVS_KEY "layers"
+#define KEYMAP_BLOB_MAGIC 0x50414D4B  // "KMAP"
+#define KEYMAP_BLOB_VERSION 2
+#define KEYMAP_BLOB_HEADER_LEN 8
+#define KEYMAP_BLOB_MAX_LEN                                          \
+  (KEYMAP_BLOB_HEADER_LEN + KEYMAP_MAX_LAYERS * KEYMAP_NUM_KEYS * 2 + \
+   2 + KEYMAP_MAX_COMBOS * 4 + KEYMAP_MAX_MACROS +                   \
+   KEYMAP_MAX_MACRO_STEPS * 2)
+
+// 一个动作最多产生的键码事件数：4 个修饰键加一个键码
+#define KEYMAP_MAX_OUTPUT 5
+
+// 键码事件，交给报告构建
+typedef struct {
+  uint8_t keycode;
+  bool pressed;
+} keymap_output_t;
+
+// 启动时从 NVS 读取一次键位表，不存在或格式不对时使用内置键位
+// 需要在 nvs_flash_init 之后调用
+void keymap_init(void);
+
+// 校验并加载键位表，成功后写入 NVS，重启后依然有效
+esp_err_t keymap_store(const uint8_t *blob, size_t len);
+
+// 按当前层状态查找按键的动作，一次下标访问
+keymap_action_t keymap_lookup(uint8_t key);
+
+// 执行 KEY、MO、TG 动作：按下时先按修饰键再按键码，释放时相反
+// 返回写入 out 的键码事件数，层切换不产生键码事件
+// 调用方保证释放的是之前按下的同一个动作；只在发送任务中调用，不加锁
+uint8_t keymap_apply(keymap_action_t action, bool pressed,
+                     keymap_output_t out[KEYMAP_MAX_OUTPUT]);
+
+// TG 打开的层，切换主机配置时按主机保存和恢复；只在发送任务中调用
+uint16_t keymap_toggled(void);
+void keymap_set_toggled(uint16_t layers);
+
+// 当前按住的键码，事件丢失后重建报告时使用
+uint8_t keymap_keycodes(uint8_t *keycodes, uint8_t max_keycodes);
+
+// 组合键列表
+const keymap_combo_t *keymap_combos(uint8_t *count);
+
+// 宏的步骤，不存在时返回 NULL
+const keymap_action_t *keymap_macro(uint8_t index, uint8_t *steps);
+
+#endif /* KEYMAP_H */
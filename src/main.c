@@ -30,7 +30,24 @@
 #include "esp_hidd.h"
 
 // 包含按键扫描头文件
+#include "ble_conn_params.h"
+#include "ble_hid_tx.h"
+#include "ble_reconnect.h"
+#include "boot_timeline.h"
 #include "button_scan.h"
+#include "consumer_report.h"
+#include "esp_timer.h"
+#include "hid_report.h"
+#include "host_profile.h"
+#include "key_action.h"
+#include "key_latency.h"
+#include "key_latency_gatts.h"
+#include "keymap.h"
+#include "key_replay.h"
+#include "key_typer.h"
+#include "key_trace.h"
+#include "pipeline_bench.h"
+#include "power_mgmt.h"
 
 static const char *TAG = "HID_DEV_DEMO";
 
@@ -42,178 +59,30 @@ typedef struct {
 } local_param_t;
 
 #if CONFIG_BT_BLE_ENABLED
+// 发送任务的栈 (字节)：切换配置时在发送任务中写入 NVS，需要的栈比按键处理多得多
+// 断开连接时输出剩余栈，据此调整
+#ifndef BLE_HID_TASK_STACK_SIZE
+#define BLE_HID_TASK_STACK_SIZE (4 * 1024)
+#endif
+
 static local_param_t s_ble_hid_param = {0};
 static bool s_ble_is_connected = false;  // 添加连接状态变量
+static volatile bool s_report_protocol = true;  // 主机使用 Report 协议（否则为 Boot）
+static volatile bool s_ble_is_encrypted = false;  // 链路加密完成，可以发送报告
+static int64_t s_hid_ready_us = 0;  // 开始发送报告的时间，0 表示未就绪，只在发送任务中访问
 
-const unsigned char keyboardReportMap[] = {
-    0x05, 0x01,  // Usage Page (Generic Desktop)
-    0x09, 0x06,  // Usage (Keyboard)
-    0xA1, 0x01,  // Collection (Application)
-    0x85, 0x01,  //   Report ID (1)
-
-    // 修饰键 (左Ctrl, 左Shift等)
-    0x05, 0x07,  //   Usage Page (Key Codes)
-    0x19, 0xE0,  //   Usage Minimum (Left Control)
-    0x29, 0xE7,  //   Usage Maximum (Right GUI)
-    0x15, 0x00,  //   Logical Minimum (0)
-    0x25, 0x01,  //   Logical Maximum (1)
-    0x75, 0x01,  //   Report Size (1)
-    0x95, 0x08,  //   Report Count (8)
-    0x81, 0x02,  //   Input (Data, Variable, Absolute)
-
-    // 保留字节
-    0x95, 0x01,  //   Report Count (1)
-    0x75, 0x08,  //   Report Size (8)
-    0x81, 0x01,  //   Input (Constant)
-
-    // LED状态 (Num Lock, Caps Lock等)
-    0x95, 0x05,  //   Report Count (5)
-    0x75, 0x01,  //   Report Size (1)
-    0x05, 0x08,  //   Usage Page (LEDs)
-    0x19, 0x01,  //   Usage Minimum (Num Lock)
-    0x29, 0x05,  //   Usage Maximum (Kana)
-    0x91, 0x02,  //   Output (Data, Variable, Absolute)
-
-    // LED状态的保留3位
-    0x95, 0x01,  //   Report Count (1)
-    0x75, 0x03,  //   Report Size (3)
-    0x91, 0x01,  //   Output (Constant)
-
-    // 6个按键
-    0x95, 0x06,  //   Report Count (6)
-    0x75, 0x08,  //   Report Size (8)
-    0x15, 0x00,  //   Logical Minimum (0)
-    0x25, 0x65,  //   Logical Maximum (101)
-    0x05, 0x07,  //   Usage Page (Key Codes)
-    0x19, 0x00,  //   Usage Minimum (0)
-    0x29, 0x65,  //   Usage Maximum (101)
-    0x81, 0x00,  //   Input (Data, Array)
-
-    0xC0  // End Collection
-};
+// 扫描任务到发送任务的按键事件队列
+static key_event_t s_key_event_buffer[KEY_EVENT_QUEUE_DEPTH];
+static key_event_queue_t s_key_events;
 
-const unsigned char mediaReportMap[] = {
-    0x05,
-    0x0C,  // Usage Page (Consumer)
-    0x09,
-    0x01,  // Usage (Consumer Control)
-    0xA1,
-    0x01,  // Collection (Application)
-    0x85,
-    0x03,  //   Report ID (3)
-    0x09,
-    0x02,  //   Usage (Numeric Key Pad)
-    0xA1,
-    0x02,  //   Collection (Logical)
-    0x05,
-    0x09,  //     Usage Page (Button)
-    0x19,
-    0x01,  //     Usage Minimum (0x01)
-    0x29,
-    0x0A,  //     Usage Maximum (0x0A)
-    0x15,
-    0x01,  //     Logical Minimum (1)
-    0x25,
-    0x0A,  //     Logical Maximum (10)
-    0x75,
-    0x04,  //     Report Size (4)
-    0x95,
-    0x01,  //     Report Count (1)
-    0x81,
-    0x00,  //     Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
-           //     Position)
-    0xC0,  //   End Collection
-    0x05,
-    0x0C,  //   Usage Page (Consumer)
-    0x09,
-    0x86,  //   Usage (Channel)
-    0x15,
-    0xFF,  //   Logical Minimum (-1)
-    0x25,
-    0x01,  //   Logical Maximum (1)
-    0x75,
-    0x02,  //   Report Size (2)
-    0x95,
-    0x01,  //   Report Count (1)
-    0x81,
-    0x46,  //   Input (Data,Var,Rel,No Wrap,Linear,Preferred State,Null State)
-    0x09,
-    0xE9,  //   Usage (Volume Increment)
-    0x09,
-    0xEA,  //   Usage (Volume Decrement)
-    0x15,
-    0x00,  //   Logical Minimum (0)
-    0x75,
-    0x01,  //   Report Size (1)
-    0x95,
-    0x02,  //   Report Count (2)
-    0x81,
-    0x02,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null
-           //   Position)
-    0x09,
-    0xE2,  //   Usage (Mute)
-    0x09,
-    0x30,  //   Usage (Power)
-    0x09,
-    0x83,  //   Usage (Recall Last)
-    0x09,
-    0x81,  //   Usage (Assign Selection)
-    0x09,
-    0xB0,  //   Usage (Play)
-    0x09,
-    0xB1,  //   Usage (Pause)
-    0x09,
-    0xB2,  //   Usage (Record)
-    0x09,
-    0xB3,  //   Usage (Fast Forward)
-    0x09,
-    0xB4,  //   Usage (Rewind)
-    0x09,
-    0xB5,  //   Usage (Scan Next Track)
-    0x09,
-    0xB6,  //   Usage (Scan Previous Track)
-    0x09,
-    0xB7,  //   Usage (Stop)
-    0x15,
-    0x01,  //   Logical Minimum (1)
-    0x25,
-    0x0C,  //   Logical Maximum (12)
-    0x75,
-    0x04,  //   Report Size (4)
-    0x95,
-    0x01,  //   Report Count (1)
-    0x81,
-    0x00,  //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
-           //   Position)
-    0x09,
-    0x80,  //   Usage (Selection)
-    0xA1,
-    0x02,  //   Collection (Logical)
-    0x05,
-    0x09,  //     Usage Page (Button)
-    0x19,
-    0x01,  //     Usage Minimum (0x01)
-    0x29,
-    0x03,  //     Usage Maximum (0x03)
-    0x15,
-    0x01,  //     Logical Minimum (1)
-    0x25,
-    0x03,  //     Logical Maximum (3)
-    0x75,
-    0x02,  //     Report Size (2)
-    0x81,
-    0x00,  //     Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
-           //     Position)
-    0xC0,  //   End Collection
-    0x81,
-    0x03,  //   Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null
-           //   Position)
-    0xC0,  // End Collection
-};
+// 合并窗口结束时唤醒发送任务
+static esp_timer_handle_t s_flush_timer = NULL;
+// 组合窗口或短按/长按判定超时时唤醒发送任务
+static esp_timer_handle_t s_action_timer = NULL;
 
 static esp_hid_raw_report_map_t ble_report_maps[] = {
-    {.data = keyboardReportMap, .len = sizeof(keyboardReportMap)},
-    {.data = mediaReportMap, .len = sizeof(mediaReportMap)}};
+    {.data = hid_keyboard_report_map, .len = HID_KEYBOARD_REPORT_MAP_LEN},
+    {.data = hid_media_report_map, .len = HID_MEDIA_REPORT_MAP_LEN}};
 
 static esp_hid_device_config_t ble_hid_config = {
     .vendor_id = 0x16C0,
@@ -225,185 +94,234 @@ static esp_hid_device_config_t ble_hid_config = {
     .report_maps = ble_report_maps,
     .report_maps_len = 2};
 
-#define HID_CC_RPT_MUTE 1
-#define HID_CC_RPT_POWER 2
-#define HID_CC_RPT_LAST 3
-#define HID_CC_RPT_ASSIGN_SEL 4
-#define HID_CC_RPT_PLAY 5
-#define HID_CC_RPT_PAUSE 6
-#define HID_CC_RPT_RECORD 7
-#define HID_CC_RPT_FAST_FWD 8
-#define HID_CC_RPT_REWIND 9
-#define HID_CC_RPT_SCAN_NEXT_TRK 10
-#define HID_CC_RPT_SCAN_PREV_TRK 11
-#define HID_CC_RPT_STOP 12
-
-#define HID_CC_RPT_CHANNEL_UP 0x10
-#define HID_CC_RPT_CHANNEL_DOWN 0x30
-#define HID_CC_RPT_VOLUME_UP 0x40
-#define HID_CC_RPT_VOLUME_DOWN 0x80
-
-// HID Consumer Control report bitmasks
-#define HID_CC_RPT_NUMERIC_BITS 0xF0
-#define HID_CC_RPT_CHANNEL_BITS 0xCF
-#define HID_CC_RPT_VOLUME_BITS 0x3F
-#define HID_CC_RPT_BUTTON_BITS 0xF0
-#define HID_CC_RPT_SELECTION_BITS 0xCF
-
-// Macros for the HID Consumer Control 2-byte report
-#define HID_CC_RPT_SET_NUMERIC(s, x) \
-  (s)[0] &= HID_CC_RPT_NUMERIC_BITS; \
-  (s)[0] = (x)
-#define HID_CC_RPT_SET_CHANNEL(s, x) \
-  (s)[0] &= HID_CC_RPT_CHANNEL_BITS; \
-  (s)[0] |= ((x) & 0x03) << 4
-#define HID_CC_RPT_SET_VOLUME_UP(s) \
-  (s)[0] &= HID_CC_RPT_VOLUME_BITS; \
-  (s)[0] |= 0x40
-#define HID_CC_RPT_SET_VOLUME_DOWN(s) \
-  (s)[0] &= HID_CC_RPT_VOLUME_BITS;   \
-  (s)[0] |= 0x80
-#define HID_CC_RPT_SET_BUTTON(s, x) \
-  (s)[1] &= HID_CC_RPT_BUTTON_BITS; \
-  (s)[1] |= (x)
-#define HID_CC_RPT_SET_SELECTION(s, x) \
-  (s)[1] &= HID_CC_RPT_SELECTION_BITS; \
-  (s)[1] |= ((x) & 0x03) << 4
-
-// HID Consumer Usage IDs (subset of the codes available in the USB HID Usage
-// Tables spec)
-#define HID_CONSUMER_POWER 48  // Power
-#define HID_CONSUMER_RESET 49  // Reset
-#define HID_CONSUMER_SLEEP 50  // Sleep
-
-#define HID_CONSUMER_MENU 64           // Menu
-#define HID_CONSUMER_SELECTION 128     // Selection
-#define HID_CONSUMER_ASSIGN_SEL 129    // Assign Selection
-#define HID_CONSUMER_MODE_STEP 130     // Mode Step
-#define HID_CONSUMER_RECALL_LAST 131   // Recall Last
-#define HID_CONSUMER_QUIT 148          // Quit
-#define HID_CONSUMER_HELP 149          // Help
-#define HID_CONSUMER_CHANNEL_UP 156    // Channel Increment
-#define HID_CONSUMER_CHANNEL_DOWN 157  // Channel Decrement
-
-#define HID_CONSUMER_PLAY 176           // Play
-#define HID_CONSUMER_PAUSE 177          // Pause
-#define HID_CONSUMER_RECORD 178         // Record
-#define HID_CONSUMER_FAST_FORWARD 179   // Fast Forward
-#define HID_CONSUMER_REWIND 180         // Rewind
-#define HID_CONSUMER_SCAN_NEXT_TRK 181  // Scan Next Track
-#define HID_CONSUMER_SCAN_PREV_TRK 182  // Scan Previous Track
-#define HID_CONSUMER_STOP 183           // Stop
-#define HID_CONSUMER_EJECT 184          // Eject
-#define HID_CONSUMER_RANDOM_PLAY 185    // Random Play
-#define HID_CONSUMER_SELECT_DISC 186    // Select Disk
-#define HID_CONSUMER_ENTER_DISC 187     // Enter Disc
-#define HID_CONSUMER_REPEAT 188         // Repeat
-#define HID_CONSUMER_STOP_EJECT 204     // Stop/Eject
-#define HID_CONSUMER_PLAY_PAUSE 205     // Play/Pause
-#define HID_CONSUMER_PLAY_SKIP 206      // Play/Skip
-
-#define HID_CONSUMER_VOLUME 224       // Volume
-#define HID_CONSUMER_BALANCE 225      // Balance
-#define HID_CONSUMER_MUTE 226         // Mute
-#define HID_CONSUMER_BASS 227         // Bass
-#define HID_CONSUMER_VOLUME_UP 233    // Volume Increment
-#define HID_CONSUMER_VOLUME_DOWN 234  // Volume Decrement
-
-#define HID_RPT_ID_CC_IN 3   // Consumer Control input report ID
-#define HID_CC_IN_RPT_LEN 2  // Consumer Control input report Len
-#define HID_RPT_ID_KEY_IN 1
-#define HID_KEY_IN_RPT_LEN 8
-void esp_hidd_send_consumer_value(uint8_t key_cmd, bool key_pressed);
-void esp_hidd_send_key_value(uint8_t keycode, bool key_pressed);
-void esp_hidd_send_keys(uint8_t *keycodes, uint8_t num_keys);
-void esp_hidd_send_modifier_key_value(uint8_t modifier, uint8_t keycode,
-                                      bool key_pressed);
+void esp_hidd_send_consumer_value(uint16_t usage, bool key_pressed);
 void ble_hid_task(void *pvParameters);
 
-void ble_hid_task(void *pvParameters) {
-  int reconnect_counter = 0;
-  bool need_reconnect = false;
+// 报告构建器的发送函数
+static int ble_hid_send_report(uint8_t report_id, uint8_t *data, uint16_t len) {
+  int64_t build_us = esp_timer_get_time();
+  esp_err_t err =
+      ble_hid_tx_send(s_ble_hid_param.hid_dev, report_id, data, len);
+  KEY_TRACE(KEY_TRACE_REPORT_SEND, 0xFF, 0xFF, report_id, err);
+  if (err == ESP_OK) {
+    key_latency_report_sent(build_us, esp_timer_get_time());
+  }
 
-  // 初始化按键扫描
-  button_scan_init();
-  ESP_LOGI(TAG, "按键扫描初始化完成");
+  // 调试信息，默认日志级别下编译时去除
+  ESP_LOGD(TAG, "Send report result: %s", esp_err_to_name(err));
+  ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len, ESP_LOG_DEBUG);
+  return err;
+}
+
+// 按当前按住的 Consumer 用途发送报告
+static esp_err_t ble_hid_send_consumer(void) {
+  uint8_t buffer[HID_CC_IN_RPT_LEN];
+  consumer_report_encode(buffer);
+  return ble_hid_tx_send(s_ble_hid_param.hid_dev, HID_RPT_ID_CC_IN, buffer,
+                         HID_CC_IN_RPT_LEN);
+}
+
+static void flush_timer_cb(void *arg) {
+  xTaskNotifyGive(s_ble_hid_param.task_hdl);
+}
+
+// 链路已加密且主机有时间打开通知之后才发送报告
+static bool ble_hid_link_ready(int64_t now) {
+  return s_hid_ready_us != 0 && now >= s_hid_ready_us;
+}
+
+// 回放一个缓存的事件，缓存为空时返回 false
+static bool ble_hid_replay_one(int64_t now) {
+  key_replay_entry_t entry;
+  if (!key_replay_pop(now, &entry)) {
+    key_replay_print();
+    return false;
+  }
+  ble_conn_params_activity(now);
+  if (entry.pressed) {
+    hid_report_key_down(entry.keycode, now);
+  } else {
+    hid_report_key_up(entry.keycode, now);
+  }
+  return true;
+}
+
+// 按键动作输出的键码事件，链路不可用或仍在回放时先缓存
+static void ble_hid_emit_keycode(uint8_t keycode, bool pressed,
+                                 int64_t timestamp_us) {
+  int64_t now = esp_timer_get_time();
+  if (!ble_hid_link_ready(now) || key_replay_count() > 0) {
+    // 排在已缓存的事件之后，保持按键顺序
+    key_replay_push(keycode, pressed, timestamp_us);
+    return;
+  }
+  if (pressed) {
+    hid_report_key_down(keycode, now);
+  } else {
+    hid_report_key_up(keycode, now);
+  }
+}
+
+// 处理一个按键事件，未连接时按下按键唤醒重连
+static void ble_hid_handle_event(const key_event_t *event) {
+  KEY_TRACE(event->pressed ? KEY_TRACE_HID_DOWN : KEY_TRACE_HID_UP,
+            event->row, event->col,
+            KEYMAP_ACTION_KEYCODE(keymap_lookup(
+                KEYMAP_KEY_INDEX(event->row, event->col))),
+            ESP_OK);
+  ESP_LOGD(TAG, "按键%s: 行=%d, 列=%d", event->pressed ? "按下" : "释放",
+           event->row, event->col);
+
+  if (event->pressed) {
+    boot_timeline_milestone(BOOT_MILESTONE_KEY, event->timestamp_us);
+  }
 
-  // 上一次按键状态
-  button_state_t last_button = {0};
-  uint8_t keycodes[MAX_KEYS];
+  int64_t now = esp_timer_get_time();
+  bool direct = ble_hid_link_ready(now) && key_replay_count() == 0;
+  if (!s_ble_is_connected && event->pressed) {
+    ESP_LOGD(TAG, "设备未连接，等待连接...");
+    ble_reconnect_wake();
+  }
+  if (direct) {
+    ble_conn_params_activity(now);
+  }
+  key_action_process(event, now);
+  if (direct) {
+    // 写入报告之后再登记，写入时触发的发送只包含之前的事件
+    key_latency_event(event, now);
+  }
+}
 
+// 事件丢失后按当前消抖状态重建报告
+static void ble_hid_resync(void) {
+  matrix_row_t pressed[ROW_NUM];
+  uint8_t keycodes[KEYMAP_NUM_KEYS * KEYMAP_MAX_OUTPUT];
+
+  button_scan_get_pressed(pressed);
+  key_action_sync(pressed, esp_timer_get_time());
+  uint8_t num_keys = keymap_keycodes(keycodes, sizeof(keycodes));
+  hid_report_sync(keycodes, num_keys);
+}
+
+void ble_hid_task(void *pvParameters) {
+  uint32_t dropped = 0;
+  key_event_t event;
 
   while (1) {
-    button_state_t button = scan_button();
-    
-    if (button.num_keys > 0) {
-      ESP_LOGI(TAG, "检测到%d个按键按下", button.num_keys);
-      
-      if (need_reconnect) {
-        need_reconnect = false;
-        reconnect_counter = 0;
-        ESP_LOGI(TAG, "连接已恢复，重置重连计数器");
-      }
+    // 等待扫描任务写入按键事件，或合并窗口结束
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // 断开期间主机侧已释放所有按键，报告从空状态重新开始
+    if (!s_ble_is_connected) {
+      key_typer_pause();
+      hid_report_reset();
+      s_hid_ready_us = 0;
+    } else if (s_ble_is_encrypted && s_hid_ready_us == 0) {
+      s_hid_ready_us =
+          esp_timer_get_time() + KEY_REPLAY_START_DELAY_MS * 1000LL;
+    }
+    // Boot 协议下主机只识别 6KRO 报告
+    hid_report_set_nkro(s_report_protocol);
 
-      if (!s_ble_is_connected) {
-        ESP_LOGI(TAG, "设备未连接，等待连接...");
-        reconnect_counter++;
-        if (reconnect_counter >= 3) {
-          ESP_LOGI(TAG, "多次尝试后仍无效果，准备重新连接...");
-          need_reconnect = true;
-          reconnect_counter = 0;
-        }
-        if (need_reconnect) {
-          ESP_LOGI(TAG, "尝试重新开始广播...");
-          esp_hid_ble_gap_adv_start();
-          need_reconnect = false;
-          vTaskDelay(1000 / portTICK_PERIOD_MS);
+    // 取出所有排队的事件，同一连接间隔内的变化合并为一个报告
+    while (key_event_queue_pop(&s_key_events, &event)) {
+      ble_hid_handle_event(&event);
+    }
+
+    // 队列溢出时丢失了事件，按当前消抖状态重新同步，避免按键卡住
+    if (key_event_queue_dropped(&s_key_events) != dropped) {
+      dropped = key_event_queue_dropped(&s_key_events);
+      KEY_TRACE(KEY_TRACE_QUEUE_DROP, 0xFF, 0xFF, 0, dropped);
+      ESP_LOGW(TAG, "按键事件队列溢出，累计丢弃 %" PRIu32 " 个事件", dropped);
+      ble_hid_resync();
+    }
+
+    // 组合窗口和短按/长按判定不阻塞，到期时由定时器唤醒
+    int64_t action_wait_us = key_action_tick(esp_timer_get_time());
+    if (action_wait_us > 0) {
+      esp_timer_stop(s_action_timer);
+      esp_timer_start_once(s_action_timer, action_wait_us);
+    }
+
+    int64_t wait_us = 0;
+    if (s_ble_is_connected) {
+      // 合并窗口跟随实际连接间隔，间隔内多次发送只会在协议栈中排队
+      uint32_t interval_us = ble_conn_params_interval_us();
+      if (interval_us == 0) {
+        interval_us = HID_REPORT_MIN_INTERVAL_US;
+      }
+      hid_report_set_interval(interval_us);
+      int64_t now = esp_timer_get_time();
+      // 协议栈丢失的报告按当前状态重新发送，最后的全部释放报告不会丢失
+      uint32_t lost = ble_hid_tx_take_lost();
+      if (lost & ((1u << HID_RPT_ID_KEY_IN) | (1u << HID_RPT_ID_NKRO_IN))) {
+        hid_report_resend();
+      }
+      bool cc_retry = (lost & (1u << HID_RPT_ID_CC_IN)) &&
+                      ble_hid_send_consumer() != ESP_OK;
+      wait_us = hid_report_flush(now);
+      if (ble_hid_link_ready(now)) {
+        // 上一个报告发出后才回放下一个事件，速度不超过报告间隔
+        while (wait_us == 0 && ble_hid_replay_one(now)) {
+          wait_us = hid_report_flush(now);
         }
-      } else {
-        // 检查按键状态是否改变
-        bool state_changed = (button.num_keys != last_button.num_keys);
-        if (!state_changed) {
-          for (int i = 0; i < button.num_keys; i++) {
-            if (button.keys[i].row != last_button.keys[i].row ||
-                button.keys[i].col != last_button.keys[i].col) {
-              state_changed = true;
-              break;
+        // 回放完成后输入排队的字符串和宏，在途通知有空位就继续发送
+        if (key_replay_count() == 0) {
+          int64_t typer_wait_us =
+              key_typer_run(now, interval_us, ble_hid_tx_available());
+          if (typer_wait_us > 0) {
+            ble_conn_params_activity(now);
+            wait_us = hid_report_flush(now);
+            if (wait_us == 0 || typer_wait_us < wait_us) {
+              wait_us = typer_wait_us;
             }
           }
         }
-        
-        if (state_changed) {
-          // 获取所有按下按键的键码
-          for (int i = 0; i < button.num_keys; i++) {
-            keycodes[i] = get_keycode_from_button(
-                button.keys[i].row, button.keys[i].col);
-            ESP_LOGI(TAG, "按键 %d: 行=%d, 列=%d, 键码=0x%02x",
-                    i, button.keys[i].row, button.keys[i].col, keycodes[i]);
-          }
-          
-          // 发送所有按键
-          esp_hidd_send_keys(keycodes, button.num_keys);
-          
-          // 更新上次按键状态
-          last_button = button;
-        }
+      } else if (s_hid_ready_us != 0 && key_replay_count() > 0) {
+        wait_us = s_hid_ready_us - now;
+      }
+      if (cc_retry && (wait_us == 0 || interval_us < wait_us)) {
+        wait_us = interval_us;
+      }
+      if (wait_us > 0 && !esp_timer_is_active(s_flush_timer)) {
+        KEY_TRACE(KEY_TRACE_REPORT_DEFER, 0xFF, 0xFF, 0, wait_us);
+        esp_timer_start_once(s_flush_timer, wait_us);
       }
-    } else if (last_button.num_keys > 0) {
-      // 所有按键释放
-      ESP_LOGI(TAG, "所有按键释放");
-      esp_hidd_send_keys(NULL, 0);
-      last_button = button;
     }
-    
-    vTaskDelay(pdMS_TO_TICKS(20));  // 20ms扫描间隔
-    // vTaskDelay(pdMS_TO_TICKS(5000)); 
+    // 有报告等待发送时不进入浅睡眠，避免唤醒延迟叠加到合并窗口上
+    power_lock_set(POWER_LOCK_TX, wait_us > 0);
   }
 }
 
 void ble_hid_task_start_up(void) {
-  xTaskCreate(ble_hid_task, "ble_hid_task", 2 * 1024, NULL,
+  // 初始化按键扫描
+  button_scan_init();
+  ESP_LOGI(TAG, "按键扫描初始化完成");
+
+  hid_report_init(ble_hid_send_report);
+  const esp_timer_create_args_t timer_args = {
+      .callback = flush_timer_cb,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "hid_flush",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_flush_timer));
+  const esp_timer_create_args_t action_timer_args = {
+      .callback = flush_timer_cb,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "key_action",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&action_timer_args, &s_action_timer));
+  key_action_init(ble_hid_emit_keycode);
+
+  key_event_queue_init(&s_key_events, s_key_event_buffer,
+                       KEY_EVENT_QUEUE_DEPTH);
+  xTaskCreate(ble_hid_task, "ble_hid_task", BLE_HID_TASK_STACK_SIZE, NULL,
               configMAX_PRIORITIES - 3, &s_ble_hid_param.task_hdl);
+
+  // 扫描任务独立运行，发送阻塞时按键事件在队列中等待
+  button_scan_start(&s_key_events, s_ble_hid_param.task_hdl);
+  key_typer_init(s_ble_hid_param.task_hdl);
+  ble_hid_tx_init(s_ble_hid_param.task_hdl);
 }
 
 void ble_hid_task_shut_down(void) {
@@ -422,15 +340,18 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base,
   switch (event) {
     case ESP_HIDD_START_EVENT: {
       ESP_LOGI(TAG, "START");
-      esp_hid_ble_gap_adv_start();
+      ble_reconnect_start();
       break;
     }
     case ESP_HIDD_CONNECT_EVENT: {
       ESP_LOGI(TAG, "CONNECT");
       s_ble_is_connected = true;
+      s_ble_is_encrypted = false;
+      s_report_protocol = true;  // 连接建立时默认为 Report 协议
 
       // 打印连接信息
       ESP_LOGI(TAG, "连接成功，准备发送HID报告");
+      key_latency_print_periodic(true);
 
       break;
     }
@@ -438,10 +359,11 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base,
       ESP_LOGI(TAG, "PROTOCOL MODE[%u]: %s", param->protocol_mode.map_index,
                param->protocol_mode.protocol_mode ? "REPORT" : "BOOT");
 
-      // 确保设备处于Report模式
-      if (param->protocol_mode.protocol_mode == 0) {  // 如果是Boot模式
-        ESP_LOGI(TAG, "当前为Boot模式，建议切换到Report模式");
-        // 不使用未声明的函数，只记录日志
+      // Boot 模式下回退到 6KRO 报告，由发送任务切换报告格式
+      s_report_protocol =
+          param->protocol_mode.protocol_mode != ESP_HID_PROTOCOL_MODE_BOOT;
+      if (s_ble_hid_param.task_hdl) {
+        xTaskNotifyGive(s_ble_hid_param.task_hdl);
       }
       break;
     }
@@ -474,16 +396,27 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base,
       // 添加更多调试信息
       ESP_LOGI(TAG, "断开连接，原因: %d", param->disconnect.reason);
 
-      // 关闭HID任务
-      ble_hid_task_shut_down();
-
+      // 扫描和发送任务保持运行，断开期间的按键由发送任务处理
       // 设置连接状态
       s_ble_is_connected = false;
+      s_ble_is_encrypted = false;
+      consumer_report_reset();
+
+      // 输出本次连接的按键路径跟踪，用 tools/key_trace_decode.py 解码
+      key_trace_dump();
+      key_latency_print_periodic(false);
+      key_latency_print();
+      key_action_print();
+      ble_hid_tx_print();
+      host_profile_print();
+      power_print();
+      if (s_ble_hid_param.task_hdl) {
+        ESP_LOGI(TAG, "ble_hid_task stack: %u bytes never used",
+                 (unsigned)uxTaskGetStackHighWaterMark(
+                     s_ble_hid_param.task_hdl));
+      }
 
-      // 延迟一段时间再重新开始广播
-      vTaskDelay(1000 / portTICK_PERIOD_MS);
-      ESP_LOGI(TAG, "重新开始广播...");
-      esp_hid_ble_gap_adv_start();
+      // 重新广播由 ble_reconnect 在 GATTS 断开事件中立即开始
       break;
     }
     case ESP_HIDD_STOP_EVENT: {
@@ -495,46 +428,47 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base,
   }
   return;
 }
+
+// esp_hid_gap 处理之后的 BLE GAP 事件
+static void ble_gap_app_event_handler(esp_gap_ble_cb_event_t event,
+                                      esp_ble_gap_cb_param_t *param) {
+  ble_conn_params_gap_event(event, param);
+  ble_reconnect_gap_event(event, param);
+  if (event == ESP_GAP_BLE_ADV_START_COMPLETE_EVT &&
+      param->adv_start_cmpl.status == ESP_BT_STATUS_SUCCESS) {
+    boot_timeline_milestone(BOOT_MILESTONE_ADV, esp_timer_get_time());
+  }
+  bool own_host = host_profile_gap_event(event, param);
+
+  // 加密完成后唤醒发送任务，开始回放断开期间缓存的按键
+  // 属于其他主机配置的主机正在断开，不向它发送
+  if (event == ESP_GAP_BLE_AUTH_CMPL_EVT &&
+      param->ble_security.auth_cmpl.success && own_host) {
+    s_ble_is_encrypted = true;
+    if (s_ble_hid_param.task_hdl) {
+      xTaskNotifyGive(s_ble_hid_param.task_hdl);
+    }
+  }
+}
+
+// GATTS 事件先交给延迟统计服务，不属于它的事件再交给 HID 设备
+static void ble_gatts_event_handler(esp_gatts_cb_event_t event,
+                                    esp_gatt_if_t gatts_if,
+                                    esp_ble_gatts_cb_param_t *param) {
+  ble_conn_params_gatts_event(event, param);
+  ble_reconnect_gatts_event(event, param);
+  if (key_latency_gatts_event_handler(event, gatts_if, param)) {
+    return;
+  }
+  ble_hid_tx_gatts_event(event, param);
+  esp_hidd_gatts_event_handler(event, gatts_if, param);
+}
 #endif
 
 #if CONFIG_BT_HID_DEVICE_ENABLED
 static local_param_t s_bt_hid_param = {0};
-const unsigned char mouseReportMap[] = {
-    0x05, 0x01,  // USAGE_PAGE (Generic Desktop)
-    0x09, 0x02,  // USAGE (Mouse)
-    0xa1, 0x01,  // COLLECTION (Application)
-
-    0x09, 0x01,  //   USAGE (Pointer)
-    0xa1, 0x00,  //   COLLECTION (Physical)
-
-    0x05, 0x09,  //     USAGE_PAGE (Button)
-    0x19, 0x01,  //     USAGE_MINIMUM (Button 1)
-    0x29, 0x03,  //     USAGE_MAXIMUM (Button 3)
-    0x15, 0x00,  //     LOGICAL_MINIMUM (0)
-    0x25, 0x01,  //     LOGICAL_MAXIMUM (1)
-    0x95, 0x03,  //     REPORT_COUNT (3)
-    0x75, 0x01,  //     REPORT_SIZE (1)
-    0x81, 0x02,  //     INPUT (Data,Var,Abs)
-    0x95, 0x01,  //     REPORT_COUNT (1)
-    0x75, 0x05,  //     REPORT_SIZE (5)
-    0x81, 0x03,  //     INPUT (Cnst,Var,Abs)
-
-    0x05, 0x01,  //     USAGE_PAGE (Generic Desktop)
-    0x09, 0x30,  //     USAGE (X)
-    0x09, 0x31,  //     USAGE (Y)
-    0x09, 0x38,  //     USAGE (Wheel)
-    0x15, 0x81,  //     LOGICAL_MINIMUM (-127)
-    0x25, 0x7f,  //     LOGICAL_MAXIMUM (127)
-    0x75, 0x08,  //     REPORT_SIZE (8)
-    0x95, 0x03,  //     REPORT_COUNT (3)
-    0x81, 0x06,  //     INPUT (Data,Var,Rel)
-
-    0xc0,  //   END_COLLECTION
-    0xc0   // END_COLLECTION
-};
-
 static esp_hid_raw_report_map_t bt_report_maps[] = {
-    {.data = mouseReportMap, .len = sizeof(mouseReportMap)},
+    {.data = hid_mouse_report_map, .len = HID_MOUSE_REPORT_MAP_LEN},
 };
 
 static esp_hid_device_config_t bt_hid_config = {
@@ -690,8 +624,16 @@ static void bt_hidd_event_callback(void *handler_args, esp_event_base_t base,
 void app_main(void) {
   esp_err_t ret;
 
+  boot_timeline_mark("app_main");
   ESP_LOGI(TAG, "启动蓝牙HID键盘示例...");
 
+  // 基准测试在蓝牙启动之前运行，避免协议栈任务打断计时
+  pipeline_bench_run();
+
+  // 在扫描和蓝牙初始化之前配置电源管理，控制器按此决定 modem sleep
+  power_init();
+  boot_timeline_mark("power_init");
+
 #if CONFIG_BT_BLE_ENABLED || CONFIG_BT_HID_DEVICE_ENABLED
   ret = nvs_flash_init();
   if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
@@ -700,18 +642,34 @@ void app_main(void) {
     ret = nvs_flash_init();
   }
   ESP_ERROR_CHECK(ret);
+  boot_timeline_mark("nvs_init");
+  keymap_init();
+  boot_timeline_mark("keymap_init");
+
+#if CONFIG_BT_BLE_ENABLED
+  // 按键扫描和发送任务不依赖蓝牙协议栈，先于蓝牙启动：
+  // 唤醒设备的按键和蓝牙启动期间的按键进入回放缓存，链路就绪后发送
+  ble_conn_params_init();
+  ble_reconnect_init();
+  host_profile_init();
+  ble_hid_task_start_up();
+  boot_timeline_mark("scan_start");
+#endif
 
   ESP_LOGI(TAG, "设置HID GAP模式: %d", HID_DEV_MODE);
   ret = esp_hid_gap_init(HID_DEV_MODE);
   ESP_ERROR_CHECK(ret);
+  boot_timeline_mark("gap_init");
 
 #if CONFIG_BT_BLE_ENABLED
   ESP_LOGI(TAG, "初始化BLE广播...");
   // 使用键盘外观 (0x03C1 = 961 = Keyboard)
   ret = esp_hid_ble_gap_adv_init(961, ble_hid_config.device_name);
   ESP_ERROR_CHECK(ret);
+  esp_hid_ble_gap_set_event_hook(ble_gap_app_event_handler);
+  boot_timeline_mark("adv_init");
 
-  if ((ret = esp_ble_gatts_register_callback(esp_hidd_gatts_event_handler)) !=
+  if ((ret = esp_ble_gatts_register_callback(ble_gatts_event_handler)) !=
       ESP_OK) {
     ESP_LOGE(TAG, "GATTS注册回调失败: %d", ret);
     return;
@@ -720,9 +678,10 @@ void app_main(void) {
   ESP_ERROR_CHECK(esp_hidd_dev_init(&ble_hid_config, ESP_HID_TRANSPORT_BLE,
                                     ble_hidd_event_callback,
                                     &s_ble_hid_param.hid_dev));
+  boot_timeline_mark("hidd_init");
+  ESP_ERROR_CHECK(key_latency_gatts_init());
+  boot_timeline_mark("latency_gatts_init");
   ESP_LOGI(TAG, "BLE HID设备初始化完成，等待连接...");
-  // 启动HID任务
-  ble_hid_task_start_up();
 #endif
 #if CONFIG_BT_HID_DEVICE_ENABLED
   ESP_LOGI(TAG, "setting device name");
@@ -731,189 +690,29 @@ void app_main(void) {
   esp_bt_cod_t cod;
   cod.major = ESP_BT_COD_MAJOR_DEV_PERIPHERAL;
   esp_bt_gap_set_cod(cod, ESP_BT_SET_COD_MAJOR_MINOR);
-  vTaskDelay(1000 / portTICK_PERIOD_MS);
+  // 设备名和 COD 与之后的 HID 设备初始化在 BTC 任务中按顺序处理，不需要等待
   ESP_LOGI(TAG, "setting bt device");
   ESP_ERROR_CHECK(esp_hidd_dev_init(&bt_hid_config, ESP_HID_TRANSPORT_BT,
                                     bt_hidd_event_callback,
                                     &s_bt_hid_param.hid_dev));
+  boot_timeline_mark("bt_hidd_init");
 #endif
 #endif  // CONFIG_BT_BLE_ENABLED || CONFIG_BT_HID_DEVICE_ENABLED
 }
 
-void esp_hidd_send_consumer_value(uint8_t key_cmd, bool key_pressed) {
-  uint8_t buffer[HID_CC_IN_RPT_LEN] = {0, 0};
-  if (key_pressed) {
-    switch (key_cmd) {
-      case HID_CONSUMER_CHANNEL_UP:
-        HID_CC_RPT_SET_CHANNEL(buffer, HID_CC_RPT_CHANNEL_UP);
-        break;
-
-      case HID_CONSUMER_CHANNEL_DOWN:
-        HID_CC_RPT_SET_CHANNEL(buffer, HID_CC_RPT_CHANNEL_DOWN);
-        break;
-
-      case HID_CONSUMER_VOLUME_UP:
-        HID_CC_RPT_SET_VOLUME_UP(buffer);
-        break;
-
-      case HID_CONSUMER_VOLUME_DOWN:
-        HID_CC_RPT_SET_VOLUME_DOWN(buffer);
-        break;
-
-      case HID_CONSUMER_MUTE:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_MUTE);
-        break;
-
-      case HID_CONSUMER_POWER:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_POWER);
-        break;
-
-      case HID_CONSUMER_RECALL_LAST:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_LAST);
-        break;
-
-      case HID_CONSUMER_ASSIGN_SEL:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_ASSIGN_SEL);
-        break;
-
-      case HID_CONSUMER_PLAY:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_PLAY);
-        break;
-
-      case HID_CONSUMER_PAUSE:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_PAUSE);
-        break;
-
-      case HID_CONSUMER_RECORD:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_RECORD);
-        break;
-
-      case HID_CONSUMER_FAST_FORWARD:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_FAST_FWD);
-        break;
-
-      case HID_CONSUMER_REWIND:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_REWIND);
-        break;
-
-      case HID_CONSUMER_SCAN_NEXT_TRK:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_SCAN_NEXT_TRK);
-        break;
-
-      case HID_CONSUMER_SCAN_PREV_TRK:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_SCAN_PREV_TRK);
-        break;
-
-      case HID_CONSUMER_STOP:
-        HID_CC_RPT_SET_BUTTON(buffer, HID_CC_RPT_STOP);
-        break;
-
-      default:
-        break;
-    }
-  }
-  esp_hidd_dev_input_set(s_ble_hid_param.hid_dev, 1, HID_RPT_ID_CC_IN, buffer,
-                         HID_CC_IN_RPT_LEN);
-  return;
-}
-
-void esp_hidd_send_key_value(uint8_t keycode, bool key_pressed) {
-  uint8_t buf[HID_KEY_IN_RPT_LEN];
-
-  ESP_LOGI(TAG, "Sending key: 0x%02x, pressed: %d", keycode, key_pressed);
-
-  // 清空缓冲区
-  memset(buf, 0, HID_KEY_IN_RPT_LEN);
-
-  if (key_pressed) {
-    // 按键按下时，设置keycode
-    // 标准HID键盘报告格式：
-    // buf[0] = 修饰键
-    // buf[1] = 保留字节
-    // buf[2] = 按键1
-    // buf[3] = 按键2
-    // ...
-    buf[2] = keycode;
-  }
-
-  // 发送报告
-  esp_err_t err = esp_hidd_dev_input_set(
-      s_ble_hid_param.hid_dev, 1, HID_RPT_ID_KEY_IN, buf, HID_KEY_IN_RPT_LEN);
-  ESP_LOGI(TAG, "Send key result: %s", esp_err_to_name(err));
-
-  // 添加调试信息
-  ESP_LOGI(TAG, "键盘报告内容:");
-  ESP_LOG_BUFFER_HEX(TAG, buf, HID_KEY_IN_RPT_LEN);
-
-  // 对于Mac，只在按键释放时发送一个额外的空报告
-  if (!key_pressed && keycode != 0) {
-    vTaskDelay(10 / portTICK_PERIOD_MS);
-    memset(buf, 0, HID_KEY_IN_RPT_LEN);
-    err = esp_hidd_dev_input_set(s_ble_hid_param.hid_dev, 1, HID_RPT_ID_KEY_IN,
-                                 buf, HID_KEY_IN_RPT_LEN);
-    ESP_LOGI(TAG, "Send empty report result: %s", esp_err_to_name(err));
-  }
-}
-
-void esp_hidd_send_keys(uint8_t *keycodes, uint8_t num_keys) {
-  uint8_t buf[HID_KEY_IN_RPT_LEN];
-  
-  ESP_LOGI(TAG, "Sending %d keys", num_keys);
-  
-  // 清空缓冲区
-  memset(buf, 0, HID_KEY_IN_RPT_LEN);
-  
-  // 最多发送6个按键
-  num_keys = (num_keys > 6) ? 6 : num_keys;
-  
-  // 填充按键数据
-  for (int i = 0; i < num_keys; i++) {
-    buf[2 + i] = keycodes[i];
-    ESP_LOGI(TAG, "Key %d: 0x%02x", i, keycodes[i]);
+// 按下/释放一个 Consumer 用途，可与其他已按住的用途同时出现在报告中
+void esp_hidd_send_consumer_value(uint16_t usage, bool key_pressed) {
+  if (!consumer_report_supported(usage)) {
+    ESP_LOGW(TAG, "报告描述符中没有 Consumer 用途 0x%03x", usage);
+    return;
   }
-  
-  // 发送报告
-  esp_err_t err = esp_hidd_dev_input_set(
-      s_ble_hid_param.hid_dev, 1, HID_RPT_ID_KEY_IN, buf, HID_KEY_IN_RPT_LEN);
-  ESP_LOGI(TAG, "Send keys result: %s", esp_err_to_name(err));
-  
-  // 添加调试信息
-  ESP_LOGI(TAG, "键盘报告内容:");
-  ESP_LOG_BUFFER_HEX(TAG, buf, HID_KEY_IN_RPT_LEN);
-  
-}
-
-// 添加发送带修饰键的组合键的函数
-void esp_hidd_send_modifier_key_value(uint8_t modifier, uint8_t keycode,
-                                      bool key_pressed) {
-  uint8_t buf[HID_KEY_IN_RPT_LEN];
-
-  ESP_LOGI(TAG, "Sending modifier: 0x%02x, key: 0x%02x, pressed: %d", modifier,
-           keycode, key_pressed);
-
-  // 清空缓冲区
-  memset(buf, 0, HID_KEY_IN_RPT_LEN);
-
   if (key_pressed) {
-    buf[0] = modifier;  // 修饰键
-    buf[2] = keycode;   // 普通键
+    consumer_report_press(usage);
+  } else {
+    consumer_report_release(usage);
   }
 
-  // 发送报告
-  esp_err_t err = esp_hidd_dev_input_set(
-      s_ble_hid_param.hid_dev, 1, HID_RPT_ID_KEY_IN, buf, HID_KEY_IN_RPT_LEN);
-  ESP_LOGI(TAG, "Send key result: %s", esp_err_to_name(err));
-
-  // 添加调试信息
-  ESP_LOGI(TAG, "组合键报告内容:");
-  ESP_LOG_BUFFER_HEX(TAG, buf, HID_KEY_IN_RPT_LEN);
-
-  // 对于Mac，只在按键释放时发送一个额外的空报告
-  if (!key_pressed && (modifier != 0 || keycode != 0)) {
-    vTaskDelay(10 / portTICK_PERIOD_MS);
-    memset(buf, 0, HID_KEY_IN_RPT_LEN);
-    err = esp_hidd_dev_input_set(s_ble_hid_param.hid_dev, 1, HID_RPT_ID_KEY_IN,
-                                 buf, HID_KEY_IN_RPT_LEN);
-    ESP_LOGI(TAG, "Send empty report result: %s", esp_err_to_name(err));
-  }
+  esp_err_t err = ble_hid_send_consumer();
+  KEY_TRACE(KEY_TRACE_CC_SEND, 0xFF, 0xFF, key_pressed ? usage : 0, err);
+  return;
 }
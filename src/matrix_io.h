@@ -0,0 +1,34 @@
+#ifndef MATRIX_IO_H
+#define MATRIX_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "debounce.h"
+
+// 按键矩阵的硬件接口，扫描逻辑只通过这些函数访问引脚
+// 板上由 matrix_io_gpio.c 实现；主机侧仿真链接自己的实现即可替换
+// 虚拟矩阵，扫描、消抖、事件队列和报告构建的代码不需要修改
+
+// 列中断回调，在中断上下文中调用
+typedef void (*matrix_io_wake_cb_t)(void);
+
+// 配置行列引脚，行全部释放，列中断注册但不使能
+void matrix_io_init(matrix_io_wake_cb_t wake_cb);
+
+// 拉低/释放一行
+void matrix_io_select_row(uint8_t row);
+void matrix_io_unselect_row(uint8_t row);
+
+// 拉低/释放所有行
+void matrix_io_select_all_rows(void);
+void matrix_io_release_rows(void);
+
+// 读取列状态，按下（低电平）的列为 1
+matrix_row_t matrix_io_read_cols(void);
+
+// 使能/关闭列低电平中断及浅睡眠唤醒，仅在空闲等待时使能
+// 中断触发一次后自动关闭，避免按住按键时反复进入中断
+void matrix_io_wake_enable(bool enable);
+
+#endif /* MATRIX_IO_H */
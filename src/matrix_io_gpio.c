@@ -0,0 +1,111 @@
+#include "matrix_io.h"
+
+#include "button_scan.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+
+static const char *TAG = "MATRIX_IO";
+
+// 行引脚数组
+static const gpio_num_t row_pins[ROW_NUM] = {ROW1_PIN, ROW2_PIN, ROW3_PIN};
+
+// 列引脚数组
+static const gpio_num_t col_pins[COL_NUM] = {COL1_PIN, COL2_PIN, COL3_PIN};
+
+static matrix_io_wake_cb_t s_wake_cb = NULL;
+
+// 低电平中断在按键按住期间持续触发，第一次进入后即关闭
+static void IRAM_ATTR col_isr_handler(void *arg) {
+  for (int i = 0; i < COL_NUM; i++) {
+    gpio_intr_disable(col_pins[i]);
+  }
+  if (s_wake_cb) {
+    s_wake_cb();
+  }
+}
+
+void matrix_io_init(matrix_io_wake_cb_t wake_cb) {
+  s_wake_cb = wake_cb;
+
+  // 配置行GPIO（开漏输出，带上拉）
+  gpio_config_t io_conf = {.pin_bit_mask = 0,
+                           .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+                           .pull_up_en = GPIO_PULLUP_ENABLE,
+                           .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                           .intr_type = GPIO_INTR_DISABLE};
+
+  for (int i = 0; i < ROW_NUM; i++) {
+    io_conf.pin_bit_mask |= (1ULL << row_pins[i]);
+  }
+  gpio_config(&io_conf);
+  matrix_io_release_rows();
+
+  // 配置列GPIO（输入模式，带上拉）
+  io_conf.pin_bit_mask = 0;
+  io_conf.mode = GPIO_MODE_INPUT;
+  for (int i = 0; i < COL_NUM; i++) {
+    io_conf.pin_bit_mask |= (1ULL << col_pins[i]);
+  }
+  gpio_config(&io_conf);
+
+  // 浅睡眠期间保持行列引脚的配置：所有行拉低、列上拉，按键按下即可唤醒
+  for (int i = 0; i < ROW_NUM; i++) {
+    gpio_sleep_sel_dis(row_pins[i]);
+  }
+  for (int i = 0; i < COL_NUM; i++) {
+    gpio_sleep_sel_dis(col_pins[i]);
+  }
+  esp_sleep_enable_gpio_wakeup();
+
+  // 列引脚低电平中断，仅在空闲等待时使能
+  esp_err_t ret = gpio_install_isr_service(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "gpio_install_isr_service failed: %d", ret);
+  }
+  for (int i = 0; i < COL_NUM; i++) {
+    gpio_set_intr_type(col_pins[i], GPIO_INTR_DISABLE);
+    gpio_intr_disable(col_pins[i]);
+    gpio_isr_handler_add(col_pins[i], col_isr_handler, NULL);
+  }
+}
+
+// 行引脚为开漏输出：输出1时由上拉保持高电平（释放），输出0时选中该行
+void matrix_io_select_row(uint8_t row) { gpio_set_level(row_pins[row], 0); }
+
+void matrix_io_unselect_row(uint8_t row) { gpio_set_level(row_pins[row], 1); }
+
+void matrix_io_select_all_rows(void) {
+  for (int i = 0; i < ROW_NUM; i++) {
+    gpio_set_level(row_pins[i], 0);
+  }
+}
+
+void matrix_io_release_rows(void) {
+  for (int i = 0; i < ROW_NUM; i++) {
+    gpio_set_level(row_pins[i], 1);
+  }
+}
+
+// 读取当前被拉低行的列状态，低电平有效
+matrix_row_t matrix_io_read_cols(void) {
+  matrix_row_t bits = 0;
+  for (int col = 0; col < COL_NUM; col++) {
+    bits |= (matrix_row_t)(gpio_get_level(col_pins[col]) == 0) << col;
+  }
+  return bits;
+}
+
+void matrix_io_wake_enable(bool enable) {
+  // 浅睡眠只能由电平唤醒，gpio_wakeup_enable 同时把中断类型设为低电平
+  for (int i = 0; i < COL_NUM; i++) {
+    if (enable) {
+      gpio_wakeup_enable(col_pins[i], GPIO_INTR_LOW_LEVEL);
+      gpio_intr_enable(col_pins[i]);
+    } else {
+      gpio_intr_disable(col_pins[i]);
+      gpio_wakeup_disable(col_pins[i]);
+    }
+  }
+}
@@ -0,0 +1,200 @@
+#include "pipeline_bench.h"
+
+#if PIPELINE_BENCH_ENABLED
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "button_scan.h"
+#include "debounce.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "hid_report.h"
+#include "matrix_io.h"
+#include "scan_index.h"
+
+// 合成输入的帧数，必须是 2 的幂
+#define BENCH_FRAMES 64
+
+// 扫描结果索引测试中最多的广播设备数
+#define BENCH_ADVERTISERS 256
+
+typedef uint32_t (*bench_fn_t)(uint32_t iteration);
+
+static matrix_row_t s_frames[BENCH_FRAMES][DEBOUNCE_MAX_ROWS];
+static debounce_t s_debounce;
+static uint8_t s_rows;
+static volatile uint32_t s_sink;  // 防止被测代码被优化掉
+
+static scan_index_t s_scan_index;
+static uint8_t s_bdas[BENCH_ADVERTISERS][ESP_BD_ADDR_LEN];
+static uint32_t s_advertisers;
+
+// xorshift32，固定种子，每次运行的输入相同
+static uint32_t next_random(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// 生成接近真实打字的输入：每帧少量按键变化，变化后的几帧带有抖动
+static void make_frames(uint8_t rows, uint8_t cols) {
+  uint32_t seed = 0x2545F491;
+  matrix_row_t mask = (matrix_row_t)((1u << cols) - 1);
+  matrix_row_t level[DEBOUNCE_MAX_ROWS] = {0};
+
+  for (int f = 0; f < BENCH_FRAMES; f++) {
+    for (int row = 0; row < rows; row++) {
+      if ((next_random(&seed) & 7) == 0) {
+        level[row] ^= (matrix_row_t)(1u << (next_random(&seed) % cols));
+      }
+      matrix_row_t bounce = (f & 3) ? 0 : (matrix_row_t)next_random(&seed);
+      s_frames[f][row] = (level[row] ^ (bounce & (bounce >> 3))) & mask;
+    }
+  }
+}
+
+static uint32_t bench_debounce(uint32_t i) {
+  matrix_row_t changed[DEBOUNCE_MAX_ROWS];
+  return debounce_update(&s_debounce, s_frames[i & (BENCH_FRAMES - 1)],
+                         changed);
+}
+
+// 消抖加上扫描任务的边沿提取，即每帧在定时器和扫描任务中的全部计算
+static uint32_t bench_frame(uint32_t i) {
+  matrix_row_t changed[DEBOUNCE_MAX_ROWS];
+  uint32_t events = 0;
+
+  debounce_update(&s_debounce, s_frames[i & (BENCH_FRAMES - 1)], changed);
+  for (int row = 0; row < s_rows; row++) {
+    matrix_row_t bits = changed[row];
+    while (bits) {
+      events += __builtin_ctz(bits) + row;
+      bits &= bits - 1;
+    }
+  }
+  events += debounce_is_idle(&s_debounce);
+  return events;
+}
+
+// 实际引脚上的一帧扫描，不含行稳定等待
+static uint32_t bench_matrix_io(uint32_t i) {
+  matrix_row_t raw = 0;
+  for (int row = 0; row < ROW_NUM; row++) {
+    matrix_io_select_row(row);
+    raw |= matrix_io_read_cols();
+    matrix_io_unselect_row(row);
+  }
+  return raw;
+}
+
+static int bench_send(uint8_t report_id, uint8_t *data, uint16_t len) {
+  s_sink += data[2];
+  return 0;
+}
+
+// 一次按下或释放加上立即发送，时间间隔超过合并窗口，每次都构建报告
+static uint32_t bench_report(uint32_t i) {
+  static const uint8_t keycodes[] = {0x04, 0x16, 0xE1, 0x07, 0x09, 0x2C, 0xE0};
+  int64_t now = (int64_t)(i + 1) * HID_REPORT_MIN_INTERVAL_US;
+  uint8_t keycode = keycodes[(i >> 1) % sizeof(keycodes)];
+
+  if ((i & 1) == 0) {
+    hid_report_key_down(keycode, now);
+  } else {
+    hid_report_key_up(keycode, now);
+  }
+  return (uint32_t)hid_report_flush(now);
+}
+
+// 广播洪泛：所有设备轮流广播，每个广播包查找一次，新设备插入并保存名字
+// 设备数超过索引容量时，多出的设备每次都会查找失败
+static uint32_t bench_scan(uint32_t i) {
+  static const uint8_t name[] = "BLE KEYBOARD";
+  bool created;
+  esp_hid_scan_result_t *r =
+      scan_index_insert(&s_scan_index, s_bdas[i % s_advertisers],
+                        ESP_HID_TRANSPORT_BLE, &created);
+  if (created) {
+    r->name = scan_index_name(&s_scan_index, name, sizeof(name) - 1);
+  }
+  return r != NULL;
+}
+
+static void make_bdas(void) {
+  uint32_t seed = 0x9E3779B9;
+  for (int i = 0; i < BENCH_ADVERTISERS; i++) {
+    for (int b = 0; b < ESP_BD_ADDR_LEN; b++) {
+      s_bdas[i][b] = (uint8_t)next_random(&seed);
+    }
+  }
+}
+
+static void run(const char *name, uint16_t rows, uint16_t cols,
+                bench_fn_t fn) {
+  uint32_t best = UINT32_MAX;
+
+  for (int round = 0; round < PIPELINE_BENCH_ROUNDS; round++) {
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < PIPELINE_BENCH_ITERATIONS; i++) {
+      s_sink += fn(i);
+    }
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    if (cycles < best) {
+      best = cycles;
+    }
+  }
+
+  uint32_t per_op_x100 = (uint32_t)((uint64_t)best * 100 /
+                                    PIPELINE_BENCH_ITERATIONS);
+  uint32_t ns_per_op = (uint32_t)((uint64_t)best * 1000 /
+                                  PIPELINE_BENCH_ITERATIONS /
+                                  esp_rom_get_cpu_ticks_per_us());
+  printf("%s,%u,%u,%u,%" PRIu32 ".%02" PRIu32 ",%" PRIu32 "\n", name, rows,
+         cols, PIPELINE_BENCH_ITERATIONS, per_op_x100 / 100, per_op_x100 % 100,
+         ns_per_op);
+}
+
+void pipeline_bench_run(void) {
+  static const uint8_t sizes[][2] = {{ROW_NUM, COL_NUM}, {8, 16}, {16, 16}};
+
+  printf("bench,rows,cols,iterations,cycles_per_op,ns_per_op\n");
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    s_rows = sizes[i][0];
+    make_frames(sizes[i][0], sizes[i][1]);
+
+    debounce_init(&s_debounce, s_rows, DEBOUNCE_EAGER);
+    run("debounce_eager", sizes[i][0], sizes[i][1], bench_debounce);
+    debounce_init(&s_debounce, s_rows, DEBOUNCE_DEFERRED);
+    run("debounce_deferred", sizes[i][0], sizes[i][1], bench_debounce);
+    debounce_init(&s_debounce, s_rows, BUTTON_DEBOUNCE_MODE);
+    run("scan_frame", sizes[i][0], sizes[i][1], bench_frame);
+  }
+
+  matrix_io_init(NULL);
+  run("matrix_io", ROW_NUM, COL_NUM, bench_matrix_io);
+
+  // 报告构建的 cols 列为报告长度
+  hid_report_init(bench_send);
+  hid_report_set_nkro(true);
+  run("report_nkro", 1, HID_NKRO_IN_RPT_LEN, bench_report);
+  hid_report_set_nkro(false);
+  run("report_6kro", 1, HID_KEY_IN_RPT_LEN, bench_report);
+  hid_report_set_nkro(true);
+  hid_report_init(NULL);
+
+  // 扫描结果索引的 rows 列为广播设备数，cols 列为索引容量
+  // 每个广播包的耗时应与设备数无关
+  static const uint16_t advertisers[] = {8, 64, BENCH_ADVERTISERS};
+  make_bdas();
+  for (size_t i = 0; i < sizeof(advertisers) / sizeof(advertisers[0]); i++) {
+    s_advertisers = advertisers[i];
+    scan_index_init(&s_scan_index);
+    run("scan_index", advertisers[i], SCAN_INDEX_MAX_RESULTS, bench_scan);
+  }
+}
+
+#endif /* PIPELINE_BENCH_ENABLED */
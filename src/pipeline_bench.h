@@ -0,0 +1,29 @@
+#ifndef PIPELINE_BENCH_H
+#define PIPELINE_BENCH_H
+
+// 按键处理流水线基准测试：扫描一帧、消抖、报告构建的 CPU 周期数
+// 启用后在 app_main 开头、蓝牙初始化之前运行一次，结果以 CSV 输出到串口：
+// bench,rows,cols,iterations,cycles_per_op,ns_per_op
+#ifndef PIPELINE_BENCH_ENABLED
+#define PIPELINE_BENCH_ENABLED 0
+#endif
+
+// 每项测试的迭代次数，取多轮中的最小值以排除中断干扰
+#ifndef PIPELINE_BENCH_ITERATIONS
+#define PIPELINE_BENCH_ITERATIONS 1000
+#endif
+#ifndef PIPELINE_BENCH_ROUNDS
+#define PIPELINE_BENCH_ROUNDS 5
+#endif
+
+#if PIPELINE_BENCH_ENABLED
+
+void pipeline_bench_run(void);
+
+#else
+
+static inline void pipeline_bench_run(void) {}
+
+#endif /* PIPELINE_BENCH_ENABLED */
+
+#endif /* PIPELINE_BENCH_H */
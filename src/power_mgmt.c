@@ -0,0 +1,108 @@
+#include "power_mgmt.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "POWER";
+
+static const char *const lock_names[POWER_LOCK_NUM] = {"scan", "tx"};
+
+typedef struct {
+  bool held;
+  int64_t since_us;  // 本次持有开始的时间
+  int64_t total_us;  // 已释放部分的累计持有时间
+#ifdef CONFIG_PM_ENABLE
+  esp_pm_lock_handle_t handle;
+#endif
+} power_lock_state_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_lock_state_t s_locks[POWER_LOCK_NUM];
+static int64_t s_start_us = 0;
+
+void power_init(void) {
+  s_start_us = esp_timer_get_time();
+
+#ifdef CONFIG_PM_ENABLE
+  // 蓝牙控制器在连接事件之间自行持有/释放锁（modem sleep），
+  // 扫描和发送任务只在工作期间持锁，其余时间进入浅睡眠
+  esp_pm_config_t config = {
+      .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .min_freq_mhz = POWER_MIN_FREQ_MHZ,
+      .light_sleep_enable = POWER_LIGHT_SLEEP_ENABLED,
+  };
+  esp_err_t err = esp_pm_configure(&config);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+  }
+  for (int i = 0; i < POWER_LOCK_NUM; i++) {
+    if (s_locks[i].handle == NULL) {
+      ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0,
+                                         lock_names[i], &s_locks[i].handle));
+    }
+  }
+  ESP_LOGI(TAG, "CPU %d~%d MHz, light sleep %s", POWER_MIN_FREQ_MHZ,
+           CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+           POWER_LIGHT_SLEEP_ENABLED ? "on" : "off");
+#else
+  ESP_LOGI(TAG, "power management disabled (CONFIG_PM_ENABLE)");
+#endif
+}
+
+void power_lock_set(power_lock_t lock, bool held) {
+  power_lock_state_t *state = &s_locks[lock];
+  if (state->held == held) {
+    return;
+  }
+
+#ifdef CONFIG_PM_ENABLE
+  if (state->handle) {
+    if (held) {
+      esp_pm_lock_acquire(state->handle);
+    } else {
+      esp_pm_lock_release(state->handle);
+    }
+  }
+#endif
+
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_lock);
+  if (held) {
+    state->since_us = now;
+  } else {
+    state->total_us += now - state->since_us;
+  }
+  state->held = held;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void power_print(void) {
+  int64_t now = esp_timer_get_time();
+  int64_t uptime_us = now - s_start_us;
+  if (uptime_us <= 0) {
+    return;
+  }
+
+  ESP_LOGI(TAG, "uptime %" PRId64 " ms", uptime_us / 1000);
+  for (int i = 0; i < POWER_LOCK_NUM; i++) {
+    portENTER_CRITICAL(&s_lock);
+    int64_t held_us = s_locks[i].total_us;
+    if (s_locks[i].held) {
+      held_us += now - s_locks[i].since_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "  %-4s held %" PRId64 " ms (%" PRId64 ".%" PRId64 "%%)",
+             lock_names[i], held_us / 1000, held_us * 100 / uptime_us,
+             held_us * 1000 / uptime_us % 10);
+  }
+
+#ifdef CONFIG_PM_PROFILING
+  // 各电源模式的累计时间，SLEEP 一行即浅睡眠时间
+  esp_pm_dump_locks(stdout);
+#endif
+}
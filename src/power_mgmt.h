@@ -0,0 +1,41 @@
+#ifndef POWER_MGMT_H
+#define POWER_MGMT_H
+
+#include <stdbool.h>
+
+// 下面的默认值依赖 CONFIG_ 选项，不能假设包含者已经包含过 IDF 头文件
+#include "sdkconfig.h"
+
+// 空闲时 CPU 降到的频率 (MHz)，默认为晶振频率
+#ifndef POWER_MIN_FREQ_MHZ
+#define POWER_MIN_FREQ_MHZ 40
+#endif
+
+// 没有持有锁时是否允许自动浅睡眠，需要 FreeRTOS tickless idle
+#ifndef POWER_LIGHT_SLEEP_ENABLED
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#define POWER_LIGHT_SLEEP_ENABLED 1
+#else
+#define POWER_LIGHT_SLEEP_ENABLED 0
+#endif
+#endif
+
+// 阻止浅睡眠的锁，每个只由一个任务持有
+typedef enum {
+  POWER_LOCK_SCAN = 0,  // 扫描定时器运行期间（有按键按住或正在消抖）
+  POWER_LOCK_TX,        // 有报告等待合并窗口结束发送
+  POWER_LOCK_NUM,
+} power_lock_t;
+
+// 配置动态调频和浅睡眠，需在扫描和蓝牙初始化之前调用
+// 未开启 CONFIG_PM_ENABLE 时只做持锁时间统计
+void power_init(void);
+
+// 持有/释放锁，重复设置相同状态无效果
+void power_lock_set(power_lock_t lock, bool held);
+
+// 输出各个锁的持有时间占比；开启 CONFIG_PM_PROFILING 时
+// 同时输出各电源模式（最高频率、最低频率、浅睡眠）的累计时间
+void power_print(void);
+
+#endif /* POWER_MGMT_H */
@@ -0,0 +1,97 @@
+#include "scan_index.h"
+
+#include <string.h>
+
+_Static_assert((SCAN_INDEX_SLOTS & (SCAN_INDEX_SLOTS - 1)) == 0,
+               "SCAN_INDEX_SLOTS must be a power of two");
+_Static_assert(SCAN_INDEX_SLOTS >= 2 * SCAN_INDEX_MAX_RESULTS,
+               "SCAN_INDEX_SLOTS must keep the load factor at or below 1/2");
+_Static_assert(SCAN_INDEX_MAX_RESULTS < 256,
+               "slot entries store a result index in 8 bits");
+_Static_assert(offsetof(scan_index_t, results) == 0,
+               "results must start the allocation");
+
+// FNV-1a：随机地址和厂商地址的低字节都足够分散
+static uint32_t hash_bda(const uint8_t *bda, esp_hid_transport_t transport) {
+  uint32_t h = 2166136261u ^ (uint32_t)transport;
+  for (int i = 0; i < ESP_BD_ADDR_LEN; i++) {
+    h = (h ^ bda[i]) * 16777619u;
+  }
+  return h;
+}
+
+// 查找设备所在的槽位，不存在时为探测序列上的第一个空槽位
+static uint32_t probe(const scan_index_t *index, const uint8_t *bda,
+                      esp_hid_transport_t transport) {
+  uint32_t slot = hash_bda(bda, transport) & (SCAN_INDEX_SLOTS - 1);
+  // 装载率不超过 1/2，一定能遇到空槽位
+  while (index->slots[slot] != 0) {
+    const esp_hid_scan_result_t *r = &index->results[index->slots[slot] - 1];
+    if (r->transport == transport &&
+        memcmp(r->bda, bda, ESP_BD_ADDR_LEN) == 0) {
+      break;
+    }
+    slot = (slot + 1) & (SCAN_INDEX_SLOTS - 1);
+  }
+  return slot;
+}
+
+void scan_index_init(scan_index_t *index) {
+  memset(index->slots, 0, sizeof(index->slots));
+  index->count = 0;
+  index->names_used = 0;
+  index->dropped = 0;
+}
+
+esp_hid_scan_result_t *scan_index_find(scan_index_t *index,
+                                       const uint8_t *bda,
+                                       esp_hid_transport_t transport) {
+  uint8_t entry = index->slots[probe(index, bda, transport)];
+  return entry != 0 ? &index->results[entry - 1] : NULL;
+}
+
+esp_hid_scan_result_t *scan_index_insert(scan_index_t *index,
+                                         const uint8_t *bda,
+                                         esp_hid_transport_t transport,
+                                         bool *created) {
+  uint32_t slot = probe(index, bda, transport);
+  *created = false;
+  if (index->slots[slot] != 0) {
+    return &index->results[index->slots[slot] - 1];
+  }
+  if (index->count == SCAN_INDEX_MAX_RESULTS) {
+    index->dropped++;
+    return NULL;
+  }
+  esp_hid_scan_result_t *r = &index->results[index->count++];
+  memset(r, 0, sizeof(*r));
+  memcpy(r->bda, bda, ESP_BD_ADDR_LEN);
+  r->transport = transport;
+  index->slots[slot] = (uint8_t)index->count;
+  *created = true;
+  return r;
+}
+
+const char *scan_index_name(scan_index_t *index, const uint8_t *name,
+                            size_t len) {
+  if (len + 1 > (size_t)(SCAN_INDEX_NAMES_LEN - index->names_used)) {
+    index->dropped++;
+    return NULL;
+  }
+  char *s = &index->names[index->names_used];
+  memcpy(s, name, len);
+  s[len] = 0;
+  index->names_used += len + 1;
+  return s;
+}
+
+esp_hid_scan_result_t *scan_index_list(scan_index_t *index) {
+  if (index->count == 0) {
+    return NULL;
+  }
+  for (int i = 0; i < index->count - 1; i++) {
+    index->results[i].next = &index->results[i + 1];
+  }
+  index->results[index->count - 1].next = NULL;
+  return &index->results[0];
+}
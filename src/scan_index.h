@@ -0,0 +1,61 @@
+#ifndef SCAN_INDEX_H
+#define SCAN_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_hid_gap.h"
+
+// 扫描结果索引：按 BDA 和传输方式查找，开放寻址 + 线性探测
+// 结果和名字都在同一块内存中，一次扫描只分配一次，不随广播包数量增长
+// 每个广播包的查找只比较探测序列上的几个槽位，与已收到的设备数无关
+
+// 最多保存的扫描结果数，超过后新设备被丢弃
+#ifndef SCAN_INDEX_MAX_RESULTS
+#define SCAN_INDEX_MAX_RESULTS 64
+#endif
+
+// 槽位数，必须是 2 的幂且不少于结果数的 2 倍，装载率不超过 1/2
+#ifndef SCAN_INDEX_SLOTS
+#define SCAN_INDEX_SLOTS 128
+#endif
+
+// 所有设备名字共用的存储区 (字节)，包括结尾的 0
+#ifndef SCAN_INDEX_NAMES_LEN
+#define SCAN_INDEX_NAMES_LEN 1024
+#endif
+
+typedef struct {
+  // 必须是第一个成员：返回的结果链表从 results[0] 开始，
+  // esp_hid_scan_results_free 直接释放整个索引
+  esp_hid_scan_result_t results[SCAN_INDEX_MAX_RESULTS];
+  uint8_t slots[SCAN_INDEX_SLOTS];  // 0 为空，否则为 results 下标 + 1
+  uint16_t count;
+  uint16_t names_used;
+  uint32_t dropped;  // 结果或名字存储区已满而丢弃的次数
+  char names[SCAN_INDEX_NAMES_LEN];
+} scan_index_t;
+
+void scan_index_init(scan_index_t *index);
+
+// 查找设备，不存在时返回 NULL
+esp_hid_scan_result_t *scan_index_find(scan_index_t *index,
+                                       const uint8_t *bda,
+                                       esp_hid_transport_t transport);
+
+// 查找设备，不存在时插入一个只填好 bda 和 transport 的新结果
+// created 指示是否为新插入的结果；索引已满时返回 NULL
+esp_hid_scan_result_t *scan_index_insert(scan_index_t *index,
+                                         const uint8_t *bda,
+                                         esp_hid_transport_t transport,
+                                         bool *created);
+
+// 复制名字到存储区并加上结尾的 0，存储区不足时返回 NULL
+const char *scan_index_name(scan_index_t *index, const uint8_t *name,
+                            size_t len);
+
+// 按插入顺序把结果串成链表，没有结果时返回 NULL
+esp_hid_scan_result_t *scan_index_list(scan_index_t *index);
+
+#endif /* SCAN_INDEX_H */
@@ -0,0 +1,9 @@
+// 在主机上运行 pipeline_bench，CPU 周期计数由替身换成单调时钟的纳秒数，
+// 因此 cycles_per_op 与 ns_per_op 相同，用于比较修改前后的相对耗时
+
+#include "pipeline_bench.h"
+
+int main(void) {
+  pipeline_bench_run();
+  return 0;
+}
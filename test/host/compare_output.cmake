@@ -0,0 +1,13 @@
+# 运行 keyboard_sim 脚本，把 stdout 与预期输出比较
+execute_process(COMMAND ${PROGRAM} ${SCRIPT}
+  OUTPUT_VARIABLE actual
+  ERROR_VARIABLE log
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${SCRIPT} exited with ${result}\n${log}")
+endif()
+file(READ ${EXPECTED} expected)
+if(NOT actual STREQUAL expected)
+  message(FATAL_ERROR "output of ${SCRIPT} differs from ${EXPECTED}\n"
+    "--- expected\n${expected}--- actual\n${actual}")
+endif()
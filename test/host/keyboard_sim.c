@@ -0,0 +1,209 @@
+// 键盘固件的主机仿真：按脚本在虚拟时间中按键、连接和断开主机，
+// 运行 app_main 启动的扫描任务和发送任务，输出主机收到的报告
+//
+// 用法：keyboard_sim <脚本>
+// 脚本每行为 "<毫秒> <命令> [参数]"，# 之后为注释，命令：
+//   connect [peer] [interval]  主机连接，peer 为地址末字节，interval 为 1.25ms 单位
+//   encrypt                    完成配对/加密
+//   disconnect [reason]        主机断开
+//   press <row> <col>          按下按键
+//   release <row> <col>        释放按键
+//   protocol boot|report       主机切换协议模式
+//   capacity <per_event> <buffered>  每个连接事件发出的通知数和控制器缓冲区大小
+//   reject on|off              主机拒绝连接参数更新
+//   drop <n> / stall <n>       之后 n 个通知的 CONF 失败 / 永远没有 CONF
+//   congest on|off             协议栈拥塞开始或解除
+//   foreign_conf               HID 服务之外的特征发出 CONF
+//   end                        仿真结束时间
+// 输出 (stdout) 每行以虚拟时间 (us) 开头；固件日志输出到 stderr
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "button_scan.h"
+#include "sim.h"
+
+#define SCRIPT_MAX_STEPS 1024
+
+typedef enum {
+  CMD_CONNECT,
+  CMD_ENCRYPT,
+  CMD_DISCONNECT,
+  CMD_PRESS,
+  CMD_RELEASE,
+  CMD_PROTOCOL,
+  CMD_CAPACITY,
+  CMD_REJECT,
+  CMD_DROP,
+  CMD_STALL,
+  CMD_CONGEST,
+  CMD_FOREIGN_CONF,
+  CMD_END,
+} command_t;
+
+typedef struct {
+  int64_t at_us;
+  command_t cmd;
+  int arg[2];
+} step_t;
+
+static step_t s_steps[SCRIPT_MAX_STEPS];
+static int s_num_steps = 0;
+
+void app_main(void);
+
+static void main_task(void *arg) {
+  app_main();
+  vTaskDelete(NULL);
+}
+
+static void print_time(void) { printf("%9lld ", (long long)sim_now()); }
+
+static void run_step(void *arg) {
+  const step_t *step = arg;
+  switch (step->cmd) {
+    case CMD_CONNECT: {
+      uint8_t peer[6] = {0x11, 0x22, 0x33, 0x44, 0x55, (uint8_t)step->arg[0]};
+      sim_link_connect(peer, step->arg[1]);
+      break;
+    }
+    case CMD_ENCRYPT:
+      sim_link_encrypt();
+      break;
+    case CMD_DISCONNECT:
+      sim_link_disconnect(step->arg[0]);
+      break;
+    case CMD_PRESS:
+    case CMD_RELEASE:
+      print_time();
+      printf("key %d %d %s\n", step->arg[0], step->arg[1],
+             step->cmd == CMD_PRESS ? "down" : "up");
+      sim_matrix_set(step->arg[0], step->arg[1], step->cmd == CMD_PRESS);
+      break;
+    case CMD_PROTOCOL:
+      sim_link_protocol_mode(step->arg[0]);
+      break;
+    case CMD_CAPACITY:
+      sim_link_set_capacity(step->arg[0], step->arg[1]);
+      break;
+    case CMD_REJECT:
+      sim_link_reject_updates(step->arg[0]);
+      break;
+    case CMD_DROP:
+    case CMD_STALL:
+      sim_link_fail_next(step->arg[0], step->cmd == CMD_DROP);
+      break;
+    case CMD_CONGEST:
+      sim_link_congest(step->arg[0]);
+      break;
+    case CMD_FOREIGN_CONF:
+      sim_link_foreign_conf();
+      break;
+    case CMD_END:
+      break;
+  }
+}
+
+static bool parse_switch(const char *word, const char *on, int *out) {
+  if (word == NULL) {
+    return false;
+  }
+  *out = strcmp(word, on) == 0;
+  return true;
+}
+
+// 解析一行，成功时返回 true
+static bool parse_line(char *line, step_t *step) {
+  char *ms = strtok(line, " \t\r\n");
+  char *cmd = strtok(NULL, " \t\r\n");
+  char *a = strtok(NULL, " \t\r\n");
+  char *b = strtok(NULL, " \t\r\n");
+  if (ms == NULL || cmd == NULL) {
+    return false;
+  }
+  step->at_us = strtoll(ms, NULL, 10) * 1000;
+  step->arg[0] = a ? (int)strtol(a, NULL, 0) : 0;
+  step->arg[1] = b ? (int)strtol(b, NULL, 0) : 0;
+
+  if (strcmp(cmd, "connect") == 0) {
+    step->cmd = CMD_CONNECT;
+    step->arg[0] = a ? step->arg[0] : 1;
+    step->arg[1] = b ? step->arg[1] : 24;
+  } else if (strcmp(cmd, "encrypt") == 0) {
+    step->cmd = CMD_ENCRYPT;
+  } else if (strcmp(cmd, "disconnect") == 0) {
+    step->cmd = CMD_DISCONNECT;
+    step->arg[0] = a ? step->arg[0] : 0x13;
+  } else if (strcmp(cmd, "press") == 0 || strcmp(cmd, "release") == 0) {
+    step->cmd = cmd[0] == 'p' ? CMD_PRESS : CMD_RELEASE;
+    if (b == NULL || step->arg[0] >= ROW_NUM || step->arg[1] >= COL_NUM) {
+      return false;
+    }
+  } else if (strcmp(cmd, "protocol") == 0) {
+    step->cmd = CMD_PROTOCOL;
+    return parse_switch(a, "report", &step->arg[0]);
+  } else if (strcmp(cmd, "capacity") == 0) {
+    step->cmd = CMD_CAPACITY;
+    return b != NULL;
+  } else if (strcmp(cmd, "reject") == 0) {
+    step->cmd = CMD_REJECT;
+    return parse_switch(a, "on", &step->arg[0]);
+  } else if (strcmp(cmd, "drop") == 0 || strcmp(cmd, "stall") == 0) {
+    step->cmd = cmd[0] == 'd' ? CMD_DROP : CMD_STALL;
+    return a != NULL;
+  } else if (strcmp(cmd, "congest") == 0) {
+    step->cmd = CMD_CONGEST;
+    return parse_switch(a, "on", &step->arg[0]);
+  } else if (strcmp(cmd, "foreign_conf") == 0) {
+    step->cmd = CMD_FOREIGN_CONF;
+  } else if (strcmp(cmd, "end") == 0) {
+    step->cmd = CMD_END;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <script>\n", argv[0]);
+    return 2;
+  }
+  FILE *file = fopen(argv[1], "r");
+  if (file == NULL) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  char line[256];
+  int line_no = 0;
+  int64_t end_us = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    line_no++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+    if (strspn(line, " \t\r\n") == strlen(line)) {
+      continue;
+    }
+    if (s_num_steps == SCRIPT_MAX_STEPS ||
+        !parse_line(line, &s_steps[s_num_steps])) {
+      fprintf(stderr, "%s:%d: invalid line\n", argv[1], line_no);
+      return 2;
+    }
+    step_t *step = &s_steps[s_num_steps++];
+    if (step->at_us > end_us) {
+      end_us = step->at_us;
+    }
+    sim_at(step->at_us, run_step, step);
+  }
+  fclose(file);
+
+  sim_start_main(main_task);
+  sim_run_until(end_us);
+  print_time();
+  printf("end, %u reports received\n", sim_link_received());
+  return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// 主机构建替身：内存段属性在主机上没有意义
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+esp_err_t esp_bt_dev_set_device_name(const char *name);
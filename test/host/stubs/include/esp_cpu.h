@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// 主机上为单调时钟的纳秒数，esp_rom_get_cpu_ticks_per_us 返回 1000
+uint32_t esp_cpu_get_cycle_count(void);
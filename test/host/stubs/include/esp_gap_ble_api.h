@@ -0,0 +1,140 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+  ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT = 0,
+  ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT,
+  ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT,
+  ESP_GAP_BLE_SCAN_RESULT_EVT,
+  ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT,
+  ESP_GAP_BLE_SCAN_RSP_DATA_RAW_SET_COMPLETE_EVT,
+  ESP_GAP_BLE_ADV_START_COMPLETE_EVT,
+  ESP_GAP_BLE_SCAN_START_COMPLETE_EVT,
+  ESP_GAP_BLE_AUTH_CMPL_EVT,
+  ESP_GAP_BLE_KEY_EVT,
+  ESP_GAP_BLE_SEC_REQ_EVT,
+  ESP_GAP_BLE_PASSKEY_NOTIF_EVT,
+  ESP_GAP_BLE_PASSKEY_REQ_EVT,
+  ESP_GAP_BLE_OOB_REQ_EVT,
+  ESP_GAP_BLE_LOCAL_IR_EVT,
+  ESP_GAP_BLE_LOCAL_ER_EVT,
+  ESP_GAP_BLE_NC_REQ_EVT,
+  ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT,
+  ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT,
+  ESP_GAP_BLE_SET_STATIC_RAND_ADDR_EVT,
+  ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT,
+} esp_gap_ble_cb_event_t;
+
+// 绑定信息中的密钥类型，按位组合
+#define ESP_LE_KEY_NONE 0
+#define ESP_LE_KEY_PENC (1 << 0)
+#define ESP_LE_KEY_PID (1 << 1)
+#define ESP_LE_KEY_PCSRK (1 << 2)
+#define ESP_LE_KEY_PLK (1 << 3)
+typedef uint8_t esp_ble_key_type_t;
+typedef uint8_t esp_ble_key_mask_t;
+
+typedef enum {
+  ADV_TYPE_IND = 0x00,
+  ADV_TYPE_DIRECT_IND_HIGH = 0x01,
+  ADV_TYPE_SCAN_IND = 0x02,
+  ADV_TYPE_NONCONN_IND = 0x03,
+  ADV_TYPE_DIRECT_IND_LOW = 0x04,
+} esp_ble_adv_type_t;
+
+typedef enum {
+  ADV_CHNL_37 = 0x01,
+  ADV_CHNL_38 = 0x02,
+  ADV_CHNL_39 = 0x04,
+  ADV_CHNL_ALL = 0x07,
+} esp_ble_adv_channel_t;
+
+typedef enum {
+  ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY = 0x00,
+  ADV_FILTER_ALLOW_SCAN_WLST_CON_ANY,
+  ADV_FILTER_ALLOW_SCAN_ANY_CON_WLST,
+  ADV_FILTER_ALLOW_SCAN_WLST_CON_WLST,
+} esp_ble_adv_filter_t;
+
+typedef struct {
+  uint16_t adv_int_min;
+  uint16_t adv_int_max;
+  esp_ble_adv_type_t adv_type;
+  esp_ble_addr_type_t own_addr_type;
+  esp_bd_addr_t peer_addr;
+  esp_ble_addr_type_t peer_addr_type;
+  esp_ble_adv_channel_t channel_map;
+  esp_ble_adv_filter_t adv_filter_policy;
+} esp_ble_adv_params_t;
+
+typedef struct {
+  esp_bd_addr_t bda;
+  uint16_t min_int;
+  uint16_t max_int;
+  uint16_t latency;
+  uint16_t timeout;
+} esp_ble_conn_update_params_t;
+
+typedef struct {
+  uint8_t irk[16];
+  esp_ble_addr_type_t addr_type;
+  esp_bd_addr_t static_addr;
+} esp_ble_pid_keys_t;
+
+typedef struct {
+  esp_ble_key_mask_t key_mask;
+  esp_ble_pid_keys_t pid_key;
+} esp_ble_bond_key_info_t;
+
+typedef struct {
+  esp_bd_addr_t bd_addr;
+  esp_ble_bond_key_info_t bond_key;
+} esp_ble_bond_dev_t;
+
+typedef struct {
+  esp_bd_addr_t bd_addr;
+  bool key_present;
+  uint8_t key[16];
+  uint8_t key_type;
+  bool success;
+  uint8_t fail_reason;
+  esp_ble_addr_type_t addr_type;
+  uint8_t dev_type;
+  uint8_t auth_mode;
+} esp_ble_auth_cmpl_t;
+
+typedef union {
+  esp_ble_auth_cmpl_t auth_cmpl;
+} esp_ble_sec_t;
+
+typedef union {
+  struct ble_adv_start_cmpl_evt_param {
+    esp_bt_status_t status;
+  } adv_start_cmpl;
+  struct ble_adv_stop_cmpl_evt_param {
+    esp_bt_status_t status;
+  } adv_stop_cmpl;
+  struct ble_update_conn_params_evt_param {
+    esp_bt_status_t status;
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t conn_int;
+    uint16_t timeout;
+  } update_conn_params;
+  esp_ble_sec_t ble_security;
+} esp_ble_gap_cb_param_t;
+
+typedef void (*esp_gap_ble_cb_t)(esp_gap_ble_cb_event_t event,
+                                 esp_ble_gap_cb_param_t *param);
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t *adv_params);
+esp_err_t esp_ble_gap_stop_advertising(void);
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params);
+esp_err_t esp_ble_gap_disconnect(esp_bd_addr_t remote_device);
+int esp_ble_get_bond_device_num(void);
+esp_err_t esp_ble_get_bond_device_list(int *dev_num,
+                                       esp_ble_bond_dev_t *dev_list);
+esp_err_t esp_ble_remove_bond_device(esp_bd_addr_t bd_addr);
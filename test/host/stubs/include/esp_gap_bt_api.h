@@ -0,0 +1,11 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+typedef struct {
+  uint32_t reserved_2 : 2;
+  uint32_t minor : 6;
+  uint32_t major : 5;
+  uint32_t service : 11;
+  uint32_t reserved_8 : 8;
+} esp_bt_cod_t;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+#define ESP_GATT_UUID_PRI_SERVICE 0x2800
+#define ESP_GATT_UUID_CHAR_DECLARE 0x2803
+#define ESP_GATT_UUID_HID_SVC 0x1812
+#define ESP_GATT_UUID_BATTERY_SERVICE_SVC 0x180F
+
+#define ESP_GATT_IF_NONE 0xff
+typedef uint8_t esp_gatt_if_t;
+
+typedef enum {
+  ESP_GATT_OK = 0x0,
+  ESP_GATT_INVALID_HANDLE = 0x01,
+  ESP_GATT_INVALID_OFFSET = 0x07,
+  ESP_GATT_ERROR = 0x85,
+  ESP_GATT_CONGESTED = 0x8f,
+} esp_gatt_status_t;
+
+#define ESP_GATT_PERM_READ (1 << 0)
+#define ESP_GATT_PERM_READ_ENCRYPTED (1 << 1)
+#define ESP_GATT_PERM_WRITE (1 << 4)
+#define ESP_GATT_PERM_WRITE_ENCRYPTED (1 << 5)
+typedef uint16_t esp_gatt_perm_t;
+
+#define ESP_GATT_CHAR_PROP_BIT_READ (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE (1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY (1 << 4)
+typedef uint8_t esp_gatt_char_prop_t;
+
+#define ESP_GATT_RSP_BY_APP 0
+#define ESP_GATT_AUTO_RSP 1
+#define ESP_GATT_MAX_ATTR_LEN 512
+
+typedef struct {
+  uint16_t uuid_length;
+  uint8_t *uuid_p;
+  uint16_t perm;
+  uint16_t max_length;
+  uint16_t length;
+  uint8_t *value;
+} esp_attr_desc_t;
+
+typedef struct {
+  uint8_t auto_rsp;
+} esp_attr_control_t;
+
+typedef struct {
+  esp_attr_control_t attr_control;
+  esp_attr_desc_t att_desc;
+} esp_gatts_attr_db_t;
+
+typedef struct {
+  uint8_t value[ESP_GATT_MAX_ATTR_LEN];
+  uint16_t handle;
+  uint16_t offset;
+  uint16_t len;
+  uint8_t auth_req;
+} esp_gatt_value_t;
+
+typedef union {
+  esp_gatt_value_t attr_value;
+  uint16_t handle;
+} esp_gatt_rsp_t;
+
+typedef struct {
+  uint16_t interval;
+  uint16_t latency;
+  uint16_t timeout;
+} esp_gatt_conn_params_t;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+  ESP_HID_TRANSPORT_BT,
+  ESP_HID_TRANSPORT_BLE,
+  ESP_HID_TRANSPORT_USB,
+  ESP_HID_TRANSPORT_MAX,
+} esp_hid_transport_t;
+
+typedef enum {
+  ESP_HID_USAGE_GENERIC = 0,
+  ESP_HID_USAGE_KEYBOARD = 1,
+  ESP_HID_USAGE_MOUSE = 2,
+  ESP_HID_USAGE_JOYSTICK = 4,
+  ESP_HID_USAGE_GAMEPAD = 8,
+  ESP_HID_USAGE_TABLET = 16,
+  ESP_HID_USAGE_CCONTROL = 32,
+  ESP_HID_USAGE_VENDOR = 64,
+} esp_hid_usage_t;
+
+typedef enum {
+  ESP_HID_PROTOCOL_MODE_BOOT = 0x00,
+  ESP_HID_PROTOCOL_MODE_REPORT = 0x01,
+} esp_hid_protocol_mode_t;
+
+typedef struct {
+  const uint8_t *data;
+  uint16_t len;
+} esp_hid_raw_report_map_t;
+
+typedef struct {
+  uint16_t vendor_id;
+  uint16_t product_id;
+  uint16_t version;
+  const char *device_name;
+  const char *manufacturer_name;
+  const char *serial_number;
+  esp_hid_raw_report_map_t *report_maps;
+  uint8_t report_maps_len;
+} esp_hid_device_config_t;
+
+const char *esp_hid_usage_str(esp_hid_usage_t usage);
+const char *esp_hid_disconnect_reason_str(esp_hid_transport_t transport,
+                                          int reason);
@@ -0,0 +1,74 @@
+#pragma once
+
+// 主机构建替身：sim_ble.c 记录输入报告，并按连接间隔模拟通知发送和 CONF 事件
+
+#include "esp_event.h"
+#include "esp_gatts_api.h"
+#include "esp_hid_common.h"
+
+typedef struct esp_hidd_dev_s esp_hidd_dev_t;
+
+typedef enum {
+  ESP_HIDD_ANY_EVENT = -1,
+  ESP_HIDD_START_EVENT = 0,
+  ESP_HIDD_CONNECT_EVENT,
+  ESP_HIDD_PROTOCOL_MODE_EVENT,
+  ESP_HIDD_CONTROL_EVENT,
+  ESP_HIDD_OUTPUT_EVENT,
+  ESP_HIDD_FEATURE_EVENT,
+  ESP_HIDD_DISCONNECT_EVENT,
+  ESP_HIDD_STOP_EVENT,
+} esp_hidd_event_t;
+
+typedef union {
+  struct {
+    esp_err_t status;
+  } start;
+  struct {
+    esp_err_t status;
+    esp_hidd_dev_t *dev;
+  } connect;
+  struct {
+    esp_err_t status;
+    esp_hidd_dev_t *dev;
+    int reason;
+  } disconnect;
+  struct {
+    esp_hidd_dev_t *dev;
+    size_t map_index;
+    uint8_t protocol_mode;
+  } protocol_mode;
+  struct {
+    esp_hidd_dev_t *dev;
+    size_t map_index;
+    uint8_t control;
+  } control;
+  struct {
+    esp_hidd_dev_t *dev;
+    esp_hid_usage_t usage;
+    uint16_t report_id;
+    uint16_t length;
+    uint8_t *data;
+    size_t map_index;
+  } output;
+  struct {
+    esp_hidd_dev_t *dev;
+    esp_hid_usage_t usage;
+    uint16_t report_id;
+    uint16_t length;
+    uint8_t *data;
+    size_t map_index;
+  } feature;
+} esp_hidd_event_data_t;
+
+esp_err_t esp_hidd_dev_init(const esp_hid_device_config_t *config,
+                            esp_hid_transport_t transport,
+                            esp_event_handler_t callback,
+                            esp_hidd_dev_t **dev);
+esp_err_t esp_hidd_dev_input_set(esp_hidd_dev_t *dev, size_t map_index,
+                                 size_t report_id, uint8_t *data,
+                                 size_t length);
+esp_hid_transport_t esp_hidd_dev_transport_get(esp_hidd_dev_t *dev);
+void esp_hidd_gatts_event_handler(esp_gatts_cb_event_t event,
+                                  esp_gatt_if_t gatts_if,
+                                  esp_ble_gatts_cb_param_t *param);
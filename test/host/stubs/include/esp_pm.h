@@ -0,0 +1,5 @@
+#pragma once
+
+// 主机构建不定义 CONFIG_PM_ENABLE，这里只保证头文件可以包含
+
+#include "esp_err.h"
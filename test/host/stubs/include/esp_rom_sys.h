@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+// 忙等待：仿真中推进虚拟时间，期间不切换任务
+void esp_rom_delay_us(uint32_t us);
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
@@ -0,0 +1,49 @@
+#pragma once
+
+// 主机构建替身：sim_rtos.c 中的虚拟时间调度器
+// 任务只在阻塞调用处或唤醒更高优先级任务时切换，同一时刻只有一个任务运行，
+// 临界区只用于推迟抢占
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+// 与 sdkconfig 中的 CONFIG_FREERTOS_HZ 相同
+#define configTICK_RATE_HZ 100
+#define configMAX_PRIORITIES 25
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) \
+  ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define configASSERT(x) \
+  do {                  \
+    if (!(x)) {         \
+      abort();          \
+    }                   \
+  } while (0)
+
+typedef struct {
+  int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void sim_enter_critical(void);
+void sim_exit_critical(void);
+void sim_yield_from_isr(BaseType_t woken);
+
+#define portENTER_CRITICAL(mux) ((void)(mux), sim_enter_critical())
+#define portEXIT_CRITICAL(mux) ((void)(mux), sim_exit_critical())
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(woken) sim_yield_from_isr(woken)
@@ -0,0 +1,3 @@
+#pragma once
+
+// 主机构建的 CONFIG_ 选项由 CMakeLists.txt 的编译定义给出，这里为空
@@ -0,0 +1,52 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_gap_ble_api.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 主机仿真：虚拟时间的 FreeRTOS/esp_timer、虚拟按键矩阵和 BLE 链路
+// 时间只在所有任务都阻塞时推进，代码执行不占用时间，同一脚本每次运行的输出相同
+
+// 调度器中执行的事件，与 esp_timer 回调在同一上下文
+typedef void (*sim_event_fn_t)(void *arg);
+
+// 当前虚拟时间 (us)，即 esp_timer_get_time
+int64_t sim_now(void);
+
+// 在虚拟时间 at_us 执行 fn，早于当前时间时在下一次调度时执行
+void sim_at(int64_t at_us, sim_event_fn_t fn, void *arg);
+
+// 运行任务和到期的定时器，直到虚拟时间到达 until_us
+void sim_run_until(int64_t until_us);
+
+// 以 app_main 的优先级创建任务，用于运行固件入口
+TaskHandle_t sim_start_main(TaskFunction_t fn);
+
+// 虚拟按键矩阵：设置按键触点状态，空闲等待期间按下会触发列中断
+void sim_matrix_set(uint8_t row, uint8_t col, bool pressed);
+
+// BLE 链路：主机连接、完成加密、断开，在调度器上下文中调用
+void sim_link_connect(const uint8_t *peer, uint16_t interval);
+void sim_link_encrypt(void);
+void sim_link_disconnect(int reason);
+void sim_link_protocol_mode(bool report);
+
+// 链路容量：每个连接事件发出的通知数和控制器缓冲区的通知数
+void sim_link_set_capacity(uint32_t per_event, uint32_t buffered);
+// 主机拒绝之后的连接参数更新请求
+void sim_link_reject_updates(bool reject);
+// 之后 count 个通知：drop 为 true 时 CONF 返回失败，否则永远没有 CONF
+void sim_link_fail_next(uint32_t count, bool drop);
+// 拥塞开始或解除，协议栈发出 CONGEST 事件
+void sim_link_congest(bool congested);
+// HID 服务之外的特征发出的 CONF，例如电池电量通知
+void sim_link_foreign_conf(void);
+
+// 主机收到的输入报告数
+uint32_t sim_link_received(void);
+
+#endif /* SIM_H */
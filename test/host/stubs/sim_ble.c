@@ -0,0 +1,500 @@
+// BLE 协议栈和 esp_hidd 的主机替身
+// 协议栈事件在调度器上下文中回调，相当于 BTC 任务；主机侧行为由脚本控制：
+//   - esp_hidd_dev_input_set 把通知放进控制器缓冲区，每个连接事件发出
+//     per_event 个，发出时在 stdout 输出报告，并在 HID 服务的报告句柄上返回 CONF
+//   - 缓冲区满时通知被丢弃，协议栈报告拥塞并返回失败的 CONF
+//   - 连接参数更新请求在一个连接间隔后由主机接受或拒绝
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_bt_device.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+#include "esp_hid_gap.h"
+#include "esp_hidd.h"
+#include "esp_timer.h"
+#include "sim.h"
+
+#define SIM_MAX_APPS 4
+#define SIM_MAX_BONDS 8
+#define SIM_MAX_MAPS 4
+#define SIM_HID_TABLE_LEN 24  // 每个 HID 服务的属性数，报告 ID 小于 16
+#define SIM_QUEUE_LEN 64
+#define SIM_REPORT_MAX 32
+
+typedef enum {
+  FATE_DELIVER,
+  FATE_DROP,   // CONF 返回失败
+  FATE_STALL,  // 永远没有 CONF
+} notify_fate_t;
+
+typedef struct {
+  int64_t sent_us;
+  uint16_t handle;
+  uint8_t report_id;
+  uint8_t len;
+  uint8_t data[SIM_REPORT_MAX];
+  notify_fate_t fate;
+} notification_t;
+
+struct esp_hidd_dev_s {
+  esp_event_handler_t callback;
+  esp_hid_transport_t transport;
+};
+
+static esp_gatts_cb_t s_gatts_cb = NULL;
+static esp_gap_ble_cb_t s_gap_hook = NULL;
+static esp_gatt_if_t s_apps[SIM_MAX_APPS];  // 已注册应用的 gatts_if
+static uint8_t s_num_apps = 0;
+static uint16_t s_next_handle = 40;
+
+static struct esp_hidd_dev_s s_hidd;
+static esp_gatt_if_t s_hidd_if = ESP_GATT_IF_NONE;
+static uint16_t s_report_base[SIM_MAX_MAPS];  // 各 HID 服务的第一个句柄
+static uint16_t s_battery_handle = 0;
+
+static esp_ble_bond_dev_t s_bonds[SIM_MAX_BONDS];
+static int s_num_bonds = 0;
+
+// 链路状态
+static bool s_connected = false;
+static esp_bd_addr_t s_peer;
+static uint16_t s_interval = 24;  // 1.25ms 单位
+static uint16_t s_latency = 0;
+static uint16_t s_timeout = 400;
+static esp_timer_handle_t s_conn_event = NULL;
+static notification_t s_queue[SIM_QUEUE_LEN];
+static uint32_t s_queue_head = 0;
+static uint32_t s_queue_tail = 0;
+static uint32_t s_per_event = 4;
+static uint32_t s_buffered = 10;
+static bool s_congested = false;
+static bool s_reject_updates = false;
+static uint32_t s_fail_count = 0;
+static notify_fate_t s_fail_fate = FATE_DELIVER;
+static bool s_update_pending = false;
+static esp_ble_conn_update_params_t s_update;
+static uint32_t s_received = 0;
+
+static void print_time(void) { printf("%9lld ", (long long)sim_now()); }
+
+// ---- 回调分发 ----
+
+static void gatts_event(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+                        esp_ble_gatts_cb_param_t *param) {
+  if (s_gatts_cb != NULL) {
+    s_gatts_cb(event, gatts_if, param);
+  }
+}
+
+// 连接和断开事件发给每个应用
+static void gatts_event_all(esp_gatts_cb_event_t event,
+                            esp_ble_gatts_cb_param_t *param) {
+  gatts_event(event, s_hidd_if, param);
+  for (int i = 0; i < s_num_apps; i++) {
+    gatts_event(event, s_apps[i], param);
+  }
+}
+
+static void gap_event(esp_gap_ble_cb_event_t event,
+                      esp_ble_gap_cb_param_t *param) {
+  if (s_gap_hook != NULL) {
+    s_gap_hook(event, param);
+  }
+}
+
+static void hidd_event(esp_hidd_event_t event, esp_hidd_event_data_t *data) {
+  if (s_hidd.callback != NULL) {
+    s_hidd.callback(NULL, "ESP_HIDD_EVENTS", event, data);
+  }
+}
+
+// 分配属性表句柄并发出 CREAT_ATTR_TAB 事件
+static uint16_t create_table(esp_gatt_if_t gatts_if, const esp_bt_uuid_t *uuid,
+                             uint16_t num_handle) {
+  uint16_t handles[SIM_HID_TABLE_LEN];
+  uint16_t base = s_next_handle;
+  for (uint16_t i = 0; i < num_handle; i++) {
+    handles[i] = s_next_handle++;
+  }
+  esp_ble_gatts_cb_param_t param = {
+      .add_attr_tab = {.status = ESP_GATT_OK,
+                       .svc_uuid = *uuid,
+                       .num_handle = num_handle,
+                       .handles = handles},
+  };
+  gatts_event(ESP_GATTS_CREAT_ATTR_TAB_EVT, gatts_if, &param);
+  return base;
+}
+
+// ---- esp_hid_gap ----
+
+esp_err_t esp_hid_gap_init(uint8_t mode) { return ESP_OK; }
+
+esp_err_t esp_hid_ble_gap_adv_init(uint16_t appearance,
+                                   const char *device_name) {
+  return ESP_OK;
+}
+
+void esp_hid_ble_gap_set_event_hook(esp_gap_ble_cb_t hook) {
+  s_gap_hook = hook;
+}
+
+static void adv_started(void *arg) {
+  esp_ble_gap_cb_param_t param = {
+      .adv_start_cmpl = {.status = ESP_BT_STATUS_SUCCESS}};
+  gap_event(ESP_GAP_BLE_ADV_START_COMPLETE_EVT, &param);
+}
+
+esp_err_t esp_hid_ble_gap_adv_start(void) {
+  sim_at(sim_now(), adv_started, NULL);
+  return ESP_OK;
+}
+
+// ---- GAP ----
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t *adv_params) {
+  sim_at(sim_now(), adv_started, NULL);
+  return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_stop_advertising(void) { return ESP_OK; }
+
+static void update_done(void *arg) {
+  if (!s_connected || !s_update_pending) {
+    return;
+  }
+  s_update_pending = false;
+  if (!s_reject_updates) {
+    s_interval = s_update.min_int;
+    s_latency = s_update.latency;
+    s_timeout = s_update.timeout;
+    esp_timer_stop(s_conn_event);
+    esp_timer_start_periodic(s_conn_event, s_interval * 1250);
+  }
+  print_time();
+  printf("params %s interval %u latency %u\n",
+         s_reject_updates ? "rejected" : "accepted", s_interval, s_latency);
+
+  esp_ble_gap_cb_param_t param = {
+      .update_conn_params = {.status = s_reject_updates
+                                           ? ESP_BT_STATUS_UNSUPPORTED
+                                           : ESP_BT_STATUS_SUCCESS,
+                             .min_int = s_update.min_int,
+                             .max_int = s_update.max_int,
+                             .latency = s_latency,
+                             .conn_int = s_interval,
+                             .timeout = s_timeout}};
+  memcpy(param.update_conn_params.bda, s_peer, sizeof(s_peer));
+  gap_event(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, &param);
+}
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params) {
+  if (!s_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  s_update = *params;
+  s_update_pending = true;
+  sim_at(sim_now() + s_interval * 1250, update_done, NULL);
+  return ESP_OK;
+}
+
+static void local_disconnect(void *arg) {
+  if (s_connected) {
+    print_time();
+    printf("disconnected by device\n");
+    sim_link_disconnect(0x16);
+  }
+}
+
+esp_err_t esp_ble_gap_disconnect(esp_bd_addr_t remote_device) {
+  if (!s_connected || memcmp(remote_device, s_peer, sizeof(s_peer)) != 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  sim_at(sim_now(), local_disconnect, NULL);
+  return ESP_OK;
+}
+
+int esp_ble_get_bond_device_num(void) { return s_num_bonds; }
+
+esp_err_t esp_ble_get_bond_device_list(int *dev_num,
+                                       esp_ble_bond_dev_t *dev_list) {
+  int num = *dev_num < s_num_bonds ? *dev_num : s_num_bonds;
+  memcpy(dev_list, s_bonds, num * sizeof(esp_ble_bond_dev_t));
+  *dev_num = num;
+  return ESP_OK;
+}
+
+esp_err_t esp_ble_remove_bond_device(esp_bd_addr_t bd_addr) {
+  for (int i = 0; i < s_num_bonds; i++) {
+    if (memcmp(s_bonds[i].bd_addr, bd_addr, sizeof(esp_bd_addr_t)) == 0) {
+      s_bonds[i] = s_bonds[--s_num_bonds];
+      print_time();
+      printf("bond removed " ESP_BD_ADDR_STR "\n", ESP_BD_ADDR_HEX(bd_addr));
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_bt_dev_set_device_name(const char *name) { return ESP_OK; }
+
+// ---- GATTS ----
+
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback) {
+  s_gatts_cb = callback;
+  return ESP_OK;
+}
+
+static void app_registered(void *arg) {
+  uint16_t app_id = (uint16_t)(uintptr_t)arg;
+  if (s_num_apps == SIM_MAX_APPS) {
+    return;
+  }
+  esp_gatt_if_t gatts_if = 4 + s_num_apps;
+  s_apps[s_num_apps++] = gatts_if;
+  esp_ble_gatts_cb_param_t param = {
+      .reg = {.status = ESP_GATT_OK, .app_id = app_id}};
+  gatts_event(ESP_GATTS_REG_EVT, gatts_if, &param);
+}
+
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id) {
+  sim_at(sim_now(), app_registered, (void *)(uintptr_t)app_id);
+  return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_create_attr_tab(const esp_gatts_attr_db_t *gatts_attr_db,
+                                        esp_gatt_if_t gatts_if,
+                                        uint16_t max_nb_attr,
+                                        uint8_t srvc_inst_id) {
+  // 第一项为服务声明，值即服务 UUID
+  esp_bt_uuid_t uuid = {.len = gatts_attr_db[0].att_desc.length};
+  memcpy(&uuid.uuid, gatts_attr_db[0].att_desc.value, uuid.len);
+  create_table(gatts_if, &uuid, max_nb_attr);
+  return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle) {
+  return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id,
+                                      uint32_t trans_id,
+                                      esp_gatt_status_t status,
+                                      esp_gatt_rsp_t *rsp) {
+  return ESP_OK;
+}
+
+// ---- esp_hidd ----
+
+static void hidd_started(void *arg) {
+  const esp_hid_device_config_t *config = arg;
+  esp_bt_uuid_t battery = {.len = ESP_UUID_LEN_16,
+                           .uuid.uuid16 = ESP_GATT_UUID_BATTERY_SERVICE_SVC};
+  esp_bt_uuid_t hid = {.len = ESP_UUID_LEN_16,
+                       .uuid.uuid16 = ESP_GATT_UUID_HID_SVC};
+
+  s_hidd_if = 3;
+  s_battery_handle = create_table(s_hidd_if, &battery, 4) + 2;
+  for (int i = 0; i < config->report_maps_len && i < SIM_MAX_MAPS; i++) {
+    s_report_base[i] = create_table(s_hidd_if, &hid, SIM_HID_TABLE_LEN);
+  }
+  esp_hidd_event_data_t data = {.start = {.status = ESP_OK}};
+  hidd_event(ESP_HIDD_START_EVENT, &data);
+}
+
+esp_err_t esp_hidd_dev_init(const esp_hid_device_config_t *config,
+                            esp_hid_transport_t transport,
+                            esp_event_handler_t callback,
+                            esp_hidd_dev_t **dev) {
+  s_hidd.callback = callback;
+  s_hidd.transport = transport;
+  *dev = &s_hidd;
+  sim_at(sim_now(), hidd_started, (void *)config);
+  return ESP_OK;
+}
+
+esp_hid_transport_t esp_hidd_dev_transport_get(esp_hidd_dev_t *dev) {
+  return dev->transport;
+}
+
+void esp_hidd_gatts_event_handler(esp_gatts_cb_event_t event,
+                                  esp_gatt_if_t gatts_if,
+                                  esp_ble_gatts_cb_param_t *param) {}
+
+static void send_conf(uint16_t handle, esp_gatt_status_t status) {
+  esp_ble_gatts_cb_param_t param = {
+      .conf = {.status = status, .conn_id = 0, .handle = handle}};
+  gatts_event(ESP_GATTS_CONF_EVT, s_hidd_if, &param);
+}
+
+static void set_congested(bool congested) {
+  if (s_congested == congested) {
+    return;
+  }
+  s_congested = congested;
+  esp_ble_gatts_cb_param_t param = {.congest = {.congested = congested}};
+  gatts_event(ESP_GATTS_CONGEST_EVT, s_hidd_if, &param);
+}
+
+static void congested_conf(void *arg) {
+  send_conf((uint16_t)(uintptr_t)arg, ESP_GATT_CONGESTED);
+}
+
+esp_err_t esp_hidd_dev_input_set(esp_hidd_dev_t *dev, size_t map_index,
+                                 size_t report_id, uint8_t *data,
+                                 size_t length) {
+  if (!s_connected || report_id >= SIM_HID_TABLE_LEN - 1 ||
+      length > SIM_REPORT_MAX) {
+    return ESP_FAIL;
+  }
+  // 句柄只用于区分服务，报告按 ID 放在第一个 HID 服务中
+  uint16_t handle = s_report_base[0] + 1 + report_id;
+  if (s_queue_head - s_queue_tail >= s_buffered) {
+    // 控制器缓冲区已满：通知被丢弃，协议栈报告拥塞和失败的 CONF
+    set_congested(true);
+    sim_at(sim_now(), congested_conf, (void *)(uintptr_t)handle);
+    return ESP_OK;
+  }
+
+  notification_t *n = &s_queue[s_queue_head++ % SIM_QUEUE_LEN];
+  n->sent_us = sim_now();
+  n->handle = handle;
+  n->report_id = report_id;
+  n->len = length;
+  memcpy(n->data, data, length);
+  n->fate = FATE_DELIVER;
+  if (s_fail_count > 0) {
+    s_fail_count--;
+    n->fate = s_fail_fate;
+  }
+  return ESP_OK;
+}
+
+// 一个连接事件：发出缓冲区中最早的几个通知
+static void conn_event_cb(void *arg) {
+  for (uint32_t i = 0; i < s_per_event && s_queue_tail != s_queue_head; i++) {
+    notification_t *n = &s_queue[s_queue_tail++ % SIM_QUEUE_LEN];
+    if (n->fate == FATE_STALL) {
+      continue;
+    }
+    if (n->fate == FATE_DROP) {
+      send_conf(n->handle, ESP_GATT_ERROR);
+      continue;
+    }
+    print_time();
+    printf("rx %u", n->report_id);
+    for (int b = 0; b < n->len; b++) {
+      printf(" %02x", n->data[b]);
+    }
+    printf("  (+%lld)\n", (long long)(sim_now() - n->sent_us));
+    s_received++;
+    send_conf(n->handle, ESP_GATT_OK);
+  }
+  if (s_congested && s_queue_head - s_queue_tail <= s_buffered / 2) {
+    set_congested(false);
+  }
+}
+
+// ---- 脚本控制 ----
+
+void sim_link_connect(const uint8_t *peer, uint16_t interval) {
+  if (s_connected) {
+    return;
+  }
+  if (s_conn_event == NULL) {
+    const esp_timer_create_args_t args = {.callback = conn_event_cb,
+                                          .name = "sim_conn_event"};
+    esp_timer_create(&args, &s_conn_event);
+  }
+  s_connected = true;
+  memcpy(s_peer, peer, sizeof(s_peer));
+  s_interval = interval;
+  s_latency = 0;
+  s_timeout = 400;
+  s_queue_tail = s_queue_head;
+  s_congested = false;
+  s_update_pending = false;
+  esp_timer_start_periodic(s_conn_event, s_interval * 1250);
+
+  print_time();
+  printf("connect " ESP_BD_ADDR_STR " interval %u\n", ESP_BD_ADDR_HEX(peer),
+         interval);
+  esp_ble_gatts_cb_param_t param = {
+      .connect = {.conn_id = 0,
+                  .conn_params = {.interval = s_interval,
+                                  .latency = s_latency,
+                                  .timeout = s_timeout}}};
+  memcpy(param.connect.remote_bda, peer, sizeof(s_peer));
+  gatts_event_all(ESP_GATTS_CONNECT_EVT, &param);
+  esp_hidd_event_data_t data = {.connect = {.status = ESP_OK, .dev = &s_hidd}};
+  hidd_event(ESP_HIDD_CONNECT_EVENT, &data);
+}
+
+void sim_link_encrypt(void) {
+  if (!s_connected) {
+    return;
+  }
+  bool bonded = false;
+  for (int i = 0; i < s_num_bonds; i++) {
+    bonded |= memcmp(s_bonds[i].bd_addr, s_peer, sizeof(s_peer)) == 0;
+  }
+  if (!bonded && s_num_bonds < SIM_MAX_BONDS) {
+    memset(&s_bonds[s_num_bonds], 0, sizeof(s_bonds[0]));
+    memcpy(s_bonds[s_num_bonds].bd_addr, s_peer, sizeof(s_peer));
+    s_num_bonds++;
+  }
+  print_time();
+  printf("encrypted%s\n", bonded ? "" : ", bonded");
+  esp_ble_gap_cb_param_t param = {
+      .ble_security.auth_cmpl = {.success = true,
+                                 .addr_type = BLE_ADDR_TYPE_PUBLIC}};
+  memcpy(param.ble_security.auth_cmpl.bd_addr, s_peer, sizeof(s_peer));
+  gap_event(ESP_GAP_BLE_AUTH_CMPL_EVT, &param);
+}
+
+void sim_link_disconnect(int reason) {
+  if (!s_connected) {
+    return;
+  }
+  s_connected = false;
+  esp_timer_stop(s_conn_event);
+  print_time();
+  printf("disconnect reason 0x%02x\n", reason);
+
+  esp_ble_gatts_cb_param_t param = {
+      .disconnect = {.conn_id = 0, .reason = reason}};
+  memcpy(param.disconnect.remote_bda, s_peer, sizeof(s_peer));
+  gatts_event_all(ESP_GATTS_DISCONNECT_EVT, &param);
+  esp_hidd_event_data_t data = {
+      .disconnect = {.status = ESP_OK, .dev = &s_hidd, .reason = reason}};
+  hidd_event(ESP_HIDD_DISCONNECT_EVENT, &data);
+}
+
+void sim_link_protocol_mode(bool report) {
+  esp_hidd_event_data_t data = {
+      .protocol_mode = {.dev = &s_hidd,
+                        .map_index = 0,
+                        .protocol_mode = report ? ESP_HID_PROTOCOL_MODE_REPORT
+                                                : ESP_HID_PROTOCOL_MODE_BOOT}};
+  hidd_event(ESP_HIDD_PROTOCOL_MODE_EVENT, &data);
+}
+
+void sim_link_set_capacity(uint32_t per_event, uint32_t buffered) {
+  s_per_event = per_event;
+  s_buffered = buffered < SIM_QUEUE_LEN ? buffered : SIM_QUEUE_LEN;
+}
+
+void sim_link_reject_updates(bool reject) { s_reject_updates = reject; }
+
+void sim_link_fail_next(uint32_t count, bool drop) {
+  s_fail_count = count;
+  s_fail_fate = drop ? FATE_DROP : FATE_STALL;
+}
+
+void sim_link_congest(bool congested) { set_congested(congested); }
+
+void sim_link_foreign_conf(void) { send_conf(s_battery_handle, ESP_GATT_OK); }
+
+uint32_t sim_link_received(void) { return s_received; }
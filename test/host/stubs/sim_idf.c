@@ -0,0 +1,245 @@
+// ESP-IDF 系统接口的主机替身：错误名、日志、NVS、睡眠和 CPU 周期计数
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_hid_common.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define NVS_MAX_ENTRIES 32
+#define NVS_MAX_HANDLES 8
+#define NVS_KEY_LEN 16
+#define NVS_MAX_VALUE 512
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:
+      return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+      return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+// ---- 日志 ----
+
+static esp_log_level_t s_log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+  (void)tag;
+  s_log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+                   ...) {
+  static const char letters[] = "NEWIDV";
+  if (level > s_log_level) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%c (%lld) %s: ", letters[level],
+          (long long)esp_timer_get_time() / 1000, tag);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+void esp_log_buffer_hex_internal(const char *tag, const void *buffer,
+                                 uint16_t len, esp_log_level_t level) {
+  if (level > s_log_level) {
+    return;
+  }
+  fprintf(stderr, "%s:", tag);
+  for (uint16_t i = 0; i < len; i++) {
+    fprintf(stderr, " %02x", ((const uint8_t *)buffer)[i]);
+  }
+  fputc('\n', stderr);
+}
+
+// ---- NVS：按命名空间和键保存的内存表 ----
+
+typedef struct {
+  char ns[NVS_KEY_LEN];
+  char key[NVS_KEY_LEN];
+  size_t len;
+  uint8_t value[NVS_MAX_VALUE];
+} nvs_entry_t;
+
+static nvs_entry_t s_entries[NVS_MAX_ENTRIES];
+static size_t s_num_entries = 0;
+static char s_handles[NVS_MAX_HANDLES][NVS_KEY_LEN];  // 空串为未使用
+
+static nvs_entry_t *nvs_find(nvs_handle_t handle, const char *key,
+                             bool create) {
+  if (handle == 0 || handle > NVS_MAX_HANDLES || s_handles[handle - 1][0] == 0) {
+    return NULL;
+  }
+  const char *ns = s_handles[handle - 1];
+  for (size_t i = 0; i < s_num_entries; i++) {
+    if (strcmp(s_entries[i].ns, ns) == 0 && strcmp(s_entries[i].key, key) == 0) {
+      return &s_entries[i];
+    }
+  }
+  if (!create || s_num_entries == NVS_MAX_ENTRIES) {
+    return NULL;
+  }
+  nvs_entry_t *entry = &s_entries[s_num_entries++];
+  snprintf(entry->ns, sizeof(entry->ns), "%s", ns);
+  snprintf(entry->key, sizeof(entry->key), "%s", key);
+  return entry;
+}
+
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+
+esp_err_t nvs_flash_erase(void) {
+  s_num_entries = 0;
+  return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode,
+                   nvs_handle_t *out_handle) {
+  // 与 NVS 相同，只读打开不存在的命名空间时返回 NOT_FOUND
+  if (open_mode == NVS_READONLY) {
+    bool found = false;
+    for (size_t i = 0; i < s_num_entries && !found; i++) {
+      found = strcmp(s_entries[i].ns, name) == 0;
+    }
+    if (!found) {
+      return ESP_ERR_NVS_NOT_FOUND;
+    }
+  }
+  for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+    if (s_handles[i][0] == 0) {
+      snprintf(s_handles[i], sizeof(s_handles[i]), "%s", name);
+      *out_handle = i + 1;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  if (handle > 0 && handle <= NVS_MAX_HANDLES) {
+    s_handles[handle - 1][0] = 0;
+  }
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value,
+                       size_t *length) {
+  nvs_entry_t *entry = nvs_find(handle, key, false);
+  if (entry == NULL) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (out_value == NULL) {
+    *length = entry->len;
+    return ESP_OK;
+  }
+  if (*length < entry->len) {
+    *length = entry->len;
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, entry->value, entry->len);
+  *length = entry->len;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                       size_t length) {
+  if (length > NVS_MAX_VALUE) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  nvs_entry_t *entry = nvs_find(handle, key, true);
+  if (entry == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(entry->value, value, length);
+  entry->len = length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value) {
+  size_t len = 1;
+  return nvs_get_blob(handle, key, out_value, &len);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+  return nvs_set_blob(handle, key, &value, 1);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  nvs_entry_t *entry = nvs_find(handle, key, false);
+  if (entry == NULL) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  *entry = s_entries[--s_num_entries];
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  (void)handle;
+  return ESP_OK;
+}
+
+// ---- 系统 ----
+
+esp_reset_reason_t esp_reset_reason(void) { return ESP_RST_POWERON; }
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void) { return ESP_OK; }
+
+// 便携的周期计数：单调时钟的纳秒数，即 1 GHz 的“CPU”
+uint32_t esp_cpu_get_cycle_count(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void) { return 1000; }
+
+// ---- HID 公共函数 ----
+
+const char *esp_hid_usage_str(esp_hid_usage_t usage) {
+  switch (usage) {
+    case ESP_HID_USAGE_KEYBOARD:
+      return "KEYBOARD";
+    case ESP_HID_USAGE_CCONTROL:
+      return "CCONTROL";
+    default:
+      return "GENERIC";
+  }
+}
+
+const char *esp_hid_disconnect_reason_str(esp_hid_transport_t transport,
+                                          int reason) {
+  (void)transport;
+  (void)reason;
+  return "SIMULATED";
+}
@@ -0,0 +1,59 @@
+// 虚拟按键矩阵：matrix_io.h 的主机实现
+// 按键触点由脚本通过 sim_matrix_set 设置，被拉低的行上闭合的触点把列拉低
+
+#include "button_scan.h"
+#include "matrix_io.h"
+#include "sim.h"
+
+static bool s_closed[ROW_NUM][COL_NUM];
+static uint32_t s_selected = 0;  // 被拉低的行
+static bool s_wake_enabled = false;
+static matrix_io_wake_cb_t s_wake_cb = NULL;
+
+// 与列引脚的低电平中断相同：使能期间有列为低时触发一次后关闭
+static void check_wake(void) {
+  if (s_wake_enabled && matrix_io_read_cols() != 0) {
+    s_wake_enabled = false;
+    if (s_wake_cb) {
+      s_wake_cb();
+    }
+  }
+}
+
+void matrix_io_init(matrix_io_wake_cb_t wake_cb) {
+  s_wake_cb = wake_cb;
+  s_selected = 0;
+  s_wake_enabled = false;
+}
+
+void matrix_io_select_row(uint8_t row) { s_selected |= 1u << row; }
+
+void matrix_io_unselect_row(uint8_t row) { s_selected &= ~(1u << row); }
+
+void matrix_io_select_all_rows(void) { s_selected = (1u << ROW_NUM) - 1; }
+
+void matrix_io_release_rows(void) { s_selected = 0; }
+
+matrix_row_t matrix_io_read_cols(void) {
+  matrix_row_t bits = 0;
+  for (int row = 0; row < ROW_NUM; row++) {
+    if (s_selected & (1u << row)) {
+      for (int col = 0; col < COL_NUM; col++) {
+        bits |= (matrix_row_t)s_closed[row][col] << col;
+      }
+    }
+  }
+  return bits;
+}
+
+void matrix_io_wake_enable(bool enable) {
+  s_wake_enabled = enable;
+  if (enable) {
+    check_wake();
+  }
+}
+
+void sim_matrix_set(uint8_t row, uint8_t col, bool pressed) {
+  s_closed[row][col] = pressed;
+  check_wake();
+}
@@ -0,0 +1,498 @@
+// 虚拟时间调度器：FreeRTOS 任务、通知、信号量和 esp_timer 的主机替身
+// 每个任务有自己的 ucontext 栈，同一时刻只有一个任务运行：
+//   - 任务在阻塞调用处让出，或唤醒了更高优先级的任务时被抢占 (临界区内推迟)
+//   - 所有任务都阻塞时，时间推进到最早的定时器或超时，先执行到期的定时器回调
+//     (相当于最高优先级的 esp_timer 任务)，再唤醒超时的任务
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+// 主机上的栈用量与芯片不同，所有任务使用同样大的栈
+#define SIM_STACK_SIZE (256 * 1024)
+#define SIM_STACK_FILL 0xA5
+#define SIM_MAIN_PRIORITY 1
+#define SIM_TICK_US (1000000 / configTICK_RATE_HZ)
+#define SIM_FOREVER INT64_MAX
+
+typedef enum {
+  TASK_READY,
+  TASK_BLOCKED,
+  TASK_DELETED,
+} task_state_t;
+
+struct sim_task {
+  ucontext_t ctx;
+  uint8_t *stack;
+  TaskFunction_t fn;
+  void *arg;
+  char name[16];
+  UBaseType_t priority;
+  task_state_t state;
+  uint64_t ready_seq;  // 同优先级按就绪顺序运行
+  int64_t wake_us;     // 阻塞超时的时间，SIM_FOREVER 表示不超时
+  uint32_t notify;
+  bool waiting_notify;
+  struct sim_semaphore *waiting_sem;
+  struct sim_task *next;
+};
+
+struct sim_semaphore {
+  uint32_t count;
+  uint32_t max;
+};
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  const char *name;
+  bool active;
+  bool skip_unhandled;
+  bool owned;  // sim_at 创建，执行后释放
+  int64_t expiry_us;
+  uint64_t period_us;
+  uint64_t seq;
+  struct esp_timer *next;
+};
+
+static int64_t s_now = 0;
+static uint64_t s_seq = 0;
+static ucontext_t s_sched_ctx;
+static struct sim_task *s_tasks = NULL;
+static struct sim_task *s_current = NULL;
+static struct esp_timer *s_timers = NULL;  // 运行中的定时器，按到期时间排序
+static int s_critical = 0;
+static bool s_yield_pending = false;
+
+static void fail(const char *what) {
+  fprintf(stderr, "sim: %s (task %s)\n", what,
+          s_current ? s_current->name : "-");
+  abort();
+}
+
+int64_t sim_now(void) { return s_now; }
+
+int64_t esp_timer_get_time(void) { return s_now; }
+
+void esp_rom_delay_us(uint32_t us) { s_now += us; }
+
+// ---- 任务 ----
+
+static void make_ready(struct sim_task *task) {
+  task->state = TASK_READY;
+  task->wake_us = SIM_FOREVER;
+  task->ready_seq = ++s_seq;
+}
+
+// 当前任务让出，回到调度器，再次被选中时返回
+static void suspend(void) {
+  struct sim_task *task = s_current;
+  swapcontext(&task->ctx, &s_sched_ctx);
+}
+
+static void yield(void) {
+  s_current->state = TASK_READY;
+  suspend();
+}
+
+// 被唤醒的任务优先级更高时抢占当前任务
+static void maybe_preempt(const struct sim_task *woken) {
+  if (s_current == NULL || woken->priority <= s_current->priority) {
+    return;
+  }
+  if (s_critical > 0) {
+    s_yield_pending = true;
+  } else {
+    yield();
+  }
+}
+
+// 阻塞到被唤醒或超时，返回 false 表示超时
+static bool block(TickType_t ticks) {
+  if (s_current == NULL) {
+    fail("blocking call outside a task");
+  }
+  if (s_critical > 0) {
+    fail("blocking call inside a critical section");
+  }
+  struct sim_task *task = s_current;
+  task->state = TASK_BLOCKED;
+  // 与 FreeRTOS 相同，超时按节拍计算
+  task->wake_us = ticks == portMAX_DELAY
+                      ? SIM_FOREVER
+                      : (s_now / SIM_TICK_US + ticks) * SIM_TICK_US;
+  int64_t deadline = task->wake_us;
+  suspend();
+  return deadline == SIM_FOREVER || s_now < deadline;
+}
+
+static void task_entry(void) {
+  struct sim_task *task = s_current;
+  task->fn(task->arg);
+  // FreeRTOS 任务不允许返回，这里按删除自身处理
+  vTaskDelete(NULL);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *out_handle) {
+  struct sim_task *task = calloc(1, sizeof(*task));
+  task->stack = malloc(SIM_STACK_SIZE);
+  if (task == NULL || task->stack == NULL) {
+    fail("out of memory");
+  }
+  memset(task->stack, SIM_STACK_FILL, SIM_STACK_SIZE);
+  task->fn = fn;
+  task->arg = arg;
+  snprintf(task->name, sizeof(task->name), "%s", name);
+  task->priority = priority;
+  getcontext(&task->ctx);
+  task->ctx.uc_stack.ss_sp = task->stack;
+  task->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+  task->ctx.uc_link = &s_sched_ctx;
+  makecontext(&task->ctx, task_entry, 0);
+  make_ready(task);
+
+  task->next = s_tasks;
+  s_tasks = task;
+  if (out_handle != NULL) {
+    *out_handle = task;
+  }
+  maybe_preempt(task);
+  return pdPASS;
+}
+
+TaskHandle_t sim_start_main(TaskFunction_t fn) {
+  TaskHandle_t task;
+  xTaskCreate(fn, "main", 3584, NULL, SIM_MAIN_PRIORITY, &task);
+  return task;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == NULL) {
+    task = s_current;
+  }
+  task->state = TASK_DELETED;
+  if (task == s_current) {
+    suspend();
+    fail("deleted task resumed");
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    yield();
+    return;
+  }
+  block(ticks);
+}
+
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(s_now / SIM_TICK_US); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return s_current; }
+
+// 从栈底开始数仍为填充值的字节，与 ESP-IDF 相同以字节为单位
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  if (task == NULL) {
+    task = s_current;
+  }
+  UBaseType_t unused = 0;
+  while (unused < SIM_STACK_SIZE && task->stack[unused] == SIM_STACK_FILL) {
+    unused++;
+  }
+  return unused;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  struct sim_task *task = s_current;
+  if (task == NULL) {
+    fail("ulTaskNotifyTake outside a task");
+  }
+  if (task->notify == 0 && ticks != 0) {
+    task->waiting_notify = true;
+    block(ticks);
+    task->waiting_notify = false;
+  }
+  uint32_t value = task->notify;
+  if (value != 0) {
+    task->notify = clear_on_exit ? 0 : value - 1;
+  }
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  task->notify++;
+  if (task->state == TASK_BLOCKED && task->waiting_notify) {
+    make_ready(task);
+    maybe_preempt(task);
+  }
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+  xTaskNotifyGive(task);
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+}
+
+// ---- 信号量 ----
+
+static SemaphoreHandle_t create_semaphore(uint32_t count, uint32_t max) {
+  SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+  sem->count = count;
+  sem->max = max;
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return create_semaphore(0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return create_semaphore(1, 1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { free(sem); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  while (sem->count == 0) {
+    if (ticks == 0) {
+      return pdFALSE;
+    }
+    s_current->waiting_sem = sem;
+    bool woken = block(ticks);
+    s_current->waiting_sem = NULL;
+    if (!woken && sem->count == 0) {
+      return pdFALSE;
+    }
+  }
+  sem->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  if (sem->count == sem->max) {
+    return pdFALSE;
+  }
+  sem->count++;
+
+  // 唤醒等待该信号量的最高优先级任务
+  struct sim_task *best = NULL;
+  for (struct sim_task *t = s_tasks; t != NULL; t = t->next) {
+    if (t->state == TASK_BLOCKED && t->waiting_sem == sem &&
+        (best == NULL || t->priority > best->priority)) {
+      best = t;
+    }
+  }
+  if (best != NULL) {
+    make_ready(best);
+    maybe_preempt(best);
+  }
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken) {
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return xSemaphoreGive(sem);
+}
+
+// ---- 临界区 ----
+
+void sim_enter_critical(void) { s_critical++; }
+
+void sim_exit_critical(void) {
+  if (--s_critical == 0 && s_yield_pending && s_current != NULL) {
+    s_yield_pending = false;
+    yield();
+  }
+}
+
+// 中断中唤醒的任务已经在 maybe_preempt 中处理
+void sim_yield_from_isr(BaseType_t woken) { (void)woken; }
+
+// ---- 定时器 ----
+
+static void timer_unlink(struct esp_timer *timer) {
+  for (struct esp_timer **p = &s_timers; *p != NULL; p = &(*p)->next) {
+    if (*p == timer) {
+      *p = timer->next;
+      break;
+    }
+  }
+  timer->active = false;
+}
+
+// 按到期时间插入，同时到期的按启动顺序执行
+static void timer_insert(struct esp_timer *timer, int64_t expiry_us) {
+  timer->expiry_us = expiry_us;
+  timer->seq = ++s_seq;
+  timer->active = true;
+  struct esp_timer **p = &s_timers;
+  while (*p != NULL && (*p)->expiry_us <= expiry_us) {
+    p = &(*p)->next;
+  }
+  timer->next = *p;
+  *p = timer;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+                           esp_timer_handle_t *out_handle) {
+  struct esp_timer *timer = calloc(1, sizeof(*timer));
+  if (timer == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->name = args->name;
+  timer->skip_unhandled = args->skip_unhandled_events;
+  *out_handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->period_us = 0;
+  timer_insert(timer, s_now + (int64_t)timeout_us);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer,
+                                   uint64_t period_us) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->period_us = period_us;
+  timer_insert(timer, s_now + (int64_t)period_us);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer_unlink(timer);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  free(timer);
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) { return timer->active; }
+
+void sim_at(int64_t at_us, sim_event_fn_t fn, void *arg) {
+  struct esp_timer *timer = calloc(1, sizeof(*timer));
+  timer->callback = fn;
+  timer->arg = arg;
+  timer->name = "sim";
+  timer->owned = true;
+  timer_insert(timer, at_us > s_now ? at_us : s_now);
+}
+
+// 执行一个到期的定时器，周期定时器先重新排入再执行回调
+static void timer_fire(struct esp_timer *timer) {
+  timer_unlink(timer);
+  if (timer->period_us != 0) {
+    int64_t next = timer->expiry_us + (int64_t)timer->period_us;
+    if (timer->skip_unhandled && next <= s_now) {
+      next = s_now + (int64_t)timer->period_us;
+    }
+    timer_insert(timer, next);
+  }
+  timer->callback(timer->arg);
+  if (timer->owned) {
+    free(timer);
+  }
+}
+
+// ---- 调度 ----
+
+static struct sim_task *pick_ready(void) {
+  struct sim_task *best = NULL;
+  for (struct sim_task *t = s_tasks; t != NULL; t = t->next) {
+    if (t->state == TASK_READY &&
+        (best == NULL || t->priority > best->priority ||
+         (t->priority == best->priority && t->ready_seq < best->ready_seq))) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+static void reap_deleted(void) {
+  for (struct sim_task **p = &s_tasks; *p != NULL;) {
+    struct sim_task *task = *p;
+    if (task->state == TASK_DELETED && task != s_current) {
+      *p = task->next;
+      free(task->stack);
+      free(task);
+    } else {
+      p = &task->next;
+    }
+  }
+}
+
+static int64_t next_wake(void) {
+  int64_t next = s_timers != NULL ? s_timers->expiry_us : SIM_FOREVER;
+  for (struct sim_task *t = s_tasks; t != NULL; t = t->next) {
+    if (t->state == TASK_BLOCKED && t->wake_us < next) {
+      next = t->wake_us;
+    }
+  }
+  return next;
+}
+
+void sim_run_until(int64_t until_us) {
+  if (s_current != NULL) {
+    fail("sim_run_until called from a task");
+  }
+  for (;;) {
+    struct sim_task *task = pick_ready();
+    if (task != NULL) {
+      s_current = task;
+      swapcontext(&s_sched_ctx, &task->ctx);
+      s_current = NULL;
+      s_critical = 0;
+      s_yield_pending = false;
+      reap_deleted();
+      continue;
+    }
+
+    int64_t next = next_wake();
+    if (next > until_us) {
+      if (s_now < until_us) {
+        s_now = until_us;
+      }
+      return;
+    }
+    if (next > s_now) {
+      s_now = next;
+    }
+    while (s_timers != NULL && s_timers->expiry_us <= s_now) {
+      timer_fire(s_timers);
+    }
+    for (struct sim_task *t = s_tasks; t != NULL; t = t->next) {
+      if (t->state == TASK_BLOCKED && t->wake_us <= s_now) {
+        make_ready(t);
+      }
+    }
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// 主机测试的最小断言：失败时输出位置并计数，main 返回 CHECK_RESULT()
+static int s_check_failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+              #cond);                                                 \
+      s_check_failures++;                                             \
+    }                                                                 \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                    \
+  do {                                                                    \
+    long long check_a_ = (long long)(a), check_b_ = (long long)(b);       \
+    if (check_a_ != check_b_) {                                           \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",   \
+              __FILE__, __LINE__, #a, #b, check_a_, check_b_);            \
+      s_check_failures++;                                                 \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_RESULT()                                        \
+  (s_check_failures == 0                                      \
+       ? (printf("all checks passed\n"), 0)                   \
+       : (fprintf(stderr, "%d checks failed\n", s_check_failures), 1))
+
+#endif /* CHECK_H */
@@ -0,0 +1,228 @@
+#ifndef GOLDEN_REPORT_MAPS_H
+#define GOLDEN_REPORT_MAPS_H
+
+// 报告描述符生成之前 main.c 中手写的描述符 (ce0f311)，原样保留作为基准：
+// hid_report_maps.hid 生成的描述符必须与之逐字节相同。
+// 有意修改线上描述符时同时更新这里，并确认已配对的主机需要重新配对
+
+#include "hid_report.h"
+
+static const unsigned char golden_keyboard_report_map[] = {
+    0x05, 0x01,  // Usage Page (Generic Desktop)
+    0x09, 0x06,  // Usage (Keyboard)
+    0xA1, 0x01,  // Collection (Application)
+    0x85, 0x01,  //   Report ID (1)
+
+    // 修饰键 (左Ctrl, 左Shift等)
+    0x05, 0x07,  //   Usage Page (Key Codes)
+    0x19, 0xE0,  //   Usage Minimum (Left Control)
+    0x29, 0xE7,  //   Usage Maximum (Right GUI)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x01,  //   Logical Maximum (1)
+    0x75, 0x01,  //   Report Size (1)
+    0x95, 0x08,  //   Report Count (8)
+    0x81, 0x02,  //   Input (Data, Variable, Absolute)
+
+    // 保留字节
+    0x95, 0x01,  //   Report Count (1)
+    0x75, 0x08,  //   Report Size (8)
+    0x81, 0x01,  //   Input (Constant)
+
+    // LED状态 (Num Lock, Caps Lock等)
+    0x95, 0x05,  //   Report Count (5)
+    0x75, 0x01,  //   Report Size (1)
+    0x05, 0x08,  //   Usage Page (LEDs)
+    0x19, 0x01,  //   Usage Minimum (Num Lock)
+    0x29, 0x05,  //   Usage Maximum (Kana)
+    0x91, 0x02,  //   Output (Data, Variable, Absolute)
+
+    // LED状态的保留3位
+    0x95, 0x01,  //   Report Count (1)
+    0x75, 0x03,  //   Report Size (3)
+    0x91, 0x01,  //   Output (Constant)
+
+    // 6个按键
+    0x95, 0x06,  //   Report Count (6)
+    0x75, 0x08,  //   Report Size (8)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x65,  //   Logical Maximum (101)
+    0x05, 0x07,  //   Usage Page (Key Codes)
+    0x19, 0x00,  //   Usage Minimum (0)
+    0x29, 0x65,  //   Usage Maximum (101)
+    0x81, 0x00,  //   Input (Data, Array)
+
+    0xC0,  // End Collection
+
+#if HID_REPORT_NKRO_ENABLED
+    // NKRO 键盘：用途码 0x00 ~ 0xE7 每个一位，包含修饰键，共 29 字节
+    0x05, 0x01,  // Usage Page (Generic Desktop)
+    0x09, 0x06,  // Usage (Keyboard)
+    0xA1, 0x01,  // Collection (Application)
+    0x85, 0x02,  //   Report ID (2)
+    0x05, 0x07,  //   Usage Page (Key Codes)
+    0x19, 0x00,  //   Usage Minimum (0)
+    0x29, 0xE7,  //   Usage Maximum (Right GUI)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x01,  //   Logical Maximum (1)
+    0x75, 0x01,  //   Report Size (1)
+    0x95, 0xE8,  //   Report Count (232)
+    0x81, 0x02,  //   Input (Data, Variable, Absolute)
+    0xC0,        // End Collection
+#endif
+};
+
+static const unsigned char golden_media_report_map[] = {
+    0x05,
+    0x0C,  // Usage Page (Consumer)
+    0x09,
+    0x01,  // Usage (Consumer Control)
+    0xA1,
+    0x01,  // Collection (Application)
+    0x85,
+    0x03,  //   Report ID (3)
+    0x09,
+    0x02,  //   Usage (Numeric Key Pad)
+    0xA1,
+    0x02,  //   Collection (Logical)
+    0x05,
+    0x09,  //     Usage Page (Button)
+    0x19,
+    0x01,  //     Usage Minimum (0x01)
+    0x29,
+    0x0A,  //     Usage Maximum (0x0A)
+    0x15,
+    0x01,  //     Logical Minimum (1)
+    0x25,
+    0x0A,  //     Logical Maximum (10)
+    0x75,
+    0x04,  //     Report Size (4)
+    0x95,
+    0x01,  //     Report Count (1)
+    0x81,
+    0x00,  //     Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
+           //     Position)
+    0xC0,  //   End Collection
+    0x05,
+    0x0C,  //   Usage Page (Consumer)
+    0x09,
+    0x86,  //   Usage (Channel)
+    0x15,
+    0xFF,  //   Logical Minimum (-1)
+    0x25,
+    0x01,  //   Logical Maximum (1)
+    0x75,
+    0x02,  //   Report Size (2)
+    0x95,
+    0x01,  //   Report Count (1)
+    0x81,
+    0x46,  //   Input (Data,Var,Rel,No Wrap,Linear,Preferred State,Null State)
+    0x09,
+    0xE9,  //   Usage (Volume Increment)
+    0x09,
+    0xEA,  //   Usage (Volume Decrement)
+    0x15,
+    0x00,  //   Logical Minimum (0)
+    0x75,
+    0x01,  //   Report Size (1)
+    0x95,
+    0x02,  //   Report Count (2)
+    0x81,
+    0x02,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null
+           //   Position)
+    // 媒体按键：当时由 consumer_report.h 的 HID_CC_BUTTON_USAGES 展开
+    0x09,
+    0xE2,  //   Usage (Mute)
+    0x09,
+    0x30,  //   Usage (Power)
+    0x09,
+    0x83,  //   Usage (Recall Last)
+    0x09,
+    0x81,  //   Usage (Assign Selection)
+    0x09,
+    0xB0,  //   Usage (Play)
+    0x09,
+    0xB1,  //   Usage (Pause)
+    0x09,
+    0xB2,  //   Usage (Record)
+    0x09,
+    0xB3,  //   Usage (Fast Forward)
+    0x09,
+    0xB4,  //   Usage (Rewind)
+    0x09,
+    0xB5,  //   Usage (Scan Next Track)
+    0x09,
+    0xB6,  //   Usage (Scan Previous Track)
+    0x09,
+    0xB7,  //   Usage (Stop)
+    0x15,
+    0x01,  //   Logical Minimum (1)
+    0x25,
+    0x0C,  //   Logical Maximum (12)
+    0x75,
+    0x04,  //   Report Size (4)
+    0x95,
+    0x01,  //   Report Count (1)
+    0x81,
+    0x00,  //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
+           //   Position)
+    0x09,
+    0x80,  //   Usage (Selection)
+    0xA1,
+    0x02,  //   Collection (Logical)
+    0x05,
+    0x09,  //     Usage Page (Button)
+    0x19,
+    0x01,  //     Usage Minimum (0x01)
+    0x29,
+    0x03,  //     Usage Maximum (0x03)
+    0x15,
+    0x01,  //     Logical Minimum (1)
+    0x25,
+    0x03,  //     Logical Maximum (3)
+    0x75,
+    0x02,  //     Report Size (2)
+    0x81,
+    0x00,  //     Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null
+           //     Position)
+    0xC0,  //   End Collection
+    0x81,
+    0x03,  //   Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null
+           //   Position)
+    0xC0,  // End Collection
+};
+
+static const unsigned char golden_mouse_report_map[] = {
+    0x05, 0x01,  // USAGE_PAGE (Generic Desktop)
+    0x09, 0x02,  // USAGE (Mouse)
+    0xa1, 0x01,  // COLLECTION (Application)
+
+    0x09, 0x01,  //   USAGE (Pointer)
+    0xa1, 0x00,  //   COLLECTION (Physical)
+
+    0x05, 0x09,  //     USAGE_PAGE (Button)
+    0x19, 0x01,  //     USAGE_MINIMUM (Button 1)
+    0x29, 0x03,  //     USAGE_MAXIMUM (Button 3)
+    0x15, 0x00,  //     LOGICAL_MINIMUM (0)
+    0x25, 0x01,  //     LOGICAL_MAXIMUM (1)
+    0x95, 0x03,  //     REPORT_COUNT (3)
+    0x75, 0x01,  //     REPORT_SIZE (1)
+    0x81, 0x02,  //     INPUT (Data,Var,Abs)
+    0x95, 0x01,  //     REPORT_COUNT (1)
+    0x75, 0x05,  //     REPORT_SIZE (5)
+    0x81, 0x03,  //     INPUT (Cnst,Var,Abs)
+
+    0x05, 0x01,  //     USAGE_PAGE (Generic Desktop)
+    0x09, 0x30,  //     USAGE (X)
+    0x09, 0x31,  //     USAGE (Y)
+    0x09, 0x38,  //     USAGE (Wheel)
+    0x15, 0x81,  //     LOGICAL_MINIMUM (-127)
+    0x25, 0x7f,  //     LOGICAL_MAXIMUM (127)
+    0x75, 0x08,  //     REPORT_SIZE (8)
+    0x95, 0x03,  //     REPORT_COUNT (3)
+    0x81, 0x06,  //     INPUT (Data,Var,Rel)
+
+    0xc0,  //   END_COLLECTION
+    0xc0   // END_COLLECTION
+};
+
+#endif /* GOLDEN_REPORT_MAPS_H */
@@ -0,0 +1,157 @@
+#ifndef HID_DESC_H
+#define HID_DESC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 测试用的 HID 报告描述符解析：独立于 tools/hid_desc_compile.py，
+// 从描述符字节重新计算每个 Input 字段的位置、取值范围和用途
+
+#define HID_DESC_MAX_FIELDS 32
+#define HID_DESC_MAX_USAGES 32
+
+#define HID_DESC_FLAG_CONST 0x01
+#define HID_DESC_FLAG_VAR 0x02
+#define HID_DESC_FLAG_REL 0x04
+
+typedef struct {
+  uint8_t report_id;
+  uint16_t offset;  // 报告内的位偏移，不含报告 ID
+  uint8_t size;
+  uint8_t count;
+  uint8_t flags;
+  int32_t logical_min;
+  int32_t logical_max;
+  uint16_t usage_page;
+  uint16_t usages[HID_DESC_MAX_USAGES];  // Usage 条目，或由最小/最大值展开
+  uint8_t num_usages;
+} hid_desc_field_t;
+
+typedef struct {
+  hid_desc_field_t fields[HID_DESC_MAX_FIELDS];
+  uint8_t num_fields;
+  uint16_t input_bits[256];  // 每个报告 ID 的 Input 位数
+  bool error;
+} hid_desc_t;
+
+static int32_t hid_desc_signed(uint32_t value, uint8_t len) {
+  if (len == 1) {
+    return (int8_t)value;
+  }
+  if (len == 2) {
+    return (int16_t)value;
+  }
+  return (int32_t)value;
+}
+
+// 解析描述符，只记录 Input 字段
+static void hid_desc_parse(const uint8_t *desc, size_t len, hid_desc_t *out) {
+  uint16_t usage_page = 0;
+  int32_t logical_min = 0, logical_max = 0;
+  uint8_t report_size = 0, report_count = 0, report_id = 0;
+  uint16_t usages[HID_DESC_MAX_USAGES];
+  uint8_t num_usages = 0;
+  uint32_t usage_min = 0;
+  bool has_min = false;
+
+  *out = (hid_desc_t){0};
+  size_t i = 0;
+  while (i < len) {
+    uint8_t prefix = desc[i++];
+    uint8_t size = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+    if (i + size > len) {
+      out->error = true;
+      return;
+    }
+    uint32_t value = 0;
+    for (uint8_t b = 0; b < size; b++) {
+      value |= (uint32_t)desc[i + b] << (8 * b);
+    }
+    i += size;
+
+    switch (prefix & 0xFC) {
+      case 0x04:  // Usage Page
+        usage_page = value;
+        break;
+      case 0x14:  // Logical Minimum
+        logical_min = hid_desc_signed(value, size);
+        break;
+      case 0x24:  // Logical Maximum
+        logical_max = hid_desc_signed(value, size);
+        break;
+      case 0x74:  // Report Size
+        report_size = value;
+        break;
+      case 0x84:  // Report ID
+        report_id = value;
+        break;
+      case 0x94:  // Report Count
+        report_count = value;
+        break;
+      case 0x08:  // Usage
+        if (num_usages < HID_DESC_MAX_USAGES) {
+          usages[num_usages++] = value;
+        }
+        break;
+      case 0x18:  // Usage Minimum
+        usage_min = value;
+        has_min = true;
+        break;
+      case 0x28:  // Usage Maximum
+        for (uint32_t u = has_min ? usage_min : value;
+             u <= value && num_usages < HID_DESC_MAX_USAGES; u++) {
+          usages[num_usages++] = u;
+        }
+        break;
+      case 0x80: {  // Input
+        if (out->num_fields == HID_DESC_MAX_FIELDS) {
+          out->error = true;
+          return;
+        }
+        hid_desc_field_t *f = &out->fields[out->num_fields++];
+        *f = (hid_desc_field_t){.report_id = report_id,
+                                .offset = out->input_bits[report_id],
+                                .size = report_size,
+                                .count = report_count,
+                                .flags = value,
+                                .logical_min = logical_min,
+                                .logical_max = logical_max,
+                                .usage_page = usage_page,
+                                .num_usages = num_usages};
+        for (uint8_t u = 0; u < num_usages; u++) {
+          f->usages[u] = usages[u];
+        }
+        out->input_bits[report_id] += report_size * report_count;
+        num_usages = 0;
+        has_min = false;
+        break;
+      }
+      case 0x90:  // Output
+      case 0xB0:  // Feature
+      case 0xA0:  // Collection
+      case 0xC0:  // End Collection
+        num_usages = 0;
+        has_min = false;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// 从报告中读出一个字段元素，signed 时按位宽做符号扩展
+static int32_t hid_desc_read(const uint8_t *report, uint16_t offset,
+                             uint8_t size, bool is_signed) {
+  uint32_t value = 0;
+  for (uint8_t b = 0; b < size; b++) {
+    uint16_t bit = offset + b;
+    value |= (uint32_t)((report[bit / 8] >> (bit % 8)) & 1) << b;
+  }
+  if (is_signed && size < 32 && (value & (1u << (size - 1)))) {
+    value |= ~0u << size;
+  }
+  return (int32_t)value;
+}
+
+#endif /* HID_DESC_H */
@@ -0,0 +1,253 @@
+// 广播数据解析：截断、长度为 0、超出范围和重复的字段，解析不越界，
+// ad_pick 的完整/不完整优先级，以及随机数据的模糊测试
+//
+// 用法：test_ad_parser [种子]，失败时输出出错的种子，用它单独重现
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ad_parser.h"
+#include "check.h"
+
+#define NUM_VIEWS (sizeof(ad_fields_t) / sizeof(ad_view_t))
+
+#define FUZZ_ROUNDS 100000
+#define FUZZ_MAX_LEN 62  // 扩展广播之外 AD + 扫描响应的最大长度
+
+static bool view_is(ad_view_t view, const char *text) {
+  size_t len = strlen(text);
+  return view.data != NULL && view.len == len &&
+         memcmp(view.data, text, len) == 0;
+}
+
+static bool view_empty(ad_view_t view) {
+  return view.data == NULL && view.len == 0;
+}
+
+// 所有字段都指向 [data, data + len) 之内
+static bool views_in_bounds(const ad_fields_t *fields, const uint8_t *data,
+                            size_t len) {
+  const ad_view_t *views = (const ad_view_t *)fields;
+  for (size_t i = 0; i < NUM_VIEWS; i++) {
+    if (views[i].data == NULL) {
+      continue;
+    }
+    if (views[i].data < data || views[i].data + views[i].len > data + len) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_typical(void) {
+  // Flags、外观 (键盘)、HID 服务 UUID、完整名字
+  static const uint8_t adv[] = {0x02, 0x01, 0x06, 0x03, 0x19, 0xC1, 0x03,
+                                0x03, 0x03, 0x12, 0x18, 0x04, 0x09, 'k',
+                                'b',  'd'};
+  ad_fields_t f;
+  CHECK(ad_parse(adv, sizeof(adv), &f));
+  CHECK_EQ(ad_u16(f.appearance), 0x03C1);
+  CHECK_EQ(ad_u16(f.uuid16_cmpl), 0x1812);
+  CHECK(view_is(f.name_cmpl, "kbd"));
+  CHECK(view_empty(f.name_short));
+  CHECK(view_empty(f.uuid16_incmpl));
+  CHECK(view_empty(f.uuid128_cmpl));
+
+  // 空数据
+  CHECK(ad_parse(adv, 0, &f));
+  CHECK(view_empty(f.appearance));
+  CHECK(view_empty(f.name_cmpl));
+}
+
+static void test_zero_length_ends(void) {
+  // 长度为 0 的结构表示结束，之后的字节是填充，不再解析
+  static const uint8_t adv[] = {0x02, 0x09, 'a', 0x00, 0x02, 0x08, 'b', 0xFF};
+  ad_fields_t f;
+  CHECK(ad_parse(adv, sizeof(adv), &f));
+  CHECK(view_is(f.name_cmpl, "a"));
+  CHECK(view_empty(f.name_short));
+
+  // 只有类型没有数据的字段：出现但长度为 0
+  static const uint8_t type_only[] = {0x01, 0x09, 0x02, 0x08, 'b'};
+  CHECK(ad_parse(type_only, sizeof(type_only), &f));
+  CHECK(f.name_cmpl.data != NULL && f.name_cmpl.len == 0);
+  CHECK(view_is(f.name_short, "b"));
+}
+
+static void test_truncated(void) {
+  // 最后一个结构超出数据范围：返回 false，之前的字段仍然有效
+  static const uint8_t adv[] = {0x03, 0x19, 0xC1, 0x03, 0x05, 0x09, 'a', 'b'};
+  ad_fields_t f;
+  CHECK(!ad_parse(adv, sizeof(adv), &f));
+  CHECK_EQ(ad_u16(f.appearance), 0x03C1);
+  CHECK(view_empty(f.name_cmpl));
+
+  // 只剩长度字节，类型字节不在范围内
+  CHECK(!ad_parse(adv, 5, &f));
+  CHECK_EQ(ad_u16(f.appearance), 0x03C1);
+
+  // 长度到数据末尾为止时完整
+  CHECK(ad_parse(adv, 4, &f));
+}
+
+static void test_over_long(void) {
+  // 长度字段远大于剩余数据
+  static const uint8_t adv[] = {0xFF, 0x09, 'a', 'b', 'c'};
+  ad_fields_t f;
+  CHECK(!ad_parse(adv, sizeof(adv), &f));
+  CHECK(view_empty(f.name_cmpl));
+
+  // 过短的外观字段：出现但无法取值
+  static const uint8_t short_appearance[] = {0x02, 0x19, 0xC1};
+  CHECK(ad_parse(short_appearance, sizeof(short_appearance), &f));
+  CHECK_EQ(f.appearance.len, 1);
+  CHECK_EQ(ad_u16(f.appearance), 0);
+}
+
+static void test_repeated(void) {
+  // 每种类型只取第一次出现的字段，未知类型跳过
+  static const uint8_t adv[] = {0x02, 0x09, 'a', 0x03, 0xFF, 0x00, 0x00,
+                                0x02, 0x09, 'b', 0x03, 0x03, 0x12, 0x18,
+                                0x03, 0x03, 0x0F, 0x18};
+  ad_fields_t f;
+  CHECK(ad_parse(adv, sizeof(adv), &f));
+  CHECK(view_is(f.name_cmpl, "a"));
+  CHECK_EQ(ad_u16(f.uuid16_cmpl), 0x1812);
+
+  // 再次解析时清空上一次的结果
+  CHECK(ad_parse(adv, 0, &f));
+  CHECK(view_empty(f.name_cmpl));
+}
+
+static void test_bounds(void) {
+  // 同一段数据的每个前缀：字段只能指向前缀之内
+  static const uint8_t adv[] = {
+      0x02, 0x01, 0x06, 0x03, 0x19, 0xC1, 0x03, 0x05, 0x02, 0x12, 0x18,
+      0x0F, 0x18, 0x11, 0x07, 1,    2,    3,    4,    5,    6,    7,
+      8,    9,    10,   11,   12,   13,   14,   15,   16,   0x04, 0x08,
+      'k',  'b',  'd',  0x01, 0x09};
+  ad_fields_t f;
+  for (size_t len = 0; len <= sizeof(adv); len++) {
+    bool ok = ad_parse(adv, len, &f);
+    CHECK(views_in_bounds(&f, adv, len));
+    // 结构边界上的前缀完整，其他前缀截断
+    bool boundary = len == 0 || len == 3 || len == 7 || len == 13 ||
+                    len == 31 || len == 36 || len == 38;
+    CHECK_EQ(ok, boundary);
+  }
+  CHECK(ad_parse(adv, sizeof(adv), &f));
+  CHECK_EQ(f.uuid16_incmpl.len, 4);
+  CHECK_EQ(f.uuid128_cmpl.len, 16);
+  CHECK(view_is(f.name_short, "kbd"));
+}
+
+// xorshift32，种子不能为 0
+static uint32_t next_random(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+// 参考实现：只按长度字节走一遍，判断数据是否完整
+static bool reference_walk(const uint8_t *data, size_t len) {
+  size_t pos = 0;
+  while (pos < len && data[pos] != 0) {
+    if (pos + 1 + data[pos] > len) {
+      return false;
+    }
+    pos += 1 + data[pos];
+  }
+  return true;
+}
+
+// 一个随机缓冲区：长度、类型和数据都随机，长度字节偏向小值以产生多个结构
+static size_t random_buffer(uint32_t *state, uint8_t *buf) {
+  size_t len = next_random(state) % (FUZZ_MAX_LEN + 1);
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = next_random(state);
+  }
+  for (size_t pos = 0; pos < len;) {
+    uint32_t r = next_random(state);
+    buf[pos] = (r & 3) == 0 ? (uint8_t)(r >> 8) : (r >> 8) % 8;
+    if (pos + 1 < len && (r & 0x10000)) {
+      // 一半的结构使用解析器关心的类型
+      buf[pos + 1] = AD_TYPE_UUID16_INCMPL + (r >> 17) % 8;
+      if ((r >> 20) & 1) {
+        buf[pos + 1] = AD_TYPE_APPEARANCE;
+      }
+    }
+    pos += 1 + buf[pos];
+  }
+  return len;
+}
+
+static void test_fuzz(uint32_t seed) {
+  // 数据放在缓冲区末尾，用 -fsanitize=address 构建时越界读取会被发现
+  uint8_t storage[FUZZ_MAX_LEN];
+  uint32_t complete = 0;
+  uint32_t truncated = 0;
+  for (uint32_t round = 0; round < FUZZ_ROUNDS; round++) {
+    uint32_t round_seed = seed + round;
+    // 相邻的种子先打散，xorshift 的前几个输出与种子高度相关
+    uint32_t state = (round_seed * 0x9E3779B9u) | 1;
+    next_random(&state);
+    uint8_t buf[FUZZ_MAX_LEN];
+    size_t len = random_buffer(&state, buf);
+    uint8_t *data = storage + sizeof(storage) - len;
+    memcpy(data, buf, len);
+
+    ad_fields_t f;
+    int failures = s_check_failures;
+    bool ok = ad_parse(data, len, &f);
+    CHECK_EQ(ok, reference_walk(data, len));
+    CHECK(views_in_bounds(&f, data, len));
+    CHECK(memcmp(data, buf, len) == 0);  // 解析不修改数据
+    if (s_check_failures != failures) {
+      fprintf(stderr, "fuzz failed with seed %u\n", round_seed);
+      return;
+    }
+    if (ok) {
+      complete++;
+    } else {
+      truncated++;
+    }
+  }
+  // 随机数据要同时覆盖完整和截断两种情况
+  CHECK(complete > FUZZ_ROUNDS / 10);
+  CHECK(truncated > FUZZ_ROUNDS / 10);
+}
+
+static void test_pick(void) {
+  static const uint8_t adv[] = {0x04, 0x08, 'k', 'b', 'd', 0x06, 0x09,
+                                'k',  'e',  'y', 'b', 'd', 0x03, 0x02,
+                                0x12, 0x18};
+  ad_fields_t f;
+  CHECK(ad_parse(adv, sizeof(adv), &f));
+  // 完整名字优先于短名字
+  CHECK(view_is(ad_pick(f.name_cmpl, f.name_short), "keybd"));
+  // 没有完整列表时取不完整列表
+  CHECK_EQ(ad_u16(ad_pick(f.uuid16_cmpl, f.uuid16_incmpl)), 0x1812);
+  // 两者都没有
+  CHECK(view_empty(ad_pick(f.uuid32_cmpl, f.uuid32_incmpl)));
+
+  // 出现但为空的完整名字仍然优先
+  static const uint8_t empty_cmpl[] = {0x01, 0x09, 0x02, 0x08, 'k'};
+  CHECK(ad_parse(empty_cmpl, sizeof(empty_cmpl), &f));
+  ad_view_t name = ad_pick(f.name_cmpl, f.name_short);
+  CHECK(name.data != NULL && name.len == 0);
+}
+
+int main(int argc, char **argv) {
+  uint32_t seed = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+  test_typical();
+  test_zero_length_ends();
+  test_truncated();
+  test_over_long();
+  test_repeated();
+  test_bounds();
+  test_pick();
+  test_fuzz(seed);
+  return CHECK_RESULT();
+}
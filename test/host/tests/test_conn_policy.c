@@ -0,0 +1,165 @@
+// 连接参数策略：连接、空闲切换到慢速、慢速时的按键活动、请求被拒绝后放宽和退避、断开
+
+#include "check.h"
+#include "conn_policy.h"
+
+#define IDLE_US (5 * 1000 * 1000LL)
+#define MS 1000LL
+
+static void check_params(const conn_params_t *r, uint16_t min_int,
+                         uint16_t max_int, uint16_t latency) {
+  CHECK_EQ(r->min_int, min_int);
+  CHECK_EQ(r->max_int, max_int);
+  CHECK_EQ(r->latency, latency);
+}
+
+// 主机接受请求，按请求的最小间隔设置
+static bool accept(conn_policy_t *p, int64_t now, const conn_params_t *r,
+                   conn_params_t *next) {
+  return conn_policy_updated(p, now, true, r->min_int, r->latency, r->timeout,
+                             next);
+}
+
+static void test_connect_idle_activity(void) {
+  conn_policy_t p;
+  conn_params_t r;
+  conn_policy_init(&p, IDLE_US);
+
+  // 主机以 30ms 间隔连接：立即请求快速参数
+  CHECK(conn_policy_connected(&p, 0, 24, 0, 400, &r));
+  check_params(&r, 6, 6, 0);
+  CHECK(p.pending);
+  // 请求未完成时不再发出请求
+  CHECK(!conn_policy_activity(&p, 10 * MS, &r));
+  CHECK(!conn_policy_poll(&p, 20 * MS, &r));
+  CHECK(!accept(&p, 40 * MS, &(conn_params_t){6, 6, 0, 400}, &r));
+  CHECK_EQ(p.settled, CONN_POLICY_FAST);
+  CHECK_EQ(p.interval, 6);
+  CHECK_EQ(p.accepted.min_int, 6);
+
+  // 空闲超时之前不需要轮询之外的动作，截止时间为最后一次活动加空闲时间
+  CHECK_EQ(conn_policy_next_deadline(&p, 1000 * MS), 10 * MS + IDLE_US);
+  CHECK(!conn_policy_poll(&p, 10 * MS + IDLE_US - 1, &r));
+
+  // 空闲超时：切换到慢速参数
+  CHECK(conn_policy_poll(&p, 10 * MS + IDLE_US, &r));
+  check_params(&r, 48, 64, 24);
+  CHECK(!accept(&p, 6000 * MS, &r, &r));
+  CHECK_EQ(p.settled, CONN_POLICY_SLOW);
+  CHECK_EQ(p.latency, 24);
+  // 慢速时只有按键活动改变期望的模式
+  CHECK_EQ(conn_policy_next_deadline(&p, 7000 * MS), 0);
+  CHECK(!conn_policy_poll(&p, 60000 * MS, &r));
+
+  // 慢速时按键：立即请求快速参数，之后的按键不重复请求
+  CHECK(conn_policy_activity(&p, 61000 * MS, &r));
+  check_params(&r, 6, 6, 0);
+  CHECK(!conn_policy_activity(&p, 61005 * MS, &r));
+  CHECK(!accept(&p, 61100 * MS, &r, &r));
+  CHECK_EQ(p.settled, CONN_POLICY_FAST);
+
+  // 断开后不再请求，也没有截止时间
+  conn_policy_disconnected(&p);
+  CHECK(!p.connected);
+  CHECK(!conn_policy_activity(&p, 62000 * MS, &r));
+  CHECK(!conn_policy_poll(&p, 70000 * MS, &r));
+  CHECK_EQ(conn_policy_next_deadline(&p, 70000 * MS), 0);
+  CHECK(!conn_policy_updated(&p, 70000 * MS, true, 6, 0, 400, &r));
+}
+
+// 快速参数被拒绝：放宽一次，再被拒绝后按指数退避重试
+static void test_rejected_update(void) {
+  conn_policy_t p;
+  conn_params_t r;
+  // 空闲时间长于退避时间，重试期间期望的模式保持快速
+  conn_policy_init(&p, 60 * IDLE_US);
+
+  CHECK(conn_policy_connected(&p, 0, 24, 0, 400, &r));
+  check_params(&r, 6, 6, 0);
+
+  // 被拒绝后立即以放宽的参数重试
+  CHECK(conn_policy_updated(&p, 50 * MS, false, 24, 0, 400, &r));
+  check_params(&r, 6, 12, 0);
+  CHECK(p.relaxed);
+  CHECK_EQ(p.rejects, 1);
+
+  // 放宽的参数也被拒绝：等待最小退避时间
+  CHECK(!conn_policy_updated(&p, 100 * MS, false, 24, 0, 400, &r));
+  CHECK_EQ(p.rejects, 2);
+  CHECK_EQ(conn_policy_next_deadline(&p, 100 * MS), 100 * MS + p.backoff_min_us);
+  CHECK(!conn_policy_activity(&p, 200 * MS, &r));
+  CHECK(conn_policy_poll(&p, 100 * MS + p.backoff_min_us, &r));
+  check_params(&r, 6, 12, 0);
+
+  // 再次被拒绝，退避时间加倍
+  int64_t now = 100 * MS + p.backoff_min_us + 50 * MS;
+  CHECK(!conn_policy_updated(&p, now, false, 24, 0, 400, &r));
+  CHECK_EQ(p.retry_us, now + 2 * (int64_t)p.backoff_min_us);
+
+  // 主机接受后退避时间恢复，记录实际接受的间隔
+  CHECK(conn_policy_poll(&p, p.retry_us, &r));
+  CHECK(!conn_policy_updated(&p, p.retry_us + 50 * MS, true, 12, 0, 400, &r));
+  CHECK_EQ(p.settled, CONN_POLICY_FAST);
+  CHECK_EQ(p.backoff_us, p.backoff_min_us);
+  CHECK_EQ(p.accepted.min_int, 12);
+
+  // 重新连接时重新从首选参数开始
+  conn_policy_disconnected(&p);
+  CHECK(conn_policy_connected(&p, 100000 * MS, 24, 0, 400, &r));
+  check_params(&r, 6, 6, 0);
+  CHECK(!p.relaxed);
+}
+
+// 请求没有响应时超时视为被拒绝
+static void test_pending_timeout(void) {
+  conn_policy_t p;
+  conn_params_t r;
+  conn_policy_init(&p, 60 * IDLE_US);
+
+  CHECK(conn_policy_connected(&p, 0, 24, 0, 400, &r));
+  CHECK_EQ(conn_policy_next_deadline(&p, 0), p.pending_timeout_us);
+  CHECK(!conn_policy_poll(&p, p.pending_timeout_us - 1, &r));
+  CHECK(conn_policy_poll(&p, p.pending_timeout_us, &r));
+  check_params(&r, 6, 12, 0);
+  CHECK_EQ(p.rejects, 1);
+}
+
+// 主机主动设置的参数：短间隔满足快速模式，之后空闲仍切换到慢速
+static void test_host_initiated(void) {
+  conn_policy_t p;
+  conn_params_t r;
+  conn_policy_init(&p, IDLE_US);
+
+  CHECK(!conn_policy_connected(&p, 0, 9, 0, 400, &r));
+  CHECK(!conn_policy_activity(&p, 100 * MS, &r));
+
+  // 打字期间主机改为长间隔：不满足快速模式，立即重新请求
+  CHECK(conn_policy_updated(&p, 1000 * MS, true, 40, 0, 400, &r));
+  check_params(&r, 6, 6, 0);
+  CHECK(!accept(&p, 1100 * MS, &r, &r));
+
+  // 空闲后仍切换到慢速
+  CHECK(conn_policy_poll(&p, 100 * MS + IDLE_US, &r));
+  check_params(&r, 48, 64, 24);
+}
+
+// 首选参数为上次接受的值
+static void test_set_fast(void) {
+  conn_policy_t p;
+  conn_params_t r;
+  conn_policy_init(&p, IDLE_US);
+  conn_policy_set_fast(&p, &(conn_params_t){12, 12, 0, 400});
+  CHECK(conn_policy_connected(&p, 0, 24, 0, 400, &r));
+  check_params(&r, 12, 12, 0);
+  conn_policy_set_fast(&p, NULL);
+  CHECK_EQ(p.fast.min_int, 6);
+}
+
+int main(void) {
+  test_connect_idle_activity();
+  test_rejected_update();
+  test_pending_timeout();
+  test_host_initiated();
+  test_set_fast();
+  return CHECK_RESULT();
+}
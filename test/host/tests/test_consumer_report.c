@@ -0,0 +1,161 @@
+// Consumer 报告编码与报告描述符一致：consumer_report 支持的每个用途
+// (包括固定的频道加减 0x9C/0x9D) 都落在描述符中声明了该用途的字段上，
+// 描述符中 Consumer 页的每个用途也都能编码
+
+#include <string.h>
+
+#include "check.h"
+#include "consumer_report.h"
+#include "hid_desc.h"
+
+#define CONSUMER_PAGE 0x0C
+
+static hid_desc_t s_desc;
+
+// 报告中除 field 的第 index 个元素之外全为 0
+static bool others_zero(const uint8_t *report, const hid_desc_field_t *field,
+                        uint8_t index) {
+  uint16_t skip = field->offset + index * field->size;
+  for (uint16_t bit = 0; bit < HID_CC_IN_RPT_LEN * 8; bit++) {
+    if ((bit < skip || bit >= skip + field->size) &&
+        (report[bit / 8] >> (bit % 8)) & 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int find_usage(const hid_desc_field_t *field, uint16_t usage) {
+  for (int i = 0; i < field->num_usages; i++) {
+    if (field->usages[i] == usage) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// 按下一个用途后，报告应为描述符中该用途对应的值
+static void check_usage(uint16_t usage) {
+  uint8_t report[HID_CC_IN_RPT_LEN];
+  consumer_report_reset();
+  CHECK(consumer_report_press(usage));
+  consumer_report_encode(report);
+
+  for (int i = 0; i < s_desc.num_fields; i++) {
+    const hid_desc_field_t *f = &s_desc.fields[i];
+    if (f->report_id != HID_RPT_ID_CC_IN || f->usage_page != CONSUMER_PAGE ||
+        (f->flags & HID_DESC_FLAG_CONST)) {
+      continue;
+    }
+    int index = find_usage(f, usage);
+    if (index >= 0 && (f->flags & HID_DESC_FLAG_VAR)) {
+      // 变量字段：每个用途一个元素，按下为 1
+      CHECK_EQ(hid_desc_read(report, f->offset + index * f->size, f->size,
+                             false),
+               1);
+      CHECK(others_zero(report, f, index));
+      return;
+    }
+    if (index >= 0) {
+      // 数组字段：值为用途在列表中的序号加逻辑最小值
+      CHECK_EQ(hid_desc_read(report, f->offset, f->size, false),
+               f->logical_min + index);
+      CHECK(f->logical_min + index <= f->logical_max);
+      CHECK(others_zero(report, f, 0));
+      return;
+    }
+    if ((usage == HID_CONSUMER_CHANNEL_UP ||
+         usage == HID_CONSUMER_CHANNEL_DOWN) &&
+        find_usage(f, HID_CONSUMER_CHANNEL) >= 0) {
+      // 频道加减没有自己的用途，编码为 Channel 字段的相对值 +1/-1
+      int32_t expected = usage == HID_CONSUMER_CHANNEL_UP ? 1 : -1;
+      CHECK(f->flags & HID_DESC_FLAG_REL);
+      CHECK(f->flags & HID_DESC_FLAG_VAR);
+      CHECK(f->logical_min <= -1 && f->logical_max >= 1);
+      CHECK_EQ(hid_desc_read(report, f->offset, f->size, true), expected);
+      CHECK(others_zero(report, f, 0));
+      return;
+    }
+  }
+  fprintf(stderr, "usage 0x%03x is supported but not in the descriptor\n",
+          usage);
+  CHECK(false);
+}
+
+static void test_supported_usages_match_descriptor(void) {
+  int supported = 0;
+  for (uint32_t usage = 0; usage <= 0xFFFF; usage++) {
+    if (consumer_report_supported(usage)) {
+      check_usage(usage);
+      supported++;
+    } else {
+      CHECK(!consumer_report_press(usage));
+    }
+  }
+  CHECK(consumer_report_supported(HID_CONSUMER_CHANNEL_UP));
+  CHECK(consumer_report_supported(HID_CONSUMER_CHANNEL_DOWN));
+  CHECK(supported > 2);
+}
+
+// 描述符中 Consumer 页的用途都能编码（Channel 通过加减编码）
+static void test_descriptor_usages_supported(void) {
+  for (int i = 0; i < s_desc.num_fields; i++) {
+    const hid_desc_field_t *f = &s_desc.fields[i];
+    if (f->report_id != HID_RPT_ID_CC_IN || f->usage_page != CONSUMER_PAGE) {
+      continue;
+    }
+    for (int u = 0; u < f->num_usages; u++) {
+      if (f->usages[u] != HID_CONSUMER_CHANNEL &&
+          !consumer_report_supported(f->usages[u])) {
+        fprintf(stderr, "descriptor usage 0x%03x is not supported\n",
+                f->usages[u]);
+        CHECK(false);
+      }
+    }
+  }
+}
+
+// 报告长度与描述符的 Input 位数一致
+static void test_report_length(void) {
+  CHECK_EQ((s_desc.input_bits[HID_RPT_ID_CC_IN] + 7) / 8, HID_CC_IN_RPT_LEN);
+}
+
+// 同时按住：音量加减同时置位，同一数组字段以后按下的为准，释放后恢复
+static void test_combined(void) {
+  uint8_t report[HID_CC_IN_RPT_LEN];
+  uint8_t single[HID_CC_IN_RPT_LEN];
+
+  consumer_report_reset();
+  CHECK(consumer_report_press(HID_CONSUMER_PLAY));
+  consumer_report_encode(single);
+  CHECK(consumer_report_press(HID_CONSUMER_VOLUME_UP));
+  CHECK(consumer_report_press(HID_CONSUMER_VOLUME_DOWN));
+  CHECK(consumer_report_press(HID_CONSUMER_MUTE));
+  consumer_report_encode(report);
+  CHECK_EQ(hid_desc_read(report, HID_CONSUMER_INPUT_VOLUME_OFFSET, 2, false),
+           3);
+  CHECK(memcmp(report, single, sizeof(report)) != 0);
+
+  CHECK(consumer_report_release(HID_CONSUMER_MUTE));
+  CHECK(consumer_report_release(HID_CONSUMER_VOLUME_UP));
+  CHECK(consumer_report_release(HID_CONSUMER_VOLUME_DOWN));
+  CHECK(!consumer_report_release(HID_CONSUMER_MUTE));
+  consumer_report_encode(report);
+  CHECK(memcmp(report, single, sizeof(report)) == 0);
+
+  CHECK(consumer_report_release(HID_CONSUMER_PLAY));
+  consumer_report_encode(report);
+  for (size_t i = 0; i < sizeof(report); i++) {
+    CHECK_EQ(report[i], 0);
+  }
+}
+
+int main(void) {
+  hid_desc_parse(hid_media_report_map, HID_MEDIA_REPORT_MAP_LEN, &s_desc);
+  CHECK(!s_desc.error);
+  test_supported_usages_match_descriptor();
+  test_descriptor_usages_supported();
+  test_report_length();
+  test_combined();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""Unit tests for tools/hid_desc_compile.py.
+
+Checks item encoding, field layout, %if handling, generated C and the
+errors the compiler must report instead of emitting a broken descriptor.
+
+    python test/host/tests/test_hid_desc_compile.py
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+TOOLS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                         "..", "..", "..", "tools")
+sys.path.insert(0, TOOLS_DIR)
+
+import hid_desc_compile as hdc  # noqa: E402
+
+HEADER = "map test\nUsage Page (0x0C)\nCollection (Application)\n"
+FOOTER = "End Collection\n"
+
+
+def compile_source(text):
+    compiler = hdc.Compiler()
+    compiler.compile(text.splitlines())
+    return compiler
+
+
+def read(path):
+    with open(path, encoding="utf-8") as f:
+        return f.read()
+
+
+def map_bytes(compiler, index=0):
+    return [b for _, items in compiler.maps[index].chunks
+            for data, _ in items for b in data]
+
+
+class EncodingTest(unittest.TestCase):
+    def test_short_items(self):
+        c = compile_source(
+            "map m\n"
+            "Usage Page (0x01)\n"
+            "Logical Minimum (-1)\n"
+            "Logical Maximum (255)\n"
+            "Logical Minimum (-129)\n"
+            "Usage Page (0xFF00)\n"
+            "Usage (0x10000)\n")
+        self.assertEqual(map_bytes(c), [
+            0x05, 0x01,
+            0x15, 0xFF,
+            0x26, 0xFF, 0x00,
+            0x16, 0x7F, 0xFF,
+            0x06, 0x00, 0xFF,
+            0x0B, 0x00, 0x00, 0x01, 0x00])
+
+    def test_main_item_flags(self):
+        self.assertEqual(hdc.parse_main_flags("Data,Var,Rel,Null"), 0x46)
+        self.assertEqual(hdc.parse_main_flags("Const,Var,Abs"), 0x03)
+        self.assertEqual(hdc.parse_main_flags("Data,Array"), 0x00)
+        self.assertEqual(hdc.parse_main_flags("0x102"), 0x102)
+        c = compile_source(HEADER + "Report ID (1) r\nReport Size (8)\n"
+                           "Report Count (1)\nInput (0x102) f\n" + FOOTER)
+        self.assertEqual(map_bytes(c)[-4:-1], [0x82, 0x02, 0x01])
+
+    def test_collections(self):
+        c = compile_source("map m\nCollection (Application)\n"
+                           "Collection (Logical)\nEnd Collection\n"
+                           "Collection (0x80)\nEnd Collection\n"
+                           "End Collection\n")
+        self.assertEqual(map_bytes(c), [0xA1, 0x01, 0xA1, 0x02, 0xC0,
+                                        0xA1, 0x80, 0xC0, 0xC0])
+
+    def test_comments_and_blank_lines(self):
+        c = compile_source("# header\n\nmap m\n  Usage Page (0x01)  # GD\n")
+        self.assertEqual(map_bytes(c), [0x05, 0x01])
+
+
+class LayoutTest(unittest.TestCase):
+    def test_field_offsets(self):
+        c = compile_source(
+            HEADER +
+            "Report ID (3) r\n"
+            "Report Size (1)\nReport Count (3)\nInput (Data,Var,Abs) a\n"
+            "Report Count (5)\nInput (Const)\n"
+            "Report Size (8)\nReport Count (2)\nInput (Data,Array) b\n"
+            "Report Size (4)\nReport Count (2)\nOutput (Data,Var,Abs) c\n"
+            + FOOTER)
+        inputs = c.reports[("test", 3, 0x80)]
+        self.assertEqual(inputs.bits, 24)
+        self.assertEqual([(f.name, f.offset, f.size, f.count)
+                          for f in inputs.fields],
+                         [("a", 0, 1, 3), (None, 3, 1, 5), ("b", 8, 8, 2)])
+        outputs = c.reports[("test", 3, 0x90)]
+        self.assertEqual(outputs.bits, 8)
+        self.assertEqual(outputs.fields[0].offset, 0)
+
+    def test_usages_reset_after_main_item(self):
+        c = compile_source(
+            HEADER + "Report ID (1) r\nReport Size (8)\nReport Count (1)\n"
+            "Usage (0xE9)\nUsage (0xEA)\nInput (Data,Array) a\n"
+            "Usage Minimum (1)\nUsage Maximum (3)\nInput (Data,Array) b\n"
+            + FOOTER)
+        a, b = c.reports[("test", 1, 0x80)].fields
+        self.assertEqual((a.usages, a.usage_range), ([0xE9, 0xEA], None))
+        self.assertEqual((b.usages, b.usage_range), ([], (1, 3)))
+
+    def test_conditional_report(self):
+        c = compile_source(
+            "map m\nCollection (Application)\nEnd Collection\n"
+            "%if OPT\nCollection (Application)\nEnd Collection\n%endif\n")
+        self.assertEqual(hdc.map_length_expr(c.maps[0]), "(3 + (OPT ? 3 : 0))")
+
+
+class ErrorTest(unittest.TestCase):
+    def assertCompileError(self, body, message, wrap=True):
+        text = HEADER + "Report ID (1) r\n" + body + FOOTER if wrap else body
+        with self.assertRaises(hdc.CompileError) as ctx:
+            compile_source(text)
+        self.assertIn(message, str(ctx.exception))
+
+    def test_data_field_needs_name(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Input (Data,Var,Abs)\n", "needs a name")
+
+    def test_constant_field_cannot_be_named(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Input (Const) pad\n", "cannot be named")
+
+    def test_duplicate_field(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Input (Data,Var,Abs) a\n"
+                                "Input (Data,Var,Abs) a\n", "duplicate field")
+
+    def test_field_too_wide(self):
+        self.assertCompileError("Report Size (40)\nReport Count (1)\n"
+                                "Input (Data,Var,Abs) a\n", "wider than 32")
+
+    def test_not_byte_aligned(self):
+        self.assertCompileError("Report Size (1)\nReport Count (3)\n"
+                                "Input (Data,Var,Abs) a\n", "not byte aligned")
+
+    def test_unknown_flag(self):
+        self.assertCompileError("Input (Data,Sideways) a\n",
+                                "unknown main item flag")
+
+    def test_usage_range_pairs(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Usage Minimum (1)\nInput (Data,Array) a\n",
+                                "must come in pairs")
+
+    def test_report_id(self):
+        self.assertCompileError("Report ID (0) x\n", "1..255")
+        self.assertCompileError("Report ID (2)\n", "needs a report name")
+
+    def test_name_on_other_items(self):
+        self.assertCompileError("Report Size (8) size\n", "take a name")
+
+    def test_unknown_item_and_directive(self):
+        self.assertCompileError("Push\n", "cannot parse")
+        self.assertCompileError("%define X\n", "unknown directive")
+
+    def test_structure(self):
+        self.assertCompileError("map m\nEnd Collection\n",
+                                "without Collection", wrap=False)
+        self.assertCompileError("map m\nCollection (Application)\n",
+                                "missing End Collection", wrap=False)
+        self.assertCompileError("map m\n%if A\n", "missing %endif", wrap=False)
+        self.assertCompileError("map m\n%endif\n", "without %if", wrap=False)
+        self.assertCompileError("map m\n%if A\n%if B\n", "nested %if",
+                                wrap=False)
+        self.assertCompileError("Usage (1)\n", "outside of a map", wrap=False)
+        self.assertCompileError(HEADER + "map n\n", "inside a collection",
+                                wrap=False)
+
+    def test_report_spans_if(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Input (Data,Var,Abs) a\n%if X\n"
+                                "Input (Data,Var,Abs) b\n%endif\n", "spans")
+
+    def test_value_too_large(self):
+        self.assertCompileError("Usage (0x100000000)\n", "does not fit")
+
+    def test_error_reports_line(self):
+        self.assertCompileError("Report Size (8)\nReport Count (1)\n"
+                                "Input (Data,Var,Abs)\n", "line 7:")
+
+
+class CommandLineTest(unittest.TestCase):
+    TOOL = os.path.join(TOOLS_DIR, "hid_desc_compile.py")
+    SOURCE = os.path.join(TOOLS_DIR, "..", "src", "hid_report_maps.hid")
+
+    def run_tool(self, *args):
+        return subprocess.run([sys.executable, self.TOOL] + list(args),
+                              capture_output=True, text=True)
+
+    def test_generates_repo_descriptor(self):
+        with tempfile.TemporaryDirectory() as out:
+            result = self.run_tool(self.SOURCE, "-o", out)
+            self.assertEqual(result.returncode, 0, result.stderr)
+            header = read(os.path.join(out, "hid_report_maps.h"))
+            source = read(os.path.join(out, "hid_report_maps.c"))
+        self.assertIn('#include "hid_report.h"', source)
+        self.assertIn("#define HID_RPT_ID_CONSUMER 3", header)
+        self.assertIn("#define HID_CONSUMER_INPUT_LEN 2", header)
+        self.assertIn("const uint8_t hid_media_report_map[]", source)
+        self.assertIn("#if HID_REPORT_NKRO_ENABLED", source)
+
+    def test_output_is_deterministic(self):
+        with tempfile.TemporaryDirectory() as a, \
+                tempfile.TemporaryDirectory() as b:
+            self.run_tool(self.SOURCE, "-o", a, "-n", "maps")
+            self.run_tool(self.SOURCE, "-o", b, "-n", "maps")
+            for name in ("maps.c", "maps.h"):
+                self.assertEqual(read(os.path.join(a, name)),
+                                 read(os.path.join(b, name)))
+
+    def test_error_exit(self):
+        with tempfile.TemporaryDirectory() as out:
+            bad = os.path.join(out, "bad.hid")
+            with open(bad, "w") as f:
+                f.write("map m\nCollection (Application)\n")
+            result = self.run_tool(bad, "-o", out)
+            self.assertNotEqual(result.returncode, 0)
+            self.assertIn("missing End Collection", result.stderr)
+            self.assertFalse(os.path.exists(os.path.join(out, "bad.c")))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,145 @@
+// 生成的报告描述符与生成前手写的描述符逐字节相同，生成的布局常量和
+// 打包/解包函数与描述符一致。以 HID_REPORT_NKRO_ENABLED=0/1 各编译一次
+
+#include <string.h>
+
+#include "check.h"
+#include "golden_report_maps.h"
+#include "hid_desc.h"
+#include "hid_report_maps.h"
+
+#define CHECK_MAP(golden, generated, len)                   \
+  do {                                                      \
+    CHECK_EQ(sizeof(golden), len);                          \
+    CHECK(sizeof(golden) == (len) &&                        \
+          memcmp(golden, generated, sizeof(golden)) == 0);  \
+  } while (0)
+
+static void test_maps_match_golden(void) {
+  CHECK_MAP(golden_keyboard_report_map, hid_keyboard_report_map,
+            HID_KEYBOARD_REPORT_MAP_LEN);
+  CHECK_MAP(golden_media_report_map, hid_media_report_map,
+            HID_MEDIA_REPORT_MAP_LEN);
+  CHECK_MAP(golden_mouse_report_map, hid_mouse_report_map,
+            HID_MOUSE_REPORT_MAP_LEN);
+}
+
+// 生成的 Input 布局表与从基准描述符解析出的字段相同
+static void check_layout(const hid_desc_t *desc,
+                         const hid_report_layout_t *layout) {
+  CHECK_EQ(layout->kind, 0x80);
+  CHECK_EQ(layout->len * 8, desc->input_bits[layout->report_id]);
+  uint8_t n = 0;
+  for (int i = 0; i < desc->num_fields; i++) {
+    const hid_desc_field_t *f = &desc->fields[i];
+    if (f->report_id != layout->report_id) {
+      continue;
+    }
+    if (n == layout->num_fields) {
+      CHECK(false);
+      return;
+    }
+    const hid_field_layout_t *g = &layout->fields[n++];
+    CHECK_EQ(g->offset, f->offset);
+    CHECK_EQ(g->size, f->size);
+    CHECK_EQ(g->count, f->count);
+    CHECK_EQ(g->flags, f->flags);
+    CHECK_EQ(g->name == NULL, (f->flags & HID_DESC_FLAG_CONST) != 0);
+  }
+  CHECK_EQ(n, layout->num_fields);
+}
+
+static void test_layouts(void) {
+  hid_desc_t desc;
+  hid_desc_parse(golden_keyboard_report_map, sizeof(golden_keyboard_report_map),
+                 &desc);
+  CHECK(!desc.error);
+  check_layout(&desc, &hid_keyboard_input_layout);
+#if HID_REPORT_NKRO_ENABLED
+  check_layout(&desc, &hid_nkro_input_layout);
+#else
+  CHECK_EQ(desc.input_bits[HID_RPT_ID_NKRO], 0);
+#endif
+
+  hid_desc_parse(golden_media_report_map, sizeof(golden_media_report_map),
+                 &desc);
+  CHECK(!desc.error);
+  check_layout(&desc, &hid_consumer_input_layout);
+
+  hid_desc_parse(golden_mouse_report_map, sizeof(golden_mouse_report_map),
+                 &desc);
+  CHECK(!desc.error);
+  check_layout(&desc, &hid_mouse_input_layout);
+}
+
+// 打包的结果按基准描述符的字段位置读回
+static void test_keyboard_pack(void) {
+  hid_keyboard_input_t r = {.modifiers = 0xA5, .keys = {4, 5, 6, 7, 8, 0x65}};
+  uint8_t out[HID_KEYBOARD_INPUT_LEN];
+  memset(out, 0xFF, sizeof(out));
+  hid_keyboard_input_pack(&r, out);
+  CHECK_EQ(hid_desc_read(out, 0, 8, false), 0xA5);
+  CHECK_EQ(hid_desc_read(out, 8, 8, false), 0);  // 保留字节
+  for (int i = 0; i < 6; i++) {
+    CHECK_EQ(hid_desc_read(out, 16 + 8 * i, 8, false), r.keys[i]);
+  }
+
+  // LED 输出报告：高 3 位为常量填充，解包时忽略
+  uint8_t in = 0xF3;
+  hid_keyboard_output_t leds;
+  hid_keyboard_output_unpack(&in, &leds);
+  CHECK_EQ(leds.leds, 0x13);
+}
+
+static void test_nkro_pack(void) {
+  hid_nkro_input_t r = {0};
+  r.keys[0x04 / 8] |= 1 << (0x04 % 8);
+  r.keys[0xE7 / 8] |= 1 << (0xE7 % 8);
+  uint8_t out[HID_NKRO_INPUT_LEN];
+  hid_nkro_input_pack(&r, out);
+  for (int usage = 0; usage <= 0xE7; usage++) {
+    CHECK_EQ(hid_desc_read(out, usage, 1, false),
+             usage == 0x04 || usage == 0xE7);
+  }
+}
+
+static void test_consumer_pack(void) {
+  hid_consumer_input_t r = {
+      .numeric = 10, .channel = -1, .volume = 2, .buttons = 12, .selection = 3};
+  uint8_t out[HID_CONSUMER_INPUT_LEN];
+  hid_consumer_input_pack(&r, out);
+  CHECK_EQ(hid_desc_read(out, 0, 4, false), 10);
+  CHECK_EQ(hid_desc_read(out, 4, 2, true), -1);
+  CHECK_EQ(hid_desc_read(out, 6, 2, false), 2);
+  CHECK_EQ(hid_desc_read(out, 8, 4, false), 12);
+  CHECK_EQ(hid_desc_read(out, 12, 2, false), 3);
+  CHECK_EQ(hid_desc_read(out, 14, 2, false), 0);  // 常量填充
+
+  // 超出位宽的值被截断，不影响相邻字段
+  r = (hid_consumer_input_t){.channel = 1, .volume = 0xFF};
+  hid_consumer_input_pack(&r, out);
+  CHECK_EQ(hid_desc_read(out, 4, 2, true), 1);
+  CHECK_EQ(hid_desc_read(out, 6, 2, false), 3);
+  CHECK_EQ(hid_desc_read(out, 8, 8, false), 0);
+}
+
+static void test_mouse_pack(void) {
+  hid_mouse_input_t r = {.buttons = 5, .motion = {-127, 1, 127}};
+  uint8_t out[HID_MOUSE_INPUT_LEN];
+  hid_mouse_input_pack(&r, out);
+  CHECK_EQ(hid_desc_read(out, 0, 3, false), 5);
+  CHECK_EQ(hid_desc_read(out, 3, 5, false), 0);
+  CHECK_EQ(hid_desc_read(out, 8, 8, true), -127);
+  CHECK_EQ(hid_desc_read(out, 16, 8, true), 1);
+  CHECK_EQ(hid_desc_read(out, 24, 8, true), 127);
+}
+
+int main(void) {
+  test_maps_match_golden();
+  test_layouts();
+  test_keyboard_pack();
+  test_nkro_pack();
+  test_consumer_pack();
+  test_mouse_pack();
+  return CHECK_RESULT();
+}
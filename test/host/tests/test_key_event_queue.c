@@ -0,0 +1,157 @@
+// 扫描任务到发送任务的 SPSC 队列：生产者快于消费者时的丢弃计数和顺序
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "check.h"
+#include "key_event_queue.h"
+
+#define DEPTH 8
+#define THREAD_EVENTS 200000
+
+static key_event_t make_event(uint32_t seq) {
+  key_event_t event = {
+      .timestamp_us = seq, .edge_us = seq, .row = seq & 0xFF, .pressed = true};
+  return event;
+}
+
+static void test_init(void) {
+  key_event_queue_t q;
+  key_event_t buffer[DEPTH];
+  CHECK(!key_event_queue_init(&q, buffer, 0));
+  CHECK(!key_event_queue_init(&q, buffer, 6));
+  CHECK(!key_event_queue_init(&q, NULL, DEPTH));
+  CHECK(key_event_queue_init(&q, buffer, DEPTH));
+  key_event_t event;
+  CHECK(!key_event_queue_pop(&q, &event));
+  CHECK_EQ(key_event_queue_count(&q), 0);
+}
+
+// 生产者每轮写入 3 个，消费者只取 1 个：队列满后丢弃最新的事件，
+// 已写入的事件按顺序取出，写入数加丢弃数等于产生的事件数
+static void test_producer_outpaces_consumer(void) {
+  key_event_queue_t q;
+  key_event_t buffer[DEPTH];
+  key_event_queue_init(&q, buffer, DEPTH);
+
+  uint32_t accepted[300];
+  uint32_t num_accepted = 0;
+  uint32_t num_popped = 0;
+  uint32_t seq = 0;
+  for (int round = 0; round < 100; round++) {
+    for (int i = 0; i < 3; i++, seq++) {
+      key_event_t event = make_event(seq);
+      if (key_event_queue_push(&q, &event)) {
+        accepted[num_accepted++] = seq;
+      }
+      CHECK(key_event_queue_count(&q) <= DEPTH);
+    }
+    key_event_t event;
+    if (key_event_queue_pop(&q, &event)) {
+      CHECK_EQ(event.timestamp_us, accepted[num_popped]);
+      num_popped++;
+    }
+  }
+  CHECK_EQ(num_accepted + key_event_queue_dropped(&q), seq);
+  CHECK(key_event_queue_dropped(&q) > 0);
+  CHECK_EQ(key_event_queue_high_water(&q), DEPTH);
+  // 每轮最后取出一个，结束时比满少一个
+  CHECK_EQ(key_event_queue_count(&q), DEPTH - 1);
+
+  // 队列满时不覆盖已排队的事件，取空后得到剩余的全部事件
+  key_event_t event;
+  while (key_event_queue_pop(&q, &event)) {
+    CHECK_EQ(event.timestamp_us, accepted[num_popped]);
+    num_popped++;
+  }
+  CHECK_EQ(num_popped, num_accepted);
+  CHECK_EQ(key_event_queue_count(&q), 0);
+}
+
+// 读写位置越过 32 位回绕后仍能正确计数
+static void test_index_wrap(void) {
+  key_event_queue_t q;
+  key_event_t buffer[DEPTH];
+  key_event_queue_init(&q, buffer, DEPTH);
+  atomic_store(&q.head, UINT32_MAX - 2);
+  atomic_store(&q.tail, UINT32_MAX - 2);
+
+  for (uint32_t seq = 0; seq < DEPTH + 2; seq++) {
+    key_event_t event = make_event(seq);
+    CHECK_EQ(key_event_queue_push(&q, &event), seq < DEPTH);
+  }
+  CHECK_EQ(key_event_queue_count(&q), DEPTH);
+  CHECK_EQ(key_event_queue_dropped(&q), 2);
+  for (uint32_t seq = 0; seq < DEPTH; seq++) {
+    key_event_t event;
+    CHECK(key_event_queue_pop(&q, &event));
+    CHECK_EQ(event.timestamp_us, seq);
+  }
+}
+
+// 两个线程同时运行：生产者不等待，消费者每次取出后暂停
+static key_event_queue_t s_queue;
+static key_event_t s_buffer[DEPTH];
+static uint8_t s_accepted[THREAD_EVENTS];
+static atomic_bool s_done;
+
+static void *producer(void *arg) {
+  for (uint32_t seq = 0; seq < THREAD_EVENTS; seq++) {
+    key_event_t event = make_event(seq);
+    s_accepted[seq] = key_event_queue_push(&s_queue, &event);
+  }
+  atomic_store(&s_done, true);
+  return NULL;
+}
+
+static void test_threads(void) {
+  key_event_queue_init(&s_queue, s_buffer, DEPTH);
+  atomic_store(&s_done, false);
+  pthread_t thread;
+  pthread_create(&thread, NULL, producer, NULL);
+
+  int64_t last = -1;
+  uint32_t popped = 0;
+  uint32_t out_of_order = 0;
+  uint32_t torn = 0;
+  while (true) {
+    bool done = atomic_load(&s_done);
+    key_event_t event;
+    if (!key_event_queue_pop(&s_queue, &event)) {
+      if (done) {
+        break;
+      }
+      continue;
+    }
+    out_of_order += event.timestamp_us <= last;
+    torn += event.edge_us != event.timestamp_us ||
+            event.row != (event.timestamp_us & 0xFF);
+    last = event.timestamp_us;
+    popped++;
+    if ((popped & 0x3F) == 0) {
+      struct timespec pause = {.tv_nsec = 20000};
+      nanosleep(&pause, NULL);
+    }
+  }
+  pthread_join(thread, NULL);
+
+  uint32_t accepted = 0;
+  for (uint32_t seq = 0; seq < THREAD_EVENTS; seq++) {
+    accepted += s_accepted[seq];
+  }
+  CHECK_EQ(out_of_order, 0);
+  CHECK_EQ(torn, 0);
+  CHECK_EQ(popped, accepted);
+  CHECK_EQ(accepted + key_event_queue_dropped(&s_queue), THREAD_EVENTS);
+  CHECK(key_event_queue_dropped(&s_queue) > 0);
+}
+
+int main(void) {
+  test_init();
+  test_producer_outpaces_consumer();
+  test_index_wrap();
+  test_threads();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,85 @@
+// 字符串输入：每次调用最多发送 credits 个报告，只统计实际发送的报告，发送失败后重发
+
+#include "check.h"
+#include "hid_report.h"
+#include "key_typer.h"
+#include "keymap.h"
+
+#define INTERVAL_US 7500
+
+static int s_sends = 0;
+static int s_refuse = 0;  // 之后 n 次发送失败
+
+static int fake_send(uint8_t report_id, uint8_t *data, uint16_t len) {
+  if (s_refuse > 0) {
+    s_refuse--;
+    return -1;
+  }
+  s_sends++;
+  return 0;
+}
+
+static void setup(void) {
+  hid_report_init(fake_send);
+  s_sends = 0;
+  s_refuse = 0;
+}
+
+static void test_credits_limit_reports(void) {
+  setup();
+  // 键码各不相同：按下 a、b 换 a、c 换 b、释放 c，共 4 个报告
+  CHECK_EQ(key_typer_type_utf8("abc"), 3);
+
+  uint32_t start = hid_report_sent_count();
+  CHECK_EQ(key_typer_run(0, INTERVAL_US, 0), INTERVAL_US);
+  CHECK_EQ(s_sends, 0);
+  CHECK_EQ(key_typer_run(0, INTERVAL_US, 3), INTERVAL_US);
+  CHECK_EQ(s_sends, 3);
+  CHECK_EQ(key_typer_run(INTERVAL_US, INTERVAL_US, 3), 0);
+  CHECK_EQ(s_sends, 4);
+  CHECK_EQ(hid_report_sent_count() - start, 4);
+  // 没有内容时不发送
+  CHECK_EQ(key_typer_run(INTERVAL_US, INTERVAL_US, 3), 0);
+  CHECK_EQ(s_sends, 4);
+}
+
+static void test_repeated_key_needs_release(void) {
+  setup();
+  // 相同键码之间插入释放帧：按下、释放、按下、释放
+  CHECK_EQ(key_typer_type_utf8("aa"), 2);
+  CHECK_EQ(key_typer_run(0, INTERVAL_US, 8), 0);
+  CHECK_EQ(s_sends, 4);
+}
+
+static void test_refused_frame_resent(void) {
+  setup();
+  CHECK_EQ(key_typer_type_utf8("ab"), 2);
+  // 第一帧被拒绝：不占用额度，帧保留到下次
+  s_refuse = 1;
+  CHECK_EQ(key_typer_run(0, INTERVAL_US, 8), INTERVAL_US);
+  CHECK_EQ(s_sends, 0);
+  CHECK_EQ(key_typer_run(INTERVAL_US, INTERVAL_US, 8), 0);
+  CHECK_EQ(s_sends, 3);
+}
+
+static void test_pause_keeps_queue(void) {
+  setup();
+  CHECK_EQ(key_typer_type_utf8("xyz"), 3);
+  CHECK_EQ(key_typer_run(0, INTERVAL_US, 1), INTERVAL_US);
+  CHECK_EQ(s_sends, 1);
+  // 断开：当前字符在主机侧已释放，重新连接后从下一个字符继续
+  key_typer_pause();
+  hid_report_reset();
+  CHECK_EQ(key_typer_run(INTERVAL_US, INTERVAL_US, 8), 0);
+  CHECK_EQ(s_sends, 4);
+}
+
+int main(void) {
+  keymap_init();
+  key_typer_init(NULL);
+  test_credits_limit_reports();
+  test_repeated_key_needs_release();
+  test_refused_frame_resent();
+  test_pause_keeps_queue();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,163 @@
+// 扫描结果索引：插入和更新、结果表满时拒绝、名字存储区耗尽、
+// 大量广播者时每个广播包的开销不随已收到的包数增长
+
+#include <string.h>
+
+#include "check.h"
+#include "esp_cpu.h"
+#include "scan_index.h"
+
+#define FLOOD_BATCHES 20
+#define FLOOD_BATCH 5000
+
+static scan_index_t s_index;
+
+static void make_bda(uint32_t n, uint8_t bda[ESP_BD_ADDR_LEN]) {
+  memset(bda, 0, ESP_BD_ADDR_LEN);
+  bda[0] = 0xC0;  // 随机静态地址
+  bda[2] = n >> 16;
+  bda[3] = n >> 8;
+  bda[5] = n;
+}
+
+static esp_hid_scan_result_t *insert(uint32_t n, esp_hid_transport_t transport,
+                                     bool *created) {
+  uint8_t bda[ESP_BD_ADDR_LEN];
+  make_bda(n, bda);
+  return scan_index_insert(&s_index, bda, transport, created);
+}
+
+static void test_insert_update(void) {
+  scan_index_init(&s_index);
+  uint8_t bda[ESP_BD_ADDR_LEN];
+  make_bda(1, bda);
+  CHECK(scan_index_find(&s_index, bda, ESP_HID_TRANSPORT_BLE) == NULL);
+  CHECK(scan_index_list(&s_index) == NULL);
+
+  bool created;
+  esp_hid_scan_result_t *r = insert(1, ESP_HID_TRANSPORT_BLE, &created);
+  CHECK(r != NULL && created);
+  CHECK(memcmp(r->bda, bda, ESP_BD_ADDR_LEN) == 0);
+  CHECK_EQ(r->transport, ESP_HID_TRANSPORT_BLE);
+  r->rssi = -70;
+
+  // 同一设备再次出现：返回同一个结果，已填的字段保留
+  CHECK(insert(1, ESP_HID_TRANSPORT_BLE, &created) == r && !created);
+  CHECK_EQ(r->rssi, -70);
+  CHECK(scan_index_find(&s_index, bda, ESP_HID_TRANSPORT_BLE) == r);
+
+  // 同一地址的另一种传输方式是另一个设备
+  esp_hid_scan_result_t *bt = insert(1, ESP_HID_TRANSPORT_BT, &created);
+  CHECK(bt != NULL && bt != r && created);
+  CHECK_EQ(s_index.count, 2);
+
+  // 链表按插入顺序
+  esp_hid_scan_result_t *list = scan_index_list(&s_index);
+  CHECK(list == r && r->next == bt && bt->next == NULL);
+  CHECK_EQ(s_index.dropped, 0);
+}
+
+static void test_full_table(void) {
+  scan_index_init(&s_index);
+  bool created;
+  for (uint32_t n = 0; n < SCAN_INDEX_MAX_RESULTS; n++) {
+    CHECK(insert(n, ESP_HID_TRANSPORT_BLE, &created) != NULL && created);
+  }
+  CHECK_EQ(s_index.count, SCAN_INDEX_MAX_RESULTS);
+
+  // 新设备被丢弃并计数，已有的设备仍然能找到和更新
+  CHECK(insert(SCAN_INDEX_MAX_RESULTS, ESP_HID_TRANSPORT_BLE, &created) ==
+        NULL);
+  CHECK(!created);
+  CHECK_EQ(s_index.dropped, 1);
+  for (uint32_t n = 0; n < SCAN_INDEX_MAX_RESULTS; n++) {
+    esp_hid_scan_result_t *r = insert(n, ESP_HID_TRANSPORT_BLE, &created);
+    CHECK(r == &s_index.results[n] && !created);
+  }
+  CHECK_EQ(s_index.count, SCAN_INDEX_MAX_RESULTS);
+  CHECK_EQ(s_index.dropped, 1);
+
+  // 重新初始化后可以再次使用
+  scan_index_init(&s_index);
+  CHECK(insert(SCAN_INDEX_MAX_RESULTS, ESP_HID_TRANSPORT_BLE, &created) !=
+        NULL);
+  CHECK(created);
+  CHECK_EQ(s_index.dropped, 0);
+}
+
+static void test_name_arena(void) {
+  scan_index_init(&s_index);
+  uint8_t name[SCAN_INDEX_NAMES_LEN];
+  memset(name, 'k', sizeof(name));
+
+  // 名字加上结尾的 0 复制到存储区
+  const char *a = scan_index_name(&s_index, (const uint8_t *)"kbd", 3);
+  CHECK(a != NULL && strcmp(a, "kbd") == 0);
+  const char *empty = scan_index_name(&s_index, name, 0);
+  CHECK(empty != NULL && empty[0] == 0);
+  CHECK_EQ(s_index.names_used, 5);
+
+  // 正好用完剩余空间
+  size_t rest = SCAN_INDEX_NAMES_LEN - s_index.names_used;
+  const char *b = scan_index_name(&s_index, name, rest - 1);
+  CHECK(b != NULL && strlen(b) == rest - 1);
+  CHECK_EQ(s_index.names_used, SCAN_INDEX_NAMES_LEN);
+  CHECK_EQ(s_index.dropped, 0);
+
+  // 存储区耗尽：返回 NULL 并计数，已有的名字不受影响
+  CHECK(scan_index_name(&s_index, name, 0) == NULL);
+  CHECK(scan_index_name(&s_index, name, 1) == NULL);
+  CHECK_EQ(s_index.dropped, 2);
+  CHECK(strcmp(a, "kbd") == 0);
+
+  // 放不下的长名字不占用空间，之后的短名字仍然可以放入
+  scan_index_init(&s_index);
+  CHECK(scan_index_name(&s_index, name, SCAN_INDEX_NAMES_LEN) == NULL);
+  CHECK_EQ(s_index.names_used, 0);
+  CHECK(scan_index_name(&s_index, (const uint8_t *)"kbd", 3) != NULL);
+}
+
+// 一批不同广播者的插入耗时 (周期数)
+static uint32_t flood_batch(uint32_t first) {
+  bool created;
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (uint32_t n = first; n < first + FLOOD_BATCH; n++) {
+    insert(n, ESP_HID_TRANSPORT_BLE, &created);
+  }
+  return esp_cpu_get_cycle_count() - start;
+}
+
+static void test_flood(void) {
+  scan_index_init(&s_index);
+  uint32_t first_best = UINT32_MAX;
+  uint32_t last_best = UINT32_MAX;
+  for (int batch = 0; batch < FLOOD_BATCHES; batch++) {
+    uint32_t cycles = flood_batch(batch * FLOOD_BATCH);
+    if (batch < 3 && cycles < first_best) {
+      first_best = cycles;
+    }
+    if (batch >= FLOOD_BATCHES - 3 && cycles < last_best) {
+      last_best = cycles;
+    }
+  }
+  // 表满后每个新广播者只是计数，不占用内存
+  CHECK_EQ(s_index.count, SCAN_INDEX_MAX_RESULTS);
+  CHECK_EQ(s_index.dropped,
+           FLOOD_BATCHES * FLOOD_BATCH - SCAN_INDEX_MAX_RESULTS);
+  bool created;
+  CHECK(insert(0, ESP_HID_TRANSPORT_BLE, &created) == &s_index.results[0]);
+  CHECK(insert(SCAN_INDEX_MAX_RESULTS - 1, ESP_HID_TRANSPORT_BLE, &created) ==
+        &s_index.results[SCAN_INDEX_MAX_RESULTS - 1]);
+  // 每个包的开销不随已收到的包数增长；留出余量避免计时抖动误报
+  printf("flood: first batch %u cycles, last batch %u cycles\n", first_best,
+         last_best);
+  CHECK(last_best <= 3 * first_best + FLOOD_BATCH);
+}
+
+int main(void) {
+  test_insert_update();
+  test_full_table();
+  test_name_arena();
+  test_flood();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,633 @@
+#!/usr/bin/env python3
+"""Compile HID report descriptor sources into C tables and packers.
+
+Reads a .hid descriptor source (see src/hid_report_maps.hid) and writes
+<name>.c and <name>.h next to each other in the output directory:
+
+  - one const byte array per report map, plus its length macro
+  - HID_RPT_ID_<REPORT>, HID_<REPORT>_<KIND>_LEN for every report
+  - bit offset / size / count macros and a field layout table per report
+  - a C struct and an inline pack (input) or unpack (output, feature)
+    function per report, so runtime code never shuffles bytes by hand
+  - an X-macro list of the usages behind every named field
+
+    python tools/hid_desc_compile.py src/hid_report_maps.hid -o build/
+"""
+
+import argparse
+import os
+import re
+import sys
+
+MAIN_ITEMS = {"Input": 0x80, "Output": 0x90, "Feature": 0xB0}
+COLLECTION = 0xA0
+END_COLLECTION = 0xC0
+GLOBAL_ITEMS = {
+    "Usage Page": 0x04,
+    "Logical Minimum": 0x14,
+    "Logical Maximum": 0x24,
+    "Physical Minimum": 0x34,
+    "Physical Maximum": 0x44,
+    "Unit Exponent": 0x54,
+    "Unit": 0x64,
+    "Report Size": 0x74,
+    "Report ID": 0x84,
+    "Report Count": 0x94,
+}
+LOCAL_ITEMS = {"Usage": 0x08, "Usage Minimum": 0x18, "Usage Maximum": 0x28}
+SIGNED_ITEMS = {
+    "Logical Minimum",
+    "Logical Maximum",
+    "Physical Minimum",
+    "Physical Maximum",
+    "Unit Exponent",
+}
+COLLECTION_TYPES = {
+    "Physical": 0,
+    "Application": 1,
+    "Logical": 2,
+    "Report": 3,
+    "Named Array": 4,
+    "Usage Switch": 5,
+    "Usage Modifier": 6,
+}
+# Main item flag words; the first word of each pair is the 0 state
+MAIN_FLAGS = {
+    "Data": (0, 0), "Const": (0, 1), "Cnst": (0, 1), "Constant": (0, 1),
+    "Array": (1, 0), "Var": (1, 1), "Variable": (1, 1),
+    "Abs": (2, 0), "Absolute": (2, 0), "Rel": (2, 1), "Relative": (2, 1),
+    "No Wrap": (3, 0), "Wrap": (3, 1),
+    "Linear": (4, 0), "Non Linear": (4, 1),
+    "Preferred": (5, 0), "No Preferred": (5, 1),
+    "No Null": (6, 0), "Null": (6, 1),
+    "Non Volatile": (7, 0), "Volatile": (7, 1),
+}
+KIND_NAMES = {0x80: "input", 0x90: "output", 0xB0: "feature"}
+
+ITEM_NAMES = sorted(
+    list(MAIN_ITEMS) + list(GLOBAL_ITEMS) + list(LOCAL_ITEMS) +
+    ["Collection", "End Collection"], key=len, reverse=True)
+REST_RE = re.compile(
+    r"^(?:\((?P<arg>[^)]*)\))?\s*(?P<name>[A-Za-z_][A-Za-z0-9_]*)?$")
+
+
+class CompileError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, name, offset, size, count, flags, logical_min,
+                 logical_max, usages, usage_range):
+        self.name = name
+        self.offset = offset
+        self.size = size
+        self.count = count
+        self.flags = flags
+        self.logical_min = logical_min
+        self.logical_max = logical_max
+        self.usages = usages
+        self.usage_range = usage_range
+
+    @property
+    def constant(self):
+        return self.flags & 1
+
+    @property
+    def variable(self):
+        return self.flags & 2
+
+    @property
+    def bitmask(self):
+        return self.variable and self.size == 1
+
+
+class Report:
+    def __init__(self, map_name, report_id, kind, name, cond):
+        self.map_name = map_name
+        self.report_id = report_id
+        self.kind = kind
+        self.name = name
+        self.cond = cond
+        self.bits = 0
+        self.fields = []
+
+    @property
+    def ident(self):
+        return "%s_%s" % (self.name, KIND_NAMES[self.kind])
+
+
+class ReportMap:
+    def __init__(self, name):
+        self.name = name
+        self.chunks = []  # (cond, [(bytes, comment)])
+
+
+def encode_data(value, signed):
+    for size, code in ((1, 1), (2, 2), (4, 3)):
+        bits = size * 8
+        if signed:
+            fits = -(1 << (bits - 1)) <= value < (1 << (bits - 1))
+        else:
+            fits = 0 <= value < (1 << bits)
+        if fits:
+            return code, list((value & ((1 << bits) - 1)).to_bytes(size, "little"))
+    raise CompileError("value %d does not fit in 4 bytes" % value)
+
+
+def parse_number(text):
+    return int(text, 0)
+
+
+def parse_main_flags(arg):
+    if re.fullmatch(r"\s*-?(0x)?[0-9A-Fa-f]+\s*", arg or ""):
+        return parse_number(arg)
+    flags = 0
+    for word in (arg or "").split(","):
+        word = word.strip()
+        if word not in MAIN_FLAGS:
+            raise CompileError("unknown main item flag '%s'" % word)
+        bit, state = MAIN_FLAGS[word]
+        flags = (flags & ~(1 << bit)) | (state << bit)
+    return flags
+
+
+def split_item(text):
+    """Split 'Report ID (1) keyboard' into ('Report ID', '1', 'keyboard')."""
+    for item in ITEM_NAMES:
+        rest = text[len(item):]
+        if text.startswith(item) and (not rest or not rest[0].isalnum()):
+            match = REST_RE.match(rest.strip())
+            if match:
+                return item, match.group("arg"), match.group("name")
+    raise CompileError("cannot parse '%s'" % text)
+
+
+class Compiler:
+    def __init__(self):
+        self.maps = []
+        self.includes = []
+        self.reports = {}  # (map, id, kind) -> Report
+        self.report_order = []
+        self.report_names = {}  # (map, id) -> name
+        self.cond = None
+        self.map = None
+        self.depth = 0
+        self.reset_globals()
+        self.reset_locals()
+
+    def reset_globals(self):
+        self.usage_page = 0
+        self.logical_min = 0
+        self.logical_max = 0
+        self.report_size = 0
+        self.report_count = 0
+        self.report_id = 0
+
+    def reset_locals(self):
+        self.usages = []
+        self.usage_min = None
+        self.usage_max = None
+
+    def emit(self, data, comment):
+        if self.map is None:
+            raise CompileError("item outside of a map")
+        if not self.map.chunks or self.map.chunks[-1][0] != self.cond:
+            self.map.chunks.append((self.cond, []))
+        self.map.chunks[-1][1].append((data, comment))
+
+    def directive(self, line):
+        words = line.split()
+        if words[0] == "%if" and len(words) == 2:
+            if self.cond is not None:
+                raise CompileError("nested %if is not supported")
+            self.cond = words[1]
+        elif words[0] == "%endif" and len(words) == 1:
+            if self.cond is None:
+                raise CompileError("%endif without %if")
+            self.cond = None
+        elif words[0] == "%include" and len(words) == 2:
+            self.includes.append(words[1])
+        else:
+            raise CompileError("unknown directive '%s'" % line)
+
+    def report_name(self, name):
+        key = (self.map.name, self.report_id)
+        if key not in self.report_names:
+            if self.report_id == 0:
+                self.report_names[key] = self.map.name
+            else:
+                raise CompileError("report %d has no name" % self.report_id)
+        return self.report_names[key]
+
+    def main_item(self, tag, flags, name, text):
+        kind_key = (self.map.name, self.report_id, tag)
+        report = self.reports.get(kind_key)
+        if report is None:
+            report = Report(self.map.name, self.report_id, tag,
+                            self.report_name(name), self.cond)
+            self.reports[kind_key] = report
+            self.report_order.append(report)
+        elif report.cond != self.cond:
+            raise CompileError("report %s spans %%if blocks" % report.name)
+
+        usage_range = None
+        if self.usage_min is not None or self.usage_max is not None:
+            if self.usage_min is None or self.usage_max is None:
+                raise CompileError("Usage Minimum/Maximum must come in pairs")
+            usage_range = (self.usage_min, self.usage_max)
+        field = Field(name, report.bits, self.report_size, self.report_count,
+                      flags, self.logical_min, self.logical_max,
+                      list(self.usages), usage_range)
+        if field.constant:
+            if name:
+                raise CompileError("constant field cannot be named: %s" % text)
+        elif not name:
+            raise CompileError("data field needs a name: %s" % text)
+        elif any(f.name == name for f in report.fields):
+            raise CompileError("duplicate field %s in %s" % (name, report.name))
+        if not field.constant and field.size > 32:
+            raise CompileError("field %s wider than 32 bits" % name)
+        report.fields.append(field)
+        report.bits += self.report_size * self.report_count
+
+    def item(self, item, arg, name, text):
+        if item in MAIN_ITEMS:
+            tag = MAIN_ITEMS[item]
+            flags = parse_main_flags(arg)
+            code, data = encode_data(flags, False)
+            self.emit([tag | code] + data, text)
+            self.main_item(tag, flags, name, text)
+            self.reset_locals()
+        elif item == "Collection":
+            value = COLLECTION_TYPES.get(arg.strip()) if arg else None
+            if value is None:
+                value = parse_number(arg)
+            code, data = encode_data(value, False)
+            self.emit([COLLECTION | code] + data, text)
+            self.depth += 1
+            self.reset_locals()
+        elif item == "End Collection":
+            if self.depth == 0:
+                raise CompileError("End Collection without Collection")
+            self.emit([END_COLLECTION], text)
+            self.depth -= 1
+        elif item in GLOBAL_ITEMS or item in LOCAL_ITEMS:
+            tag = GLOBAL_ITEMS.get(item, LOCAL_ITEMS.get(item))
+            value = parse_number(arg)
+            code, data = encode_data(value, item in SIGNED_ITEMS)
+            self.emit([tag | code] + data, text)
+            if item == "Usage Page":
+                self.usage_page = value
+            elif item == "Logical Minimum":
+                self.logical_min = value
+            elif item == "Logical Maximum":
+                self.logical_max = value
+            elif item == "Report Size":
+                self.report_size = value
+            elif item == "Report Count":
+                self.report_count = value
+            elif item == "Report ID":
+                if not 1 <= value <= 255:
+                    raise CompileError("Report ID must be 1..255")
+                if not name:
+                    raise CompileError("Report ID needs a report name")
+                self.report_id = value
+                self.report_names[(self.map.name, value)] = name
+            elif item == "Usage":
+                self.usages.append(value)
+            elif item == "Usage Minimum":
+                self.usage_min = value
+            elif item == "Usage Maximum":
+                self.usage_max = value
+            if name and item != "Report ID":
+                raise CompileError("only Report ID and main items take a name")
+        else:
+            raise CompileError("unknown item '%s'" % item)
+
+    def compile(self, lines):
+        for lineno, raw in enumerate(lines, 1):
+            text = raw.split("#", 1)[0].strip()
+            if not text:
+                continue
+            try:
+                if text.startswith("%"):
+                    self.directive(text)
+                elif text.startswith("map "):
+                    if self.depth or self.cond is not None:
+                        raise CompileError("map inside a collection or %if")
+                    self.map = ReportMap(text.split()[1])
+                    self.maps.append(self.map)
+                    self.reset_globals()
+                else:
+                    self.item(*split_item(text), text)
+            except (CompileError, ValueError) as err:
+                raise CompileError("line %d: %s" % (lineno, err))
+        if self.cond is not None:
+            raise CompileError("missing %endif")
+        if self.depth:
+            raise CompileError("missing End Collection")
+        for report in self.report_order:
+            if report.bits % 8:
+                raise CompileError("report %s is %d bits, not byte aligned"
+                                   % (report.ident, report.bits))
+
+
+def c_type(field):
+    """Member type for one element of a field."""
+    if field.bitmask:
+        for bits in (8, 16, 32, 64):
+            if field.count <= bits:
+                return "uint%d_t" % bits
+        return "uint8_t"
+    bits = next(b for b in (8, 16, 32) if field.size <= b)
+    return ("int%d_t" if field.logical_min < 0 else "uint%d_t") % bits
+
+
+def c_member(field):
+    if field.bitmask:
+        if field.count > 64:
+            return "uint8_t %s[%d]" % (field.name, (field.count + 7) // 8)
+        return "%s %s" % (c_type(field), field.name)
+    if field.count > 1:
+        return "%s %s[%d]" % (c_type(field), field.name, field.count)
+    return "%s %s" % (c_type(field), field.name)
+
+
+def pack_lines(field):
+    """Statements writing one field into zeroed buffer `out`."""
+    lines = []
+    name = "r->" + field.name
+    if field.bitmask:
+        nbytes = (field.count + 7) // 8
+        if field.offset % 8 == 0 and field.count % 8 == 0:
+            start = field.offset // 8
+            if field.count > 64:
+                lines.append("memcpy(&out[%d], %s, %d);" % (start, name, nbytes))
+            else:
+                for i in range(nbytes):
+                    shift = " >> %d" % (8 * i) if i else ""
+                    lines.append("out[%d] = (uint8_t)(%s%s);"
+                                 % (start + i, name, shift))
+        elif field.count <= 32:
+            lines.append("hid_pack_bits(out, %d, %d, %s);"
+                         % (field.offset, field.count, name))
+        else:
+            raise CompileError("unaligned bitmask %s wider than 32 bits"
+                               % field.name)
+        return lines
+
+    for i in range(field.count):
+        value = name + ("[%d]" % i if field.count > 1 else "")
+        bit = field.offset + i * field.size
+        if field.size == 8 and bit % 8 == 0:
+            lines.append("out[%d] = (uint8_t)%s;" % (bit // 8, value))
+        elif field.size == 16 and bit % 8 == 0:
+            lines.append("out[%d] = (uint8_t)%s;" % (bit // 8, value))
+            lines.append("out[%d] = (uint8_t)((uint16_t)%s >> 8);"
+                         % (bit // 8 + 1, value))
+        else:
+            lines.append("hid_pack_bits(out, %d, %d, (uint32_t)%s);"
+                         % (bit, field.size, value))
+    return lines
+
+
+def unpack_lines(field):
+    lines = []
+    name = "r->" + field.name
+    if field.bitmask:
+        if field.count > 64:
+            if field.offset % 8 or field.count % 8:
+                raise CompileError("unaligned bitmask %s" % field.name)
+            lines.append("memcpy(%s, &in[%d], %d);"
+                         % (name, field.offset // 8, field.count // 8))
+        else:
+            lines.append("%s = (%s)hid_unpack_bits(in, %d, %d);"
+                         % (name, c_type(field), field.offset, field.count))
+        return lines
+    for i in range(field.count):
+        value = name + ("[%d]" % i if field.count > 1 else "")
+        bit = field.offset + i * field.size
+        if field.logical_min < 0 and field.size < 32:
+            lines.append("%s = (%s)hid_sign_extend(hid_unpack_bits(in, %d, %d), %d);"
+                         % (value, c_type(field), bit, field.size, field.size))
+        else:
+            lines.append("%s = (%s)hid_unpack_bits(in, %d, %d);"
+                         % (value, c_type(field), bit, field.size))
+    return lines
+
+
+def usage_list(field):
+    """(value, usage) pairs: bit index for variable fields, array value otherwise."""
+    if field.usages:
+        usages = field.usages
+    elif field.usage_range:
+        return None
+    else:
+        return []
+    first = 0 if field.variable else field.logical_min
+    return [(first + i, u) for i, u in enumerate(usages)]
+
+
+HELPERS = """\
+// 按位写入/读取字段，低位在前；out 需预先清零
+static inline void hid_pack_bits(uint8_t *out, uint32_t bit, uint32_t size,
+                                 uint32_t value) {
+  uint64_t v = (uint64_t)(value & (uint32_t)((1ull << size) - 1)) << (bit & 7);
+  for (uint8_t *p = out + (bit >> 3); v; v >>= 8) {
+    *p++ |= (uint8_t)v;
+  }
+}
+
+static inline uint32_t hid_unpack_bits(const uint8_t *in, uint32_t bit,
+                                       uint32_t size) {
+  uint64_t v = 0;
+  uint32_t nbytes = ((bit & 7) + size + 7) / 8;
+  for (uint32_t i = 0; i < nbytes; i++) {
+    v |= (uint64_t)in[(bit >> 3) + i] << (8 * i);
+  }
+  return (uint32_t)((v >> (bit & 7)) & ((1ull << size) - 1));
+}
+
+static inline int32_t hid_sign_extend(uint32_t value, uint32_t size) {
+  uint32_t sign = 1u << (size - 1);
+  return (int32_t)((value ^ sign) - sign);
+}
+
+// 字段布局：位偏移、每个元素的位宽、元素个数、Input/Output/Feature 标志
+typedef struct {
+  const char *name;  // 常量字段为 NULL
+  uint16_t offset;
+  uint8_t size;
+  uint16_t count;
+  uint16_t flags;
+} hid_field_layout_t;
+
+typedef struct {
+  uint8_t report_id;
+  uint8_t kind;  // 0x80 Input, 0x90 Output, 0xB0 Feature
+  uint16_t len;  // 字节数，不含报告 ID
+  const hid_field_layout_t *fields;
+  uint8_t num_fields;
+} hid_report_layout_t;
+"""
+
+
+def upper(name):
+    return name.upper()
+
+
+def map_length_expr(report_map):
+    base = 0
+    conds = []
+    for cond, items in report_map.chunks:
+        size = sum(len(data) for data, _ in items)
+        if cond is None:
+            base += size
+        else:
+            conds.append("(%s ? %d : 0)" % (cond, size))
+    return "(%s)" % " + ".join([str(base)] + conds) if conds else str(base)
+
+
+def generate_header(compiler, guard, source):
+    out = []
+    w = out.append
+    w("// Generated by tools/hid_desc_compile.py from %s, do not edit." % source)
+    w("#ifndef %s" % guard)
+    w("#define %s" % guard)
+    w("")
+    w("#include <stdint.h>")
+    w("#include <string.h>")
+    w("")
+    w(HELPERS)
+    for report_map in compiler.maps:
+        w("// 报告描述符: %s" % report_map.name)
+        w("#define HID_%s_REPORT_MAP_LEN %s"
+          % (upper(report_map.name), map_length_expr(report_map)))
+        w("extern const uint8_t hid_%s_report_map[];" % report_map.name)
+        w("")
+
+    ids_done = set()
+    for report in compiler.report_order:
+        R = upper(report.ident)
+        if (report.map_name, report.report_id) not in ids_done:
+            ids_done.add((report.map_name, report.report_id))
+            w("#define HID_RPT_ID_%s %d" % (upper(report.name), report.report_id))
+        w("#define HID_%s_LEN %d" % (R, report.bits // 8))
+        for field in report.fields:
+            if field.constant:
+                continue
+            F = "HID_%s_%s" % (R, upper(field.name))
+            w("#define %s_OFFSET %d" % (F, field.offset))
+            w("#define %s_SIZE %d" % (F, field.size))
+            w("#define %s_COUNT %d" % (F, field.count))
+            usages = usage_list(field)
+            if usages is None:
+                w("#define %s_USAGE_MIN 0x%02X" % (F, field.usage_range[0]))
+                w("#define %s_USAGE_MAX 0x%02X" % (F, field.usage_range[1]))
+            elif usages:
+                items = " ".join("X(%d, 0x%02X)" % pair for pair in usages)
+                w("#define %s_USAGES(X) %s" % (F, items))
+        w("extern const hid_report_layout_t hid_%s_layout;" % report.ident)
+        w("")
+        w("typedef struct {")
+        for field in report.fields:
+            if not field.constant:
+                w("  %s;" % c_member(field))
+        w("} hid_%s_t;" % report.ident)
+        w("")
+        if report.kind == 0x80:
+            w("static inline void hid_%s_pack(const hid_%s_t *r, uint8_t *out) {"
+              % (report.ident, report.ident))
+            w("  memset(out, 0, HID_%s_LEN);" % R)
+            for field in report.fields:
+                if not field.constant:
+                    for line in pack_lines(field):
+                        w("  " + line)
+        else:
+            w("static inline void hid_%s_unpack(const uint8_t *in, hid_%s_t *r) {"
+              % (report.ident, report.ident))
+            for field in report.fields:
+                if not field.constant:
+                    for line in unpack_lines(field):
+                        w("  " + line)
+        w("}")
+        w("")
+    w("#endif /* %s */" % guard)
+    return "\n".join(out) + "\n"
+
+
+def generate_source(compiler, header, source):
+    out = []
+    w = out.append
+    w("// Generated by tools/hid_desc_compile.py from %s, do not edit." % source)
+    w('#include "%s"' % header)
+    w("")
+    for include in compiler.includes:
+        w("#include %s" % include)
+    if compiler.includes:
+        w("")
+    for report_map in compiler.maps:
+        w("const uint8_t hid_%s_report_map[] = {" % report_map.name)
+        for cond, items in report_map.chunks:
+            if cond is not None:
+                w("#if %s" % cond)
+            for data, comment in items:
+                text = ", ".join("0x%02X" % b for b in data) + ","
+                w("    %-24s// %s" % (text, comment))
+            if cond is not None:
+                w("#endif")
+        w("};")
+        w("_Static_assert(sizeof(hid_%s_report_map) == HID_%s_REPORT_MAP_LEN,"
+          % (report_map.name, upper(report_map.name)))
+        w('               "report map length mismatch");')
+        w("")
+    for report in compiler.report_order:
+        w("static const hid_field_layout_t %s_fields[] = {" % report.ident)
+        for field in report.fields:
+            name = '"%s"' % field.name if field.name else "NULL"
+            w("    {%s, %d, %d, %d, 0x%02X}," % (name, field.offset, field.size,
+                                              field.count, field.flags))
+        w("};")
+        w("const hid_report_layout_t hid_%s_layout = {" % report.ident)
+        w("    %d, 0x%02X, HID_%s_LEN, %s_fields," % (
+            report.report_id, report.kind, upper(report.ident), report.ident))
+        w("    sizeof(%s_fields) / sizeof(%s_fields[0])," % (report.ident,
+                                                           report.ident))
+        w("};")
+        w("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="descriptor source (.hid)")
+    parser.add_argument("-o", "--output-dir", default=".",
+                        help="directory for the generated .c/.h")
+    parser.add_argument("-n", "--name",
+                        help="base name of the outputs (default: source name)")
+    args = parser.parse_args()
+
+    base = args.name or os.path.splitext(os.path.basename(args.source))[0]
+    compiler = Compiler()
+    try:
+        with open(args.source, encoding="utf-8") as f:
+            compiler.compile(f)
+    except CompileError as err:
+        sys.exit("%s: %s" % (args.source, err))
+
+    header = base + ".h"
+    source = os.path.basename(args.source)
+    guard = re.sub(r"\W", "_", header).upper()
+    outputs = {
+        header: generate_header(compiler, guard, source),
+        base + ".c": generate_source(compiler, header, source),
+    }
+    os.makedirs(args.output_dir, exist_ok=True)
+    for name, text in outputs.items():
+        path = os.path.join(args.output_dir, name)
+        with open(path, "w", encoding="utf-8") as f:
+            f.write(text)
+
+
+if __name__ == "__main__":
+    main()
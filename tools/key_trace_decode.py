@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Decode the key-path binary trace printed by key_trace_dump().
+
+Reads a serial log (file argument or stdin), picks out the "KT:<hex>" lines
+and prints one decoded record per line, optionally as CSV.
+
+    python tools/key_trace_decode.py monitor.log
+    pio device monitor | python tools/key_trace_decode.py --csv
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+# Must match key_trace_id_t in src/key_trace.h
+EVENT_NAMES = {
+    1: "SCAN_DOWN",
+    2: "SCAN_UP",
+    3: "QUEUE_DROP",
+    4: "HID_DOWN",
+    5: "HID_UP",
+    6: "REPORT_SEND",
+    7: "REPORT_DEFER",
+    8: "CC_SEND",
+    9: "TX_BUSY",
+    10: "TX_LOST",
+    11: "TX_CONGEST",
+}
+
+ENTRY = struct.Struct("<IBBBBi")
+LINE_RE = re.compile(r"KT:([0-9a-fA-F]{%d})" % (ENTRY.size * 2))
+
+
+def decode(lines):
+    for line in lines:
+        match = LINE_RE.search(line)
+        if match:
+            yield ENTRY.unpack(bytes.fromhex(match.group(1)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin)
+    parser.add_argument("--csv", action="store_true", help="emit CSV instead of a table")
+    args = parser.parse_args()
+
+    if args.csv:
+        print("timestamp_us,delta_us,event,row,col,keycode,err")
+
+    previous = None
+    for timestamp, event_id, row, col, keycode, err in decode(args.log):
+        # timestamps are the low 32 bits of esp_timer_get_time()
+        delta = 0 if previous is None else (timestamp - previous) & 0xFFFFFFFF
+        previous = timestamp
+        name = EVENT_NAMES.get(event_id, "UNKNOWN_%d" % event_id)
+        row_s = "" if row == 0xFF else str(row)
+        col_s = "" if col == 0xFF else str(col)
+        if args.csv:
+            print("%d,%d,%s,%s,%s,0x%02x,%d" % (timestamp, delta, name, row_s, col_s, keycode, err))
+        else:
+            print("%10d +%8d  %-13s row=%-2s col=%-2s key=0x%02x err=%d"
+                  % (timestamp, delta, name, row_s, col_s, keycode, err))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,321 @@
+#!/usr/bin/env python3
+"""Compile a text keymap into the binary blob loaded by src/keymap.c.
+
+The keymap lists one block per layer, one line per matrix row:
+
+    layer 0
+      UP    RIGHT  C
+      LEFT  E      F
+      DOWN  H      MO(1)
+
+    layer 1
+      ___   ___    C(C)       # Ctrl+C
+      ___   ___    C(V)
+      TG(1) ___    ___
+
+    combo 0,0 0,1 -> ESC      # both keys within the combo window
+    macro hello: S(H) E L L O
+
+Key names are HID keyboard usages (A, 1, ENTER, F5, LCTRL, ...) or raw hex
+(0x2C). C(), S(), A() and G() add left Ctrl/Shift/Alt/GUI to a key and can
+be nested; a bare modifier name such as LSHIFT is a key of its own. MO(n)
+enables layer n while held, TG(n) toggles it. MT(mods, key) taps the key
+and holds the modifiers (mods is any of the letters C, S, A, G), LT(n, key)
+taps the key and holds layer n. M(name) plays a macro; each macro step is a
+key, optionally wrapped in modifiers, that is pressed and released.
+PROFILE(n) switches to host profile n; REPAIR(n) switches to it and forgets
+its host so a new one can pair. Both are usually bound to a combo. ___ is
+transparent (use the next active layer below), NO does nothing.
+
+    python tools/keymap_compile.py keymap.txt -o keymap.bin
+    python tools/keymap_compile.py keymap.txt -o keymap.bin --csv keymap.csv
+
+The CSV is input for ESP-IDF's nvs_partition_gen.py; the blob can also be
+written at runtime with keymap_store().
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+# Must match src/keymap.h
+BLOB_MAGIC = 0x50414D4B
+BLOB_VERSION = 2
+MAX_LAYERS = 8
+MAX_COMBOS = 16
+MAX_MACROS = 16
+MAX_MACRO_STEPS = 128
+NVS_NAMESPACE = "keymap"
+NVS_KEY = "layers"
+
+KIND_KEY = 0x0
+KIND_MO = 0x1
+KIND_TG = 0x2
+KIND_MT = 0x3
+KIND_LT = 0x4
+KIND_MACRO = 0x5
+KIND_PROFILE = 0x6
+
+# HOST_PROFILE_MAX in src/host_profile.h
+MAX_PROFILES = 3
+
+ACTION_NO = 0x0000
+ACTION_TRANSPARENT = 0x0001
+
+MOD_WRAPPERS = {"C": 0x1, "S": 0x2, "A": 0x4, "G": 0x8}
+
+
+def _keycodes():
+    codes = {}
+    for i, ch in enumerate("ABCDEFGHIJKLMNOPQRSTUVWXYZ"):
+        codes[ch] = 0x04 + i
+    for i, ch in enumerate("1234567890"):
+        codes[ch] = 0x1E + i
+    for i in range(12):
+        codes["F%d" % (i + 1)] = 0x3A + i
+    codes.update({
+        "ENTER": 0x28, "ESC": 0x29, "BSPC": 0x2A, "TAB": 0x2B, "SPACE": 0x2C,
+        "MINUS": 0x2D, "EQUAL": 0x2E, "LBRC": 0x2F, "RBRC": 0x30, "BSLS": 0x31,
+        "SCLN": 0x33, "QUOT": 0x34, "GRV": 0x35, "COMM": 0x36, "DOT": 0x37,
+        "SLSH": 0x38, "CAPS": 0x39, "PSCR": 0x46, "SCRL": 0x47, "PAUS": 0x48,
+        "INS": 0x49, "HOME": 0x4A, "PGUP": 0x4B, "DEL": 0x4C, "END": 0x4D,
+        "PGDN": 0x4E, "RIGHT": 0x4F, "LEFT": 0x50, "DOWN": 0x51, "UP": 0x52,
+        "APP": 0x65,
+        "LCTRL": 0xE0, "LSHIFT": 0xE1, "LALT": 0xE2, "LGUI": 0xE3,
+        "RCTRL": 0xE4, "RSHIFT": 0xE5, "RALT": 0xE6, "RGUI": 0xE7,
+    })
+    return codes
+
+
+KEYCODES = _keycodes()
+CALL_RE = re.compile(r"^([A-Z]+)\((.*)\)$")
+COMBO_RE = re.compile(r"^(\d+),(\d+)$")
+
+
+class KeymapError(Exception):
+    pass
+
+
+def tokenize(text):
+    """Split on whitespace outside parentheses, so MT(C, ESC) is one token."""
+    tokens, current, depth = [], "", 0
+    for ch in text:
+        if ch.isspace() and depth == 0:
+            if current:
+                tokens.append(current)
+            current = ""
+            continue
+        depth += {"(": 1, ")": -1}.get(ch, 0)
+        if depth < 0:
+            raise KeymapError("unbalanced ')'")
+        if not ch.isspace():
+            current += ch
+    if depth:
+        raise KeymapError("unbalanced '('")
+    if current:
+        tokens.append(current)
+    return tokens
+
+
+def parse_key(token, macros):
+    action, _ = parse_action(token, macros)
+    if action >> 12 != KIND_KEY or action == ACTION_TRANSPARENT:
+        raise KeymapError("expected a key, got %r" % token)
+    return action
+
+
+def parse_action(token, macros):
+    """Return (action, referenced layer or None) for one key token."""
+    name = token.upper()
+    if name in ("___", "TRNS"):
+        return ACTION_TRANSPARENT, None
+    if name in ("NO", "XXX"):
+        return ACTION_NO, None
+    if name in KEYCODES:
+        return KEYCODES[name], None
+    if name.startswith("0X"):
+        value = int(name, 16)
+        if not 0x02 <= value <= 0xFF:
+            raise KeymapError("keycode %s out of range" % token)
+        return value, None
+
+    match = CALL_RE.match(name)
+    if not match:
+        raise KeymapError("unknown key %r" % token)
+    func, arg = match.groups()
+    if func == "M":
+        if arg.lower() not in macros:
+            raise KeymapError("unknown macro %r" % arg)
+        return (KIND_MACRO << 12) | macros[arg.lower()], None
+    if func in ("MT", "LT"):
+        hold, _, tap = arg.partition(",")
+        keycode = parse_key(tap, macros)
+        if keycode >> 8:
+            raise KeymapError("%s() tap must be a plain key" % func)
+        if func == "MT":
+            mods = 0
+            for letter in hold:
+                if letter not in MOD_WRAPPERS:
+                    raise KeymapError("unknown modifier %r in MT()" % letter)
+                mods |= MOD_WRAPPERS[letter]
+            return (KIND_MT << 12) | (mods << 8) | keycode, None
+        layer = int(hold, 0)
+        if not 0 <= layer < MAX_LAYERS:
+            raise KeymapError("layer %d out of range" % layer)
+        return (KIND_LT << 12) | (layer << 8) | keycode, layer
+    if func in ("PROFILE", "REPAIR"):
+        index = int(arg, 0)
+        if not 0 <= index < MAX_PROFILES:
+            raise KeymapError("profile %d out of range" % index)
+        forget = 0x100 if func == "REPAIR" else 0
+        return (KIND_PROFILE << 12) | forget | index, None
+    if func in ("MO", "TG"):
+        layer = int(arg, 0)
+        if not 0 <= layer < MAX_LAYERS:
+            raise KeymapError("layer %d out of range" % layer)
+        kind = KIND_MO if func == "MO" else KIND_TG
+        return (kind << 12) | layer, layer
+    if func in MOD_WRAPPERS:
+        return parse_key(arg, macros) | (MOD_WRAPPERS[func] << 8), None
+    raise KeymapError("unknown function %s()" % func)
+
+
+def parse(text, rows, cols):
+    lines = []
+    for lineno, raw in enumerate(text.splitlines(), 1):
+        line = raw.split("#", 1)[0].strip()
+        if line:
+            lines.append((lineno, line))
+
+    # macros may be referenced before they are defined
+    macros = {}
+    for lineno, line in lines:
+        if line.split()[0].lower() == "macro":
+            name = line[len("macro"):].partition(":")[0].strip().lower()
+            if not name or name in macros:
+                raise KeymapError("line %d: bad or duplicate macro name" % lineno)
+            macros[name] = len(macros)
+    if len(macros) > MAX_MACROS:
+        raise KeymapError("more than %d macros" % MAX_MACROS)
+
+    layers = {}
+    combos = []
+    macro_steps = []
+    current = None
+    for lineno, line in lines:
+        try:
+            keyword = line.split()[0].lower()
+            if keyword == "layer":
+                index = int(line.split()[1], 0)
+                if index in layers or not 0 <= index < MAX_LAYERS:
+                    raise KeymapError("bad or duplicate layer %d" % index)
+                current = layers[index] = []
+                continue
+            if keyword == "combo":
+                keys, arrow, action = line[len("combo"):].partition("->")
+                if not arrow:
+                    raise KeymapError("expected 'combo row,col ... -> action'")
+                mask = 0
+                for pos in keys.split():
+                    match = COMBO_RE.match(pos)
+                    if not match:
+                        raise KeymapError("bad key position %r" % pos)
+                    row, col = int(match.group(1)), int(match.group(2))
+                    if row >= rows or col >= cols:
+                        raise KeymapError("key position %s outside the matrix" % pos)
+                    mask |= 1 << (row * cols + col)
+                if bin(mask).count("1") < 2:
+                    raise KeymapError("a combo needs at least two keys")
+                tokens = tokenize(action)
+                if len(tokens) != 1:
+                    raise KeymapError("a combo has exactly one action")
+                value, ref = parse_action(tokens[0], macros)
+                if value >> 12 in (KIND_MT, KIND_LT) or value == ACTION_TRANSPARENT:
+                    raise KeymapError("combo action cannot be MT, LT or ___")
+                combos.append((mask, value, ref))
+                continue
+            if keyword == "macro":
+                steps = tokenize(line.partition(":")[2])
+                if not steps:
+                    raise KeymapError("empty macro")
+                macro_steps.append([parse_key(step, macros) for step in steps])
+                continue
+            if current is None:
+                raise KeymapError("key row before the first 'layer'")
+            words = tokenize(line)
+            if len(words) != cols:
+                raise KeymapError("expected %d keys, got %d" % (cols, len(words)))
+            if len(current) == rows:
+                raise KeymapError("more than %d rows" % rows)
+            current.append([parse_action(word, macros) for word in words])
+        except (KeymapError, ValueError, IndexError) as e:
+            raise KeymapError("line %d: %s" % (lineno, e))
+
+    if not layers:
+        raise KeymapError("no layers defined")
+    count = max(layers) + 1
+    if sorted(layers) != list(range(count)):
+        raise KeymapError("layers must be numbered 0..%d without gaps" % (count - 1))
+    if len(combos) > MAX_COMBOS:
+        raise KeymapError("more than %d combos" % MAX_COMBOS)
+    if sum(len(steps) for steps in macro_steps) > MAX_MACRO_STEPS:
+        raise KeymapError("macros have more than %d steps in total" % MAX_MACRO_STEPS)
+    if any(len(steps) > 255 for steps in macro_steps):
+        raise KeymapError("a macro has more than 255 steps")
+    for mask, value, ref in combos:
+        if ref is not None and ref >= count:
+            raise KeymapError("combo references missing layer %d" % ref)
+    actions = []
+    for index in range(count):
+        if len(layers[index]) != rows:
+            raise KeymapError("layer %d has %d rows, expected %d"
+                              % (index, len(layers[index]), rows))
+        for row in layers[index]:
+            for action, ref in row:
+                if ref is not None and ref >= count:
+                    raise KeymapError("layer %d references missing layer %d" % (index, ref))
+                actions.append(action)
+    return count, actions, [(mask, value) for mask, value, _ in combos], macro_steps
+
+
+def build_blob(rows, cols, count, actions, combos, macros):
+    blob = struct.pack("<IBBBB", BLOB_MAGIC, BLOB_VERSION, rows, cols, count)
+    blob += struct.pack("<%dH" % len(actions), *actions)
+    blob += struct.pack("<BB", len(combos), len(macros))
+    for mask, action in combos:
+        blob += struct.pack("<HH", mask, action)
+    for steps in macros:
+        blob += struct.pack("<B%dH" % len(steps), len(steps), *steps)
+    return blob
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("keymap", type=argparse.FileType("r"))
+    parser.add_argument("-o", "--output", required=True, help="binary blob to write")
+    parser.add_argument("--csv", help="also write an nvs_partition_gen.py CSV")
+    parser.add_argument("--rows", type=int, default=3, help="matrix rows (ROW_NUM)")
+    parser.add_argument("--cols", type=int, default=3, help="matrix columns (COL_NUM)")
+    args = parser.parse_args()
+
+    try:
+        count, actions, combos, macros = parse(args.keymap.read(), args.rows, args.cols)
+    except KeymapError as e:
+        sys.exit("%s: %s" % (args.keymap.name, e))
+
+    blob = build_blob(args.rows, args.cols, count, actions, combos, macros)
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write("key,type,encoding,value\n")
+            f.write("%s,namespace,,\n" % NVS_NAMESPACE)
+            f.write("%s,file,binary,%s\n" % (NVS_KEY, os.path.abspath(args.output)))
+    print("%s: %d layers, %d combos, %d macros, %d bytes"
+          % (args.output, count, len(combos), len(macros), len(blob)))
+
+
+if __name__ == "__main__":
+    main()